@@ -0,0 +1,1104 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Benchmark/TrickyGameplayObjectsBenchmark.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+#include "TrickyGameplayObjectsBenchmarkListener.h"
+#include "TrickyGameplayObjectsBenchmarkPickup.h"
+#include "Algo/Count.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Components/SphereComponent.h"
+#include "Math/RandomStream.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectHash.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+#include "LockKey/KeyringComponent.h"
+#include "LockKey/LockKeyType.h"
+#include "Pickup/PickupAutomaticBase.h"
+#include "StateController/NativeInterfaceDispatch.h"
+#include "StateController/StateController.h"
+#include "StateController/StateControllerSnapshotSubsystem.h"
+#include "StateController/StateControllerSpatialIndex.h"
+
+namespace TrickyGameplayObjectsBenchmark
+{
+	/** Distance between spawned pickups, so their activation triggers never overlap each other. */
+	constexpr float PickupSpacing = 200.f;
+
+	/** Distance between the chests spawned for the spatial index queries. */
+	constexpr float SpatialIndexSpacing = 500.f;
+
+	constexpr int32 NumSpatialQueries = 1000;
+
+	constexpr float SpatialQueryRadius = 1500.f;
+
+	/** States of a door without the component, so only the state machine cores are measured. */
+	struct FDoorStates
+	{
+		EDoorState CurrentState = EDoorState::Closed;
+
+		EDoorState TargetState = EDoorState::Closed;
+
+		EDoorState LastState = EDoorState::Closed;
+	};
+
+	/**
+	 * Copy of the door state change from before the shared TStateController core, which validated the change with
+	 * branches. Its log messages are left out, since the core doesn't format any and only the validation is compared.
+	 */
+	FORCENOINLINE bool LegacyChangeDoorState(FDoorStates& States,
+	                                         const EDoorState NewState,
+	                                         const bool bTransitImmediately)
+	{
+		if (NewState == States.CurrentState)
+		{
+			return false;
+		}
+
+		if (NewState == EDoorState::Transition)
+		{
+			return false;
+		}
+
+		States.TargetState = NewState;
+		States.LastState = States.CurrentState;
+
+		if (bTransitImmediately)
+		{
+			States.CurrentState = States.TargetState;
+		}
+		else
+		{
+			States.CurrentState = EDoorState::Transition;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Calls the interface functions the benchmark needs for every controller type.
+	 * Start and Reset change the controller between two states which are always allowed.
+	 */
+	template <typename ComponentType>
+	struct TControllerOps;
+
+	template <>
+	struct TControllerOps<UDoorStateControllerComponent>
+	{
+		static const TCHAR* GetName() { return TEXT("Door"); }
+
+		static bool Start(UDoorStateControllerComponent* Door, const bool bTransitImmediately)
+		{
+			return IDoorInterface::Execute_OpenDoor(Door, bTransitImmediately);
+		}
+
+		static bool Reset(UDoorStateControllerComponent* Door, const bool bTransitImmediately)
+		{
+			return IDoorInterface::Execute_CloseDoor(Door, bTransitImmediately);
+		}
+
+		static bool Reverse(UDoorStateControllerComponent* Door)
+		{
+			return IDoorInterface::Execute_ReverseDoorStateTransition(Door);
+		}
+
+		static bool Finish(UDoorStateControllerComponent* Door)
+		{
+			return IDoorInterface::Execute_FinishDoorStateTransition(Door);
+		}
+	};
+
+	template <>
+	struct TControllerOps<UChestStateControllerComponent>
+	{
+		static const TCHAR* GetName() { return TEXT("Chest"); }
+
+		static bool Start(UChestStateControllerComponent* Chest, const bool bTransitImmediately)
+		{
+			return IChestInterface::Execute_OpenChest(Chest, bTransitImmediately);
+		}
+
+		static bool Reset(UChestStateControllerComponent* Chest, const bool bTransitImmediately)
+		{
+			return IChestInterface::Execute_CloseChest(Chest, bTransitImmediately);
+		}
+
+		static bool Reverse(UChestStateControllerComponent* Chest)
+		{
+			return IChestInterface::Execute_ReverseChestStateTransition(Chest);
+		}
+
+		static bool Finish(UChestStateControllerComponent* Chest)
+		{
+			return IChestInterface::Execute_FinishChestStateTransition(Chest);
+		}
+	};
+
+	template <>
+	struct TControllerOps<ULockStateControllerComponent>
+	{
+		static const TCHAR* GetName() { return TEXT("Lock"); }
+
+		static bool Start(ULockStateControllerComponent* Lock, const bool bTransitImmediately)
+		{
+			return ILockInterface::Execute_ForceLockState(Lock, ELockState::Unlocked, bTransitImmediately);
+		}
+
+		static bool Reset(ULockStateControllerComponent* Lock, const bool bTransitImmediately)
+		{
+			return ILockInterface::Execute_ForceLockState(Lock, ELockState::Locked, bTransitImmediately);
+		}
+
+		static bool Reverse(ULockStateControllerComponent* Lock)
+		{
+			return ILockInterface::Execute_ReverseLockStateTransition(Lock);
+		}
+
+		static bool Finish(ULockStateControllerComponent* Lock)
+		{
+			return ILockInterface::Execute_FinishLockStateTransition(Lock);
+		}
+	};
+
+	template <>
+	struct TControllerOps<UButtonStateControllerComponent>
+	{
+		static const TCHAR* GetName() { return TEXT("Button"); }
+
+		static bool Start(UButtonStateControllerComponent* Button, const bool bTransitImmediately)
+		{
+			return IButtonInterface::Execute_PressButton(Button, bTransitImmediately);
+		}
+
+		static bool Reset(UButtonStateControllerComponent* Button, const bool bTransitImmediately)
+		{
+			return IButtonInterface::Execute_ReleaseButton(Button, bTransitImmediately);
+		}
+
+		static bool Reverse(UButtonStateControllerComponent* Button)
+		{
+			return IButtonInterface::Execute_ReverseButtonStateTransition(Button);
+		}
+
+		static bool Finish(UButtonStateControllerComponent* Button)
+		{
+			return IButtonInterface::Execute_FinishButtonStateTransition(Button);
+		}
+	};
+
+	template <>
+	struct TControllerOps<UGameplayObjectStateControllerComponent>
+	{
+		static const TCHAR* GetName() { return TEXT("GameplayObject"); }
+
+		static bool Start(UGameplayObjectStateControllerComponent* GameplayObject, const bool bTransitImmediately)
+		{
+			return IGameplayObjectInterface::Execute_DeactivateGameplayObject(GameplayObject, bTransitImmediately);
+		}
+
+		static bool Reset(UGameplayObjectStateControllerComponent* GameplayObject, const bool bTransitImmediately)
+		{
+			return IGameplayObjectInterface::Execute_ActivateGameplayObject(GameplayObject, bTransitImmediately);
+		}
+
+		static bool Reverse(UGameplayObjectStateControllerComponent* GameplayObject)
+		{
+			return IGameplayObjectInterface::Execute_ReverseGameplayObjectStateTransition(GameplayObject);
+		}
+
+		static bool Finish(UGameplayObjectStateControllerComponent* GameplayObject)
+		{
+			return IGameplayObjectInterface::Execute_FinishGameplayObjetStateTransition(GameplayObject);
+		}
+	};
+
+	/**
+	 * Forwards all the calls to the wrapped allocator and counts the Malloc and Realloc calls of the game thread.
+	 * Other threads are ignored, so their work doesn't add noise to the measured game thread code.
+	 * Installed as GMalloc only while the benchmark runs. It's never deleted, because other threads can still be
+	 * inside its calls after it's uninstalled.
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		/**
+		 * @return False if it's already installed.
+		 */
+		bool Install()
+		{
+			if (GMalloc == this)
+			{
+				return false;
+			}
+
+			Inner = GMalloc;
+			CountedThreadId = FPlatformTLS::GetCurrentThreadId();
+			GMalloc = this;
+			return true;
+		}
+
+		void Uninstall()
+		{
+			if (GMalloc == this)
+			{
+				GMalloc = Inner;
+			}
+		}
+
+		uint64 GetNumAllocations() const { return NumAllocations.load(std::memory_order_relaxed); }
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+		FMalloc* Inner = nullptr;
+
+		uint32 CountedThreadId = 0;
+
+		std::atomic<uint64> NumAllocations = 0;
+
+		void CountAllocation()
+		{
+			if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId)
+			{
+				NumAllocations.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	FCountingMalloc& GetCountingMalloc()
+	{
+		// Intentionally leaked, see FCountingMalloc.
+		static FCountingMalloc* CountingMalloc = new FCountingMalloc();
+		return *CountingMalloc;
+	}
+
+	class FBenchmarkRunner
+	{
+	public:
+		FBenchmarkRunner(UWorld* InWorld,
+		                 const int32 InNumObjects,
+		                 TArray<FTrickyGameplayObjectsBenchmarkResult>& InResults)
+			: World(InWorld),
+			  NumObjects(InNumObjects),
+			  Results(InResults)
+		{
+		}
+
+		void Run()
+		{
+			LockKeys.Add(ULockKeyType::StaticClass());
+			GetDerivedClasses(ULockKeyType::StaticClass(), LockKeys);
+			LockKeys.RemoveAll([](const UClass* LockKey)
+			{
+				return LockKey->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists)
+					|| LockKey->GetName().StartsWith(TEXT("SKEL_"));
+			});
+
+			BenchmarkStateChangeCores();
+			const TArray<UDoorStateControllerComponent*> Doors = BenchmarkControllers<UDoorStateControllerComponent>();
+			BenchmarkBroadcasts(Doors);
+			BenchmarkInterfaceDispatch(Doors);
+			BenchmarkControllers<UChestStateControllerComponent>();
+			TArray<ULockStateControllerComponent*> Locks = BenchmarkControllers<ULockStateControllerComponent>();
+			BenchmarkControllers<UButtonStateControllerComponent>();
+			BenchmarkControllers<UGameplayObjectStateControllerComponent>();
+
+			BenchmarkSpatialIndex();
+
+			const TArray<UKeyringComponent*> Keyrings = BenchmarkKeyrings();
+			BenchmarkLockAttempts(Locks, Keyrings);
+			BenchmarkPickups();
+
+			Measure(TEXT("Destroy Actors"), SpawnedActors.Num(), SpawnedActors.Num(), [this]
+			{
+				for (AActor* Actor : SpawnedActors)
+				{
+					if (IsValid(Actor))
+					{
+						Actor->Destroy();
+					}
+				}
+			});
+
+			SpawnedActors.Empty();
+
+			BenchmarkSnapshots();
+		}
+
+	private:
+		UWorld* World = nullptr;
+
+		int32 NumObjects = 0;
+
+		TArray<FTrickyGameplayObjectsBenchmarkResult>& Results;
+
+		TArray<AActor*> SpawnedActors;
+
+		TArray<UClass*> LockKeys;
+
+		template <typename FuncType>
+		void Measure(const FString& Name, const int32 NumMeasuredObjects, const int32 NumOperations, FuncType&& Func)
+		{
+			FTrickyGameplayObjectsBenchmark::Measure(Results,
+			                                         Name,
+			                                         NumMeasuredObjects,
+			                                         NumOperations,
+			                                         Forward<FuncType>(Func));
+		}
+
+		template <typename ComponentType>
+		ComponentType* SpawnActorWithComponent()
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+			SpawnedActors.Add(Actor);
+
+			ComponentType* Component = NewObject<ComponentType>(Actor);
+			Actor->AddInstanceComponent(Component);
+			Component->RegisterComponent();
+			return Component;
+		}
+
+		/**
+		 * Compares the state changes of the legacy per-component implementation and the TStateController core.
+		 * Every door starts a transition to Opened, finishes it and closes immediately.
+		 */
+		void BenchmarkStateChangeCores()
+		{
+			TArray<FDoorStates> Doors;
+			Doors.SetNum(NumObjects);
+
+			Measure(TEXT("Legacy Door State Changes"), NumObjects, NumObjects * 3, [&Doors]
+			{
+				for (FDoorStates& Door : Doors)
+				{
+					LegacyChangeDoorState(Door, EDoorState::Opened, false);
+					LegacyChangeDoorState(Door, Door.TargetState, true);
+					LegacyChangeDoorState(Door, EDoorState::Closed, true);
+				}
+			});
+
+			Measure(TEXT("Core Door State Changes"), NumObjects, NumObjects * 3, [&Doors]
+			{
+				using FStateController = TStateController<EDoorState>;
+
+				for (FDoorStates& Door : Doors)
+				{
+					FStateController::ChangeState(Door.CurrentState,
+					                              Door.TargetState,
+					                              Door.LastState,
+					                              EDoorState::Opened,
+					                              false);
+					FStateController::ChangeState(Door.CurrentState,
+					                              Door.TargetState,
+					                              Door.LastState,
+					                              Door.TargetState,
+					                              true);
+					FStateController::ChangeState(Door.CurrentState,
+					                              Door.TargetState,
+					                              Door.LastState,
+					                              EDoorState::Closed,
+					                              true);
+				}
+			});
+		}
+
+		template <typename ComponentType>
+		TArray<ComponentType*> BenchmarkControllers()
+		{
+			using FOps = TControllerOps<ComponentType>;
+			const FString Name = FOps::GetName();
+			TArray<ComponentType*> Controllers;
+			Controllers.Reserve(NumObjects);
+
+			Measure(TEXT("Spawn ") + Name, NumObjects, NumObjects, [this, &Controllers]
+			{
+				for (int32 Index = 0; Index < NumObjects; ++Index)
+				{
+					Controllers.Add(SpawnActorWithComponent<ComponentType>());
+				}
+			});
+
+			Measure(Name + TEXT(" Transitions"), NumObjects, NumObjects * 2, [&Controllers]
+			{
+				for (ComponentType* Controller : Controllers)
+				{
+					FOps::Start(Controller, true);
+					FOps::Reset(Controller, true);
+				}
+			});
+
+			for (ComponentType* Controller : Controllers)
+			{
+				FOps::Start(Controller, false);
+			}
+
+			Measure(Name + TEXT(" Reversals"), NumObjects, NumObjects, [&Controllers]
+			{
+				for (ComponentType* Controller : Controllers)
+				{
+					FOps::Reverse(Controller);
+				}
+			});
+
+			for (ComponentType* Controller : Controllers)
+			{
+				FOps::Finish(Controller);
+			}
+
+			return Controllers;
+		}
+
+		/**
+		 * Measures immediate door state changes with 0, 1 and 8 native or dynamic OnDoorStateChanged listeners.
+		 */
+		void BenchmarkBroadcasts(const TArray<UDoorStateControllerComponent*>& Doors)
+		{
+			using FOps = TControllerOps<UDoorStateControllerComponent>;
+			using FListener = UTrickyGameplayObjectsBenchmarkListener;
+			constexpr int32 MaxNumListeners = 8;
+			TArray<FListener*> Listeners;
+
+			for (int32 Index = 0; Index < MaxNumListeners; ++Index)
+			{
+				Listeners.Add(NewObject<FListener>());
+			}
+
+			const auto MeasureBroadcasts = [this, &Doors](const FString& Name)
+			{
+				Measure(Name, NumObjects, NumObjects * 2, [&Doors]
+				{
+					for (UDoorStateControllerComponent* Door : Doors)
+					{
+						FOps::Start(Door, true);
+						FOps::Reset(Door, true);
+					}
+				});
+			};
+
+			MeasureBroadcasts(TEXT("Door Broadcasts 0 Listeners"));
+
+			for (const int32 NumListeners : {1, MaxNumListeners})
+			{
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					for (int32 Index = 0; Index < NumListeners; ++Index)
+					{
+						Door->OnDoorStateChangedNative.AddUObject(Listeners[Index],
+						                                          &FListener::HandleDoorStateChangedNative);
+					}
+				}
+
+				MeasureBroadcasts(FString::Printf(TEXT("Door Broadcasts %d Native Listeners"), NumListeners));
+
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					Door->OnDoorStateChangedNative.Clear();
+
+					for (int32 Index = 0; Index < NumListeners; ++Index)
+					{
+						Door->OnDoorStateChanged.AddDynamic(Listeners[Index], &FListener::HandleDoorStateChanged);
+					}
+				}
+
+				MeasureBroadcasts(FString::Printf(TEXT("Door Broadcasts %d Dynamic Listeners"), NumListeners));
+
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					Door->OnDoorStateChanged.Clear();
+				}
+			}
+		}
+
+		/**
+		 * Compares immediate door state changes called through the Execute_ thunks and FNativeInterfaceDispatch.
+		 */
+		void BenchmarkInterfaceDispatch(const TArray<UDoorStateControllerComponent*>& Doors)
+		{
+			Measure(TEXT("Door Execute Calls"), NumObjects, NumObjects * 2, [&Doors]
+			{
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					IDoorInterface::Execute_OpenDoor(Door, true);
+					IDoorInterface::Execute_CloseDoor(Door, true);
+				}
+			});
+
+			Measure(TEXT("Door Dispatched Calls"), NumObjects, NumObjects * 2, [&Doors]
+			{
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					if (IDoorInterface* DoorInterface = FNativeInterfaceDispatch::GetNativeInterface<IDoorInterface>(
+						Door, GET_FUNCTION_NAME_CHECKED(IDoorInterface, OpenDoor)))
+					{
+						DoorInterface->OpenDoor_Implementation(true);
+					}
+
+					if (IDoorInterface* DoorInterface = FNativeInterfaceDispatch::GetNativeInterface<IDoorInterface>(
+						Door, GET_FUNCTION_NAME_CHECKED(IDoorInterface, CloseDoor)))
+					{
+						DoorInterface->CloseDoor_Implementation(true);
+					}
+				}
+			});
+		}
+
+		/**
+		 * Measures radius, box and k-nearest queries of Closed chests with 1k, 10k and 100k chests in the index.
+		 * Every other chest is opened, so the state filter rejects half of the candidates.
+		 * The chests are spawned on a grid and destroyed at the end, so they don't affect the other results.
+		 */
+		void BenchmarkSpatialIndex()
+		{
+			const UStateControllerSpatialIndex* SpatialIndex = UStateControllerSpatialIndex::Get(World);
+
+			if (!SpatialIndex)
+			{
+				return;
+			}
+
+			constexpr int32 MaxNumChests = 100000;
+			const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(MaxNumChests)));
+			TArray<AActor*> ChestActors;
+			ChestActors.Reserve(MaxNumChests);
+			TArray<FStateControllerHandle> Handles;
+
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+
+			for (const int32 NumChests : {1000, 10000, MaxNumChests})
+			{
+				for (int32 Index = ChestActors.Num(); Index < NumChests; ++Index)
+				{
+					AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(),
+					                                          FTransform::Identity,
+					                                          SpawnParameters);
+					ChestActors.Add(Actor);
+
+					USceneComponent* Root = NewObject<USceneComponent>(Actor);
+					Root->SetRelativeLocation(FVector((Index % GridSize) * SpatialIndexSpacing,
+					                                  (Index / GridSize) * SpatialIndexSpacing,
+					                                  0.f));
+					Actor->SetRootComponent(Root);
+					Actor->AddInstanceComponent(Root);
+					Root->RegisterComponent();
+
+					UChestStateControllerComponent* Chest = NewObject<UChestStateControllerComponent>(Actor);
+					Actor->AddInstanceComponent(Chest);
+					Chest->RegisterComponent();
+
+					if (Index % 2 == 1)
+					{
+						IChestInterface::Execute_OpenChest(Chest, true);
+					}
+				}
+
+				const FVector MaxLocation(FMath::Min(NumChests, GridSize) * SpatialIndexSpacing,
+				                          FMath::DivideAndRoundUp(NumChests, GridSize) * SpatialIndexSpacing,
+				                          0.f);
+				TArray<FVector> Centers;
+				Centers.Reserve(NumSpatialQueries);
+				FRandomStream RandomStream(NumChests);
+
+				for (int32 Index = 0; Index < NumSpatialQueries; ++Index)
+				{
+					Centers.Emplace(RandomStream.FRandRange(0.f, MaxLocation.X),
+					                RandomStream.FRandRange(0.f, MaxLocation.Y),
+					                0.f);
+				}
+
+				const auto MeasureQueries = [this, NumChests, &Centers, &Handles](const TCHAR* Name, auto&& Query)
+				{
+					const FString ResultName = FString::Printf(TEXT("%s %d"), Name, NumChests);
+
+					Measure(ResultName, NumChests, NumSpatialQueries, [&Centers, &Handles, &Query]
+					{
+						for (const FVector& Center : Centers)
+						{
+							Handles.Reset();
+							Query(Center);
+						}
+					});
+				};
+
+				MeasureQueries(TEXT("Spatial Radius Queries"), [SpatialIndex, &Handles](const FVector& Center)
+				{
+					SpatialIndex->QueryRadius(Center, SpatialQueryRadius, EChestState::Closed, Handles);
+				});
+
+				MeasureQueries(TEXT("Spatial Box Queries"), [SpatialIndex, &Handles](const FVector& Center)
+				{
+					SpatialIndex->QueryBox(FBox::BuildAABB(Center, FVector(SpatialQueryRadius)),
+					                       EChestState::Closed,
+					                       Handles);
+				});
+
+				MeasureQueries(TEXT("Spatial Nearest Queries"), [SpatialIndex, &Handles](const FVector& Center)
+				{
+					SpatialIndex->QueryNearest(Center, 8, SpatialQueryRadius * 4.f, EChestState::Closed, Handles);
+				});
+			}
+
+			for (AActor* Actor : ChestActors)
+			{
+				Actor->Destroy();
+			}
+		}
+
+		/**
+		 * Measures saving a snapshot of 50k doors and restoring it with and without events.
+		 * Runs after the other actors are destroyed, so only the doors are in the snapshot.
+		 */
+		void BenchmarkSnapshots()
+		{
+			UStateControllerSnapshotSubsystem* Snapshots = UStateControllerSnapshotSubsystem::Get(World);
+
+			if (!Snapshots)
+			{
+				return;
+			}
+
+			constexpr int32 NumDoors = 50000;
+			TArray<UDoorStateControllerComponent*> Doors;
+			Doors.Reserve(NumDoors);
+
+			for (int32 Index = 0; Index < NumDoors; ++Index)
+			{
+				Doors.Add(SpawnActorWithComponent<UDoorStateControllerComponent>());
+			}
+
+			TArray<uint8> Data;
+
+			Measure(TEXT("Snapshot Saves"), NumDoors, NumDoors, [Snapshots, &Data]
+			{
+				Snapshots->SaveSnapshot(Data);
+			});
+
+			// Every restore has to change the doors back to Closed.
+			const auto OpenDoors = [&Doors]
+			{
+				for (UDoorStateControllerComponent* Door : Doors)
+				{
+					IDoorInterface::Execute_OpenDoor(Door, true);
+				}
+			};
+
+			OpenDoors();
+
+			Measure(TEXT("Snapshot Restores"), NumDoors, NumDoors, [Snapshots, &Data]
+			{
+				Snapshots->RestoreSnapshot(Data, false);
+			});
+
+			OpenDoors();
+
+			Measure(TEXT("Snapshot Restores With Events"), NumDoors, NumDoors, [Snapshots, &Data]
+			{
+				Snapshots->RestoreSnapshot(Data, true);
+			});
+
+			for (AActor* Actor : SpawnedActors)
+			{
+				Actor->Destroy();
+			}
+
+			SpawnedActors.Empty();
+		}
+
+		TArray<UKeyringComponent*> BenchmarkKeyrings()
+		{
+			TArray<UKeyringComponent*> Keyrings;
+			Keyrings.Reserve(NumObjects);
+
+			Measure(TEXT("Spawn Keyring"), NumObjects, NumObjects, [this, &Keyrings]
+			{
+				for (int32 Index = 0; Index < NumObjects; ++Index)
+				{
+					Keyrings.Add(SpawnActorWithComponent<UKeyringComponent>());
+				}
+			});
+
+			for (UKeyringComponent* Keyring : Keyrings)
+			{
+				for (UClass* LockKey : LockKeys)
+				{
+					IKeyringInterface::Execute_AddLockKey(Keyring, LockKey);
+				}
+			}
+
+			const int32 NumLookups = NumObjects * LockKeys.Num();
+
+			Measure(TEXT("Keyring Lookups"), NumObjects, NumLookups, [this, &Keyrings]
+			{
+				for (UKeyringComponent* Keyring : Keyrings)
+				{
+					for (UClass* LockKey : LockKeys)
+					{
+						IKeyringInterface::Execute_HasLockKey(Keyring, LockKey);
+					}
+				}
+			});
+
+			Measure(TEXT("Dispatched Keyring Lookups"), NumObjects, NumLookups, [this, &Keyrings]
+			{
+				for (UKeyringComponent* Keyring : Keyrings)
+				{
+					for (UClass* LockKey : LockKeys)
+					{
+						if (const IKeyringInterface* KeyringInterface =
+							FNativeInterfaceDispatch::GetNativeInterface<IKeyringInterface>(
+								Keyring, GET_FUNCTION_NAME_CHECKED(IKeyringInterface, HasLockKey)))
+						{
+							KeyringInterface->HasLockKey_Implementation(LockKey);
+						}
+					}
+				}
+			});
+
+			for (UKeyringComponent* Keyring : Keyrings)
+			{
+				Keyring->SetStorageMode(EKeyringStorageMode::Bitset);
+			}
+
+			Measure(TEXT("Bitset Keyring Lookups"), NumObjects, NumLookups, [this, &Keyrings]
+			{
+				for (UKeyringComponent* Keyring : Keyrings)
+				{
+					for (UClass* LockKey : LockKeys)
+					{
+						IKeyringInterface::Execute_HasLockKey(Keyring, LockKey);
+					}
+				}
+			});
+
+			for (UKeyringComponent* Keyring : Keyrings)
+			{
+				Keyring->SetStorageMode(EKeyringStorageMode::Array);
+			}
+
+			return Keyrings;
+		}
+
+		void BenchmarkLockAttempts(const TArray<ULockStateControllerComponent*>& Locks,
+		                           const TArray<UKeyringComponent*>& Keyrings)
+		{
+			for (ULockStateControllerComponent* Lock : Locks)
+			{
+				Lock->SetRequiredKey(LockKeys.Last());
+			}
+
+			Measure(TEXT("Lock Attempts"), NumObjects, NumObjects * 2, [&Locks, &Keyrings]
+			{
+				for (int32 Index = 0; Index < Locks.Num(); ++Index)
+				{
+					AActor* Instigator = Keyrings[Index]->GetOwner();
+					ILockInterface::Execute_Unlock(Locks[Index], Instigator, true);
+					ILockInterface::Execute_Lock(Locks[Index], Instigator, true);
+				}
+			});
+
+			// An actor without a keyring, so every attempt fails after searching for the keyring.
+			AActor* Instigator = World->SpawnActor<AActor>();
+			SpawnedActors.Add(Instigator);
+
+			Measure(TEXT("Failed Lock Attempts"), NumObjects, NumObjects, [&Locks, Instigator]
+			{
+				for (ULockStateControllerComponent* Lock : Locks)
+				{
+					ILockInterface::Execute_Unlock(Lock, Instigator, true);
+				}
+			});
+		}
+
+		/**
+		 * Measures ActivatePickup alone with pickups which aren't destroyed after activation.
+		 * The pickups are placed below the given locations, so the overlap benchmark doesn't activate them.
+		 */
+		void BenchmarkPickupActivations(const TArray<FVector>& Locations)
+		{
+			TArray<ATrickyGameplayObjectsBenchmarkPickup*> Pickups;
+			Pickups.Reserve(Locations.Num());
+
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+			for (const FVector& Location : Locations)
+			{
+				Pickups.Add(World->SpawnActor<ATrickyGameplayObjectsBenchmarkPickup>(
+					Location - FVector(0.f, 0.f, PickupSpacing),
+					FRotator::ZeroRotator,
+					SpawnParameters));
+			}
+
+			SpawnedActors.Append(Pickups);
+
+			AActor* Activator = World->SpawnActor<AActor>();
+			SpawnedActors.Add(Activator);
+			int32 NumActivations = 0;
+
+			Measure(TEXT("Pickup Activations"), NumObjects, NumObjects, [Activator, &Pickups, &NumActivations]
+			{
+				for (ATrickyGameplayObjectsBenchmarkPickup* Pickup : Pickups)
+				{
+					NumActivations += Pickup->ActivatePickup(Activator);
+				}
+			});
+
+			// Failed activations aren't counted.
+			Results.Last().NumOperations = NumActivations;
+		}
+
+		void BenchmarkPickups()
+		{
+			const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumObjects)));
+			TArray<APickupAutomaticBase*> Pickups;
+			TArray<FVector> Locations;
+			Pickups.Reserve(NumObjects);
+			Locations.Reserve(NumObjects);
+
+			for (int32 Index = 0; Index < NumObjects; ++Index)
+			{
+				Locations.Emplace((Index % GridSize) * PickupSpacing, (Index / GridSize) * PickupSpacing, 0.f);
+			}
+
+			Measure(TEXT("Spawn Pickup"), NumObjects, NumObjects, [this, &Pickups, &Locations]
+			{
+				FActorSpawnParameters SpawnParameters;
+				SpawnParameters.ObjectFlags |= RF_Transient;
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+				for (const FVector& Location : Locations)
+				{
+					Pickups.Add(World->SpawnActor<APickupAutomaticBase>(Location,
+					                                                    FRotator::ZeroRotator,
+					                                                    SpawnParameters));
+				}
+			});
+
+			SpawnedActors.Append(Pickups);
+			BenchmarkPickupActivations(Locations);
+
+			// Activates the pickups by overlapping them with a pawn-channel sphere, like a character walking over them.
+			AActor* Activator = World->SpawnActor<AActor>(FVector(-PickupSpacing), FRotator::ZeroRotator);
+			USphereComponent* Collision = NewObject<USphereComponent>(Activator);
+			Collision->InitSphereRadius(10.f);
+			Collision->SetCollisionObjectType(ECC_Pawn);
+			Collision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Collision->SetCollisionResponseToAllChannels(ECR_Overlap);
+			Collision->SetGenerateOverlapEvents(true);
+			Activator->SetRootComponent(Collision);
+			Activator->AddInstanceComponent(Collision);
+			Collision->RegisterComponent();
+			SpawnedActors.Add(Activator);
+
+			Measure(TEXT("Pickup Overlap Activations"), NumObjects, NumObjects, [Activator, &Locations]
+			{
+				for (const FVector& Location : Locations)
+				{
+					Activator->SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+				}
+			});
+
+			// Pickups which weren't overlapped, e.g. because of the collision settings, aren't counted.
+			Results.Last().NumOperations = Algo::CountIf(Pickups, [](const APickupAutomaticBase* Pickup)
+			{
+				return !IsValid(Pickup) || Pickup->IsActorBeingDestroyed();
+			});
+		}
+	};
+
+	void ExecuteRunBenchmark(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumObjects = FMath::Clamp(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 1000, 1, 1000000);
+		const FString FileName = Args.IsValidIndex(1) ? Args[1] : TEXT("Benchmark");
+		TArray<FTrickyGameplayObjectsBenchmarkResult> Results;
+
+		if (!FTrickyGameplayObjectsBenchmark::Run(World, NumObjects, Results))
+		{
+			Ar.Log(TEXT("The benchmark can be run only in a game world"));
+			return;
+		}
+
+		for (const FTrickyGameplayObjectsBenchmarkResult& Result : Results)
+		{
+			Ar.Logf(TEXT("%-32s | Operations: %8d | Total: %10.3f ms | %10.1f ns/op | %12.0f op/s | %6.2f allocs/op"),
+			        *Result.Name,
+			        Result.NumOperations,
+			        Result.TotalSeconds * 1000.0,
+			        Result.GetNanosecondsPerOperation(),
+			        Result.GetOperationsPerSecond(),
+			        Result.GetAllocationsPerOperation());
+		}
+
+		const FString Path = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FileName;
+		FFileHelper::SaveStringToFile(FTrickyGameplayObjectsBenchmark::ToJson(Results), *(Path + TEXT(".json")));
+		FFileHelper::SaveStringToFile(FTrickyGameplayObjectsBenchmark::ToCsv(Results), *(Path + TEXT(".csv")));
+		Ar.Logf(TEXT("Benchmark results saved to %s.json and %s.csv"), *Path, *Path);
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice RunBenchmarkCommand(
+		TEXT("TrickyGameplayObjects.RunBenchmark"),
+		TEXT("Measures the throughput of the plugin objects and saves the results to Saved/Benchmarks. "
+			"Usage: [NumObjects=1000] [FileName]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteRunBenchmark));
+}
+
+bool FTrickyGameplayObjectsBenchmark::Run(UWorld* World,
+                                          const int32 NumObjects,
+                                          TArray<FTrickyGameplayObjectsBenchmarkResult>& OutResults)
+{
+	if (!World || !World->IsGameWorld() || NumObjects <= 0)
+	{
+		return false;
+	}
+
+	using namespace TrickyGameplayObjectsBenchmark;
+
+	FCountingMalloc& CountingMalloc = GetCountingMalloc();
+	const bool bInstalledCountingMalloc = CountingMalloc.Install();
+
+	FBenchmarkRunner Runner(World, NumObjects, OutResults);
+	Runner.Run();
+	OnRun().Broadcast(World, NumObjects, OutResults);
+
+	if (bInstalledCountingMalloc)
+	{
+		CountingMalloc.Uninstall();
+	}
+
+	return true;
+}
+
+FOnTrickyGameplayObjectsBenchmarkRunSignature& FTrickyGameplayObjectsBenchmark::OnRun()
+{
+	static FOnTrickyGameplayObjectsBenchmarkRunSignature Delegate;
+	return Delegate;
+}
+
+uint64 FTrickyGameplayObjectsBenchmark::GetNumAllocations()
+{
+	return TrickyGameplayObjectsBenchmark::GetCountingMalloc().GetNumAllocations();
+}
+
+FString FTrickyGameplayObjectsBenchmark::ToJson(TConstArrayView<FTrickyGameplayObjectsBenchmarkResult> Results)
+{
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("TrickyGameplayObjects"));
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("PluginVersion"), Plugin ? Plugin->GetDescriptor().VersionName : FString());
+	Writer->WriteValue(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+	Writer->WriteArrayStart(TEXT("Results"));
+
+	for (const FTrickyGameplayObjectsBenchmarkResult& Result : Results)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Name"), Result.Name);
+		Writer->WriteValue(TEXT("NumObjects"), Result.NumObjects);
+		Writer->WriteValue(TEXT("NumOperations"), Result.NumOperations);
+		Writer->WriteValue(TEXT("TotalMs"), Result.TotalSeconds * 1000.0);
+		Writer->WriteValue(TEXT("NsPerOperation"), Result.GetNanosecondsPerOperation());
+		Writer->WriteValue(TEXT("OperationsPerSecond"), Result.GetOperationsPerSecond());
+		Writer->WriteValue(TEXT("AllocationsPerOperation"), Result.GetAllocationsPerOperation());
+		Writer->WriteObjectEnd();
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return Json;
+}
+
+FString FTrickyGameplayObjectsBenchmark::ToCsv(TConstArrayView<FTrickyGameplayObjectsBenchmarkResult> Results)
+{
+	FString Csv = TEXT("Name,NumObjects,NumOperations,TotalMs,NsPerOperation,OperationsPerSecond,"
+		"AllocationsPerOperation\n");
+
+	for (const FTrickyGameplayObjectsBenchmarkResult& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%s,%d,%d,%.3f,%.1f,%.0f,%.2f\n"),
+		                       *Result.Name,
+		                       Result.NumObjects,
+		                       Result.NumOperations,
+		                       Result.TotalSeconds * 1000.0,
+		                       Result.GetNanosecondsPerOperation(),
+		                       Result.GetOperationsPerSecond(),
+		                       Result.GetAllocationsPerOperation());
+	}
+
+	return Csv;
+}
+#endif
@@ -0,0 +1,35 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Door/DoorInterface.h"
+#include "TrickyGameplayObjectsBenchmarkListener.generated.h"
+
+/**
+ * Listener bound to the state controller delegates by the benchmark to measure the broadcast cost.
+ */
+UCLASS(Transient)
+class UTrickyGameplayObjectsBenchmarkListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	int32 NumCalls = 0;
+
+	UFUNCTION()
+	void HandleDoorStateChanged(UDoorStateControllerComponent* Component,
+	                            EDoorState NewState,
+	                            bool bChangedImmediately)
+	{
+		++NumCalls;
+	}
+
+	void HandleDoorStateChangedNative(UDoorStateControllerComponent* Component,
+	                                  const EDoorState NewState,
+	                                  const bool bChangedImmediately)
+	{
+		++NumCalls;
+	}
+};
@@ -0,0 +1,24 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Pickup/PickupAutomaticBase.h"
+#include "TrickyGameplayObjectsBenchmarkPickup.generated.h"
+
+/**
+ * Automatic pickup which isn't destroyed after activation, so the benchmark can measure ActivatePickup alone.
+ */
+UCLASS(Transient, NotBlueprintable)
+class ATrickyGameplayObjectsBenchmarkPickup : public APickupAutomaticBase
+{
+	GENERATED_BODY()
+
+public:
+	ATrickyGameplayObjectsBenchmarkPickup()
+	{
+		bDestroyAfterActivation = false;
+	}
+
+	using APickupBase::ActivatePickup;
+};
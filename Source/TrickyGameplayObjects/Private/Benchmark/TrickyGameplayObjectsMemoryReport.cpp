@@ -0,0 +1,134 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Benchmark/TrickyGameplayObjectsMemoryReport.h"
+
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+#include "LockKey/KeyringComponent.h"
+#include "Pickup/PickupBase.h"
+
+namespace TrickyGameplayObjectsMemoryReport
+{
+	bool IsReportedComponent(const UActorComponent* Component)
+	{
+		return Component->IsA<UDoorStateControllerComponent>()
+			|| Component->IsA<UChestStateControllerComponent>()
+			|| Component->IsA<ULockStateControllerComponent>()
+			|| Component->IsA<UButtonStateControllerComponent>()
+			|| Component->IsA<UGameplayObjectStateControllerComponent>()
+			|| Component->IsA<UKeyringComponent>();
+	}
+
+	void AddObject(UObject* Object, FTrickyGameplayObjectsMemoryReportEntry& Entry)
+	{
+		Entry.InlineBytes += Object->GetClass()->GetStructureSize();
+		Entry.AllocatedBytes += Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+}
+
+void FTrickyGameplayObjectsMemoryReport::Collect(const UWorld* World,
+                                                 TArray<FTrickyGameplayObjectsMemoryReportEntry>& OutEntries)
+{
+	using namespace TrickyGameplayObjectsMemoryReport;
+
+	OutEntries.Reset();
+
+	if (!World)
+	{
+		return;
+	}
+
+	TMap<const UClass*, FTrickyGameplayObjectsMemoryReportEntry> Entries;
+
+	auto FindOrAddEntry = [&Entries](const UClass* Class) -> FTrickyGameplayObjectsMemoryReportEntry&
+	{
+		FTrickyGameplayObjectsMemoryReportEntry& Entry = Entries.FindOrAdd(Class);
+		Entry.Class = Class;
+		return Entry;
+	};
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		// Pickups are reported as a whole, with the root and the trigger components.
+		if (Actor->IsA<APickupBase>())
+		{
+			FTrickyGameplayObjectsMemoryReportEntry& Entry = FindOrAddEntry(Actor->GetClass());
+			++Entry.NumInstances;
+			AddObject(Actor, Entry);
+
+			// The resource size of the actor already includes the allocations of its components.
+			for (const UActorComponent* Component : Actor->GetComponents())
+			{
+				Entry.InlineBytes += Component->GetClass()->GetStructureSize();
+			}
+
+			continue;
+		}
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (IsReportedComponent(Component))
+			{
+				FTrickyGameplayObjectsMemoryReportEntry& Entry = FindOrAddEntry(Component->GetClass());
+				++Entry.NumInstances;
+				AddObject(Component, Entry);
+			}
+		}
+	}
+
+	Entries.GenerateValueArray(OutEntries);
+	OutEntries.Sort([](const FTrickyGameplayObjectsMemoryReportEntry& A,
+	                   const FTrickyGameplayObjectsMemoryReportEntry& B)
+	{
+		return A.GetTotalBytes() > B.GetTotalBytes();
+	});
+}
+
+void FTrickyGameplayObjectsMemoryReport::Print(TConstArrayView<FTrickyGameplayObjectsMemoryReportEntry> Entries,
+                                               FOutputDevice& Ar)
+{
+	int32 NumInstances = 0;
+	SIZE_T TotalBytes = 0;
+
+	for (const FTrickyGameplayObjectsMemoryReportEntry& Entry : Entries)
+	{
+		Ar.Logf(TEXT("%-48s | Count: %7d | Per instance: %8.1f B | Allocated: %10.1f KB | Total: %10.1f KB"),
+		        *GetNameSafe(Entry.Class),
+		        Entry.NumInstances,
+		        Entry.GetBytesPerInstance(),
+		        Entry.AllocatedBytes / 1024.0,
+		        Entry.GetTotalBytes() / 1024.0);
+
+		NumInstances += Entry.NumInstances;
+		TotalBytes += Entry.GetTotalBytes();
+	}
+
+	Ar.Logf(TEXT("Total | Count: %d | %.1f KB"), NumInstances, TotalBytes / 1024.0);
+}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+namespace TrickyGameplayObjectsMemoryReport
+{
+	void ExecuteMemoryReport(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		TArray<FTrickyGameplayObjectsMemoryReportEntry> Entries;
+		FTrickyGameplayObjectsMemoryReport::Collect(World, Entries);
+		FTrickyGameplayObjectsMemoryReport::Print(Entries, Ar);
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice MemoryReportCommand(
+		TEXT("TrickyGameplayObjects.MemoryReport"),
+		TEXT("Prints the counts and the memory of the state controllers, keyrings and pickups in the world per class."),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteMemoryReport));
+}
+#endif
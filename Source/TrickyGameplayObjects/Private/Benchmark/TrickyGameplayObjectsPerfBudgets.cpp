@@ -0,0 +1,155 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Benchmark/TrickyGameplayObjectsPerfBudgets.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "Benchmark/TrickyGameplayObjectsBenchmark.h"
+#include "Door/DoorStateControllerComponent.h"
+
+namespace TrickyGameplayObjectsPerfBudgets
+{
+	bool CheckBudget(FOutputDevice& Ar,
+	                 const FString& Name,
+	                 const double Value,
+	                 const double Budget,
+	                 const TCHAR* Unit)
+	{
+		if (Budget <= 0.0)
+		{
+			return true;
+		}
+
+		if (Value > Budget)
+		{
+			Ar.Logf(ELogVerbosity::Error,
+			        TEXT("%s exceeded the budget: %.2f %s | Budget: %.2f %s"),
+			        *Name,
+			        Value,
+			        Unit,
+			        Budget,
+			        Unit);
+			return false;
+		}
+
+		Ar.Logf(TEXT("%s: %.2f %s | Budget: %.2f %s"), *Name, Value, Unit, Budget, Unit);
+		return true;
+	}
+
+	bool CheckAllocationBudget(FOutputDevice& Ar,
+	                           const FTrickyGameplayObjectsBenchmarkResult& Result,
+	                           const float Budget)
+	{
+		return CheckBudget(Ar, Result.Name, Result.GetAllocationsPerOperation(), Budget, TEXT("allocs/op"));
+	}
+
+	/**
+	 * Returns the size of a registered door state controller including the memory allocated by its containers.
+	 */
+	int64 MeasureDoorComponentBytes(UWorld* World)
+	{
+		AActor* Actor = World->SpawnActor<AActor>();
+		UDoorStateControllerComponent* Door = NewObject<UDoorStateControllerComponent>(Actor);
+		Actor->AddInstanceComponent(Door);
+		Door->RegisterComponent();
+
+		const FArchiveCountMem CountMem(Door);
+		Actor->Destroy();
+		return static_cast<int64>(CountMem.GetMax());
+	}
+
+	void ExecuteCheckPerfBudgets(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const bool bMet = UTrickyGameplayObjectsPerfBudgets::CheckBudgets(World, Ar);
+		Ar.Logf(bMet ? ELogVerbosity::Display : ELogVerbosity::Error,
+		        TEXT("Performance budgets %s"),
+		        bMet ? TEXT("met") : TEXT("exceeded"));
+
+		if (Args.Contains(TEXT("Exit")))
+		{
+			FPlatformMisc::RequestExitWithStatus(false, bMet ? 0 : 1);
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice CheckPerfBudgetsCommand(
+		TEXT("TrickyGameplayObjects.CheckPerfBudgets"),
+		TEXT("Runs the reference workload and checks it against the configured performance budgets. "
+			"Usage: [Exit] to exit with a non-zero code if any budget is exceeded"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteCheckPerfBudgets));
+}
+#endif
+
+bool UTrickyGameplayObjectsPerfBudgets::CheckBudgets(UWorld* World, FOutputDevice& Ar)
+{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+	using namespace TrickyGameplayObjectsPerfBudgets;
+
+	const UTrickyGameplayObjectsPerfBudgets* Budgets = GetDefault<UTrickyGameplayObjectsPerfBudgets>();
+	const int32 NumObjects = FMath::Max(Budgets->ReferenceNumObjects, 1);
+	TArray<FTrickyGameplayObjectsBenchmarkResult> Results;
+
+	if (!FTrickyGameplayObjectsBenchmark::Run(World, NumObjects, Results))
+	{
+		Ar.Log(ELogVerbosity::Error, TEXT("Performance budgets can be checked only in a game world"));
+		return false;
+	}
+
+	bool bMet = true;
+
+	for (const FTrickyGameplayObjectsBenchmarkResult& Result : Results)
+	{
+		if (Result.Name.EndsWith(TEXT(" Transitions")))
+		{
+			bMet &= CheckBudget(Ar,
+			                    Result.Name,
+			                    Result.GetNanosecondsPerOperation(),
+			                    Budgets->MaxNsPerChangeCurrentState,
+			                    TEXT("ns/op"));
+		}
+		else if (Result.Name == TEXT("Pickup Overlap Activations") && Result.NumOperations != NumObjects)
+		{
+			Ar.Logf(ELogVerbosity::Error,
+			        TEXT("Only %d of %d pickups were activated by overlaps"),
+			        Result.NumOperations,
+			        NumObjects);
+			bMet = false;
+		}
+		else if (Result.Name == TEXT("Pickup Activations"))
+		{
+			if (Result.NumOperations != NumObjects)
+			{
+				Ar.Logf(ELogVerbosity::Error,
+				        TEXT("Only %d of %d pickups were activated"),
+				        Result.NumOperations,
+				        NumObjects);
+				bMet = false;
+			}
+
+			bMet &= CheckAllocationBudget(Ar, Result, Budgets->MaxAllocationsPerPickupActivation);
+		}
+
+		if (const float* MaxNs = Budgets->MaxNsPerOperation.Find(Result.Name))
+		{
+			bMet &= CheckBudget(Ar, Result.Name, Result.GetNanosecondsPerOperation(), *MaxNs, TEXT("ns/op"));
+		}
+
+		if (const float* MaxAllocations = Budgets->MaxAllocationsPerOperation.Find(Result.Name))
+		{
+			bMet &= CheckAllocationBudget(Ar, Result, *MaxAllocations);
+		}
+	}
+
+	bMet &= CheckBudget(Ar,
+	                    TEXT("Door Component Size"),
+	                    MeasureDoorComponentBytes(World),
+	                    Budgets->MaxBytesPerDoorComponent,
+	                    TEXT("bytes"));
+	return bMet;
+#else
+	return false;
+#endif
+}
@@ -2,14 +2,65 @@
 
 
 #include "Button/ButtonStateControllerComponent.h"
+#include "StateController/StateControllerComponentCore.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "Net/UnrealNetwork.h"
 #include "GameFramework/Actor.h"
 
 DEFINE_LOG_CATEGORY(LogButton);
 
+template <>
+struct TStateControllerComponentBinding<UButtonStateControllerComponent>
+{
+	using EnumType = EButtonState;
+
+	static constexpr auto StateChanged = &UButtonStateControllerComponent::OnButtonStateChanged;
+
+	static constexpr auto StateChangedNative = &UButtonStateControllerComponent::OnButtonStateChangedNative;
+
+	static constexpr auto TransitionStarted = &UButtonStateControllerComponent::OnButtonStateTransitionStarted;
+
+	static constexpr auto TransitionStartedNative =
+		&UButtonStateControllerComponent::OnButtonStateTransitionStartedNative;
+
+	static constexpr auto TransitionFinished = &UButtonStateControllerComponent::OnButtonStateTransitionFinished;
+
+	static constexpr auto TransitionFinishedNative =
+		&UButtonStateControllerComponent::OnButtonStateTransitionFinishedNative;
+
+	static constexpr auto TransitionReversed = &UButtonStateControllerComponent::OnButtonStateTransitionReversed;
+
+	static constexpr auto TransitionReversedNative =
+		&UButtonStateControllerComponent::OnButtonStateTransitionReversedNative;
+
+	static void CountTransition()
+	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(ButtonTransitions, 1);
+	}
+};
+
+using FButtonStateControllerCore = TStateControllerComponentCore<UButtonStateControllerComponent>;
+
 UButtonStateControllerComponent::UButtonStateControllerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UButtonStateControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UButtonStateControllerComponent, ReplicatedStates, Params);
+}
+
+void UButtonStateControllerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(FButtonStateControllerCore::GetEventsAllocatedSize(*this));
 }
 
 void UButtonStateControllerComponent::InitializeComponent()
@@ -25,6 +76,14 @@ void UButtonStateControllerComponent::InitializeComponent()
 	}
 
 	CurrentState = InitialState;
+	FButtonStateControllerCore::Register(*this);
+}
+
+void UButtonStateControllerComponent::UninitializeComponent()
+{
+	FButtonStateControllerCore::Unregister(*this);
+
+	Super::UninitializeComponent();
 }
 
 void UButtonStateControllerComponent::SetInitialState(const EButtonState NewState)
@@ -44,6 +103,36 @@ void UButtonStateControllerComponent::SetInitialState(const EButtonState NewStat
 
 	InitialState = NewState;
 	CurrentState = InitialState;
+	FButtonStateControllerCore::SyncStates(*this);
+}
+
+void UButtonStateControllerComponent::RestoreInitialState(const EButtonState NewState)
+{
+	FButtonStateControllerCore::RestoreInitialState(*this, NewState);
+}
+
+void UButtonStateControllerComponent::SetTransitionDuration(const float NewDuration)
+{
+	TransitionDuration = FMath::Max(NewDuration, 0.f);
+}
+
+void UButtonStateControllerComponent::RestoreStates(const EButtonState NewCurrentState,
+                                                    const EButtonState NewTargetState,
+                                                    const EButtonState NewLastState,
+                                                    const float TransitionTimeLeft,
+                                                    const bool bBroadcastStateChanged)
+{
+	FButtonStateControllerCore::RestoreStates(*this,
+	                                          NewCurrentState,
+	                                          NewTargetState,
+	                                          NewLastState,
+	                                          TransitionTimeLeft,
+	                                          bBroadcastStateChanged);
+}
+
+void UButtonStateControllerComponent::RestoreReplicatedStates()
+{
+	FButtonStateControllerCore::RestoreReplicatedStates(*this);
 }
 
 bool UButtonStateControllerComponent::PressButton_Implementation(const bool bTransitImmediately)
@@ -94,7 +183,7 @@ bool UButtonStateControllerComponent::ForceButtonState_Implementation(const EBut
 		return false;
 	}
 
-	if (NewState == EButtonState::Transition)
+	if (FButtonStateController::IsTransition(NewState))
 	{
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 		PrintWarning("Can't force state to Transition");
@@ -107,101 +196,22 @@ bool UButtonStateControllerComponent::ForceButtonState_Implementation(const EBut
 
 bool UButtonStateControllerComponent::FinishButtonStateTransition_Implementation()
 {
-	if (CurrentState != EButtonState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't finish transition, because CurrentState isn't Transition");
-#endif
-		return false;
-	}
-
-	if (!ChangeCurrentState(TargetState, true))
-	{
-		return false;
-	}
-
-	OnButtonStateTransitionFinished.Broadcast(this, TargetState);
-	return true;
+	return FButtonStateControllerCore::FinishTransition(*this);
 }
 
 bool UButtonStateControllerComponent::ReverseButtonStateTransition_Implementation()
 {
-	if (CurrentState != EButtonState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't reverse transition, because CurrentState is Transition");
-#endif
-		return false;
-	}
-
-	const EButtonState NewTargetState = LastState;
-	LastState = TargetState;
-	TargetState = NewTargetState;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString TargetStateName = "NONE";
-	GetStateName(TargetStateName, TargetState);
-	FString LastStateName = "NONE";
-	GetStateName(LastStateName, LastState);
-	const FString LogMessage = FString::Printf(
-		TEXT("TargetState reversed from %s to %s"), *LastStateName, *TargetStateName);
-	PrintLog(LogMessage);
-#endif
-	
-	OnButtonStateTransitionReversed.Broadcast(this, TargetState);
-	return true;
+	return FButtonStateControllerCore::ReverseTransition(*this);
 }
 
 bool UButtonStateControllerComponent::ChangeCurrentState(const EButtonState NewState, const bool bTransitImmediately)
 {
-	if (NewState == CurrentState)
-	{
-		return false;
-	}
-
-	if (NewState == EButtonState::Transition)
-	{
-		
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't change CurrentState to Transition");
-#endif
-		
-		return false;
-	}
-
-	TargetState = NewState;
-	LastState = CurrentState;
-
-	if (bTransitImmediately)
-	{
-		CurrentState = TargetState;
-	}
-	else
-	{
-		CurrentState = EButtonState::Transition;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		FString TargetStateName = "NONE";
-		GetStateName(TargetStateName, TargetState);
-		FString LastStateName = "NONE";
-		GetStateName(LastStateName, LastState);
-		const FString LogMessage = FString::Printf(
-			TEXT("Start state transition from %s to %s"), *LastStateName, *TargetStateName);
-		PrintLog(LogMessage);
-#endif
-		
-		OnButtonStateTransitionStarted.Broadcast(this, TargetState);
-	}
+	return FButtonStateControllerCore::ChangeState(*this, NewState, bTransitImmediately);
+}
 
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString StateName = "NONE";
-	GetStateName(StateName, CurrentState);
-	const FString LogMessage = FString::Printf(TEXT("State changed to %s"), *StateName);
-	PrintLog(LogMessage);
-#endif
-	
-	OnButtonStateChanged.Broadcast(this, CurrentState, bTransitImmediately);
-	return true;
+void UButtonStateControllerComponent::OnRep_ReplicatedStates()
+{
+	FButtonStateControllerCore::ApplyReplicatedStates(*this);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
@@ -221,9 +231,4 @@ void UButtonStateControllerComponent::PrintLog(const FString& Message) const
 	                                              *OwnerName);
 	UE_LOG(LogButton, Display, TEXT("%s%s"), *SourceMessage, *Message);
 }
-
-void UButtonStateControllerComponent::GetStateName(FString& StateName, const EButtonState State)
-{
-	StateName = StaticEnum<EButtonState>()->GetNameStringByValue(static_cast<int64>(State));
-}
 #endif
@@ -2,14 +2,64 @@
 
 
 #include "Chest/ChestStateControllerComponent.h"
+#include "StateController/StateControllerComponentCore.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "Net/UnrealNetwork.h"
 #include "GameFramework/Actor.h"
 
 DEFINE_LOG_CATEGORY(LogChest);
 
+template <>
+struct TStateControllerComponentBinding<UChestStateControllerComponent>
+{
+	using EnumType = EChestState;
+
+	static constexpr auto StateChanged = &UChestStateControllerComponent::OnChestStateChanged;
+
+	static constexpr auto StateChangedNative = &UChestStateControllerComponent::OnChestStateChangedNative;
+
+	static constexpr auto TransitionStarted = &UChestStateControllerComponent::OnChestStateTransitionStarted;
+
+	static constexpr auto TransitionStartedNative =
+		&UChestStateControllerComponent::OnChestStateTransitionStartedNative;
+
+	static constexpr auto TransitionFinished = &UChestStateControllerComponent::OnChestStateTransitionFinished;
+
+	static constexpr auto TransitionFinishedNative =
+		&UChestStateControllerComponent::OnChestStateTransitionFinishedNative;
+
+	static constexpr auto TransitionReversed = &UChestStateControllerComponent::OnChestTransitionReversed;
+
+	static constexpr auto TransitionReversedNative = &UChestStateControllerComponent::OnChestTransitionReversedNative;
+
+	static void CountTransition()
+	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(ChestTransitions, 1);
+	}
+};
+
+using FChestStateControllerCore = TStateControllerComponentCore<UChestStateControllerComponent>;
+
 UChestStateControllerComponent::UChestStateControllerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UChestStateControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UChestStateControllerComponent, ReplicatedStates, Params);
+}
+
+void UChestStateControllerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(FChestStateControllerCore::GetEventsAllocatedSize(*this));
 }
 
 void UChestStateControllerComponent::InitializeComponent()
@@ -25,6 +75,14 @@ void UChestStateControllerComponent::InitializeComponent()
 	}
 
 	CurrentState = InitialState;
+	FChestStateControllerCore::Register(*this);
+}
+
+void UChestStateControllerComponent::UninitializeComponent()
+{
+	FChestStateControllerCore::Unregister(*this);
+
+	Super::UninitializeComponent();
 }
 
 void UChestStateControllerComponent::SetInitialState(const EChestState NewState)
@@ -44,6 +102,31 @@ void UChestStateControllerComponent::SetInitialState(const EChestState NewState)
 
 	InitialState = NewState;
 	CurrentState = InitialState;
+	FChestStateControllerCore::SyncStates(*this);
+}
+
+void UChestStateControllerComponent::RestoreInitialState(const EChestState NewState)
+{
+	FChestStateControllerCore::RestoreInitialState(*this, NewState);
+}
+
+void UChestStateControllerComponent::SetTransitionDuration(const float NewDuration)
+{
+	TransitionDuration = FMath::Max(NewDuration, 0.f);
+}
+
+void UChestStateControllerComponent::RestoreStates(const EChestState NewCurrentState,
+                                                   const EChestState NewTargetState,
+                                                   const EChestState NewLastState,
+                                                   const float TransitionTimeLeft,
+                                                   const bool bBroadcastStateChanged)
+{
+	FChestStateControllerCore::RestoreStates(*this,
+	                                         NewCurrentState,
+	                                         NewTargetState,
+	                                         NewLastState,
+	                                         TransitionTimeLeft,
+	                                         bBroadcastStateChanged);
 }
 
 bool UChestStateControllerComponent::OpenChest_Implementation(const bool bTransitImmediately)
@@ -114,7 +197,7 @@ bool UChestStateControllerComponent::ForceChestState_Implementation(const EChest
 		return false;
 	}
 
-	if (NewState == EChestState::Transition)
+	if (FChestStateController::IsTransition(NewState))
 	{
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 		PrintWarning("Can't force state to Transition");
@@ -127,100 +210,22 @@ bool UChestStateControllerComponent::ForceChestState_Implementation(const EChest
 
 bool UChestStateControllerComponent::FinishChestStateTransition_Implementation()
 {
-	if (CurrentState != EChestState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't finish transition, because CurrentState isn't Transition");
-#endif
-		return false;
-	}
-
-	if (!ChangeCurrentState(TargetState, true))
-	{
-		return false;
-	}
-
-	OnChestStateTransitionFinished.Broadcast(this, TargetState);
-	return true;
+	return FChestStateControllerCore::FinishTransition(*this);
 }
 
 bool UChestStateControllerComponent::ReverseChestStateTransition_Implementation()
 {
-	if (CurrentState != EChestState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't reverse transition, because CurrentState is Transition");
-#endif
-		return false;
-	}
-
-	const EChestState NewTargetState = LastState;
-	LastState = TargetState;
-	TargetState = NewTargetState;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString TargetStateName = "NONE";
-	GetStateName(TargetStateName, TargetState);
-	FString LastStateName = "NONE";
-	GetStateName(LastStateName, LastState);
-	const FString LogMessage = FString::Printf(
-		TEXT("TargetState reversed from %s to %s"), *LastStateName, *TargetStateName);
-	PrintLog(LogMessage);
-#endif
-
-	OnChestTransitionReversed.Broadcast(this, TargetState);
-	return true;
+	return FChestStateControllerCore::ReverseTransition(*this);
 }
 
 bool UChestStateControllerComponent::ChangeCurrentState(EChestState NewState, const bool bTransitImmediately)
 {
-	if (NewState == CurrentState)
-	{
-		return false;
-	}
-
-	if (NewState == EChestState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't change CurrentState to Transition");
-#endif
-
-		return false;
-	}
-
-	TargetState = NewState;
-	LastState = CurrentState;
-
-	if (bTransitImmediately)
-	{
-		CurrentState = TargetState;
-	}
-	else
-	{
-		CurrentState = EChestState::Transition;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		FString TargetStateName = "NONE";
-		GetStateName(TargetStateName, TargetState);
-		FString LastStateName = "NONE";
-		GetStateName(LastStateName, LastState);
-		const FString LogMessage = FString::Printf(
-			TEXT("Start state transition from %s to %s"), *LastStateName, *TargetStateName);
-		PrintLog(LogMessage);
-#endif
-
-		OnChestStateTransitionStarted.Broadcast(this, TargetState);
-	}
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString StateName = "NONE";
-	GetStateName(StateName, CurrentState);
-	const FString LogMessage = FString::Printf(TEXT("State changed to %s"), *StateName);
-	PrintLog(LogMessage);
-#endif
+	return FChestStateControllerCore::ChangeState(*this, NewState, bTransitImmediately);
+}
 
-	OnChestStateChanged.Broadcast(this, CurrentState, bTransitImmediately);
-	return true;
+void UChestStateControllerComponent::OnRep_ReplicatedStates()
+{
+	FChestStateControllerCore::ApplyReplicatedStates(*this);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
@@ -240,9 +245,4 @@ void UChestStateControllerComponent::PrintLog(const FString& Message) const
 	                                              *OwnerName);
 	UE_LOG(LogChest, Display, TEXT("%s%s"), *SourceMessage, *Message);
 }
-
-void UChestStateControllerComponent::GetStateName(FString& StateName, const EChestState State)
-{
-	StateName = StaticEnum<EChestState>()->GetNameStringByValue(static_cast<int64>(State));
-}
 #endif
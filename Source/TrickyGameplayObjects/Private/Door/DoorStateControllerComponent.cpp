@@ -2,14 +2,63 @@
 
 
 #include "Door/DoorStateControllerComponent.h"
+#include "StateController/StateControllerComponentCore.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "Net/UnrealNetwork.h"
 #include "GameFramework/Actor.h"
 
 DEFINE_LOG_CATEGORY(LogDoor);
 
+template <>
+struct TStateControllerComponentBinding<UDoorStateControllerComponent>
+{
+	using EnumType = EDoorState;
+
+	static constexpr auto StateChanged = &UDoorStateControllerComponent::OnDoorStateChanged;
+
+	static constexpr auto StateChangedNative = &UDoorStateControllerComponent::OnDoorStateChangedNative;
+
+	static constexpr auto TransitionStarted = &UDoorStateControllerComponent::OnDoorStateTransitionStarted;
+
+	static constexpr auto TransitionStartedNative = &UDoorStateControllerComponent::OnDoorStateTransitionStartedNative;
+
+	static constexpr auto TransitionFinished = &UDoorStateControllerComponent::OnDoorStateTransitionFinished;
+
+	static constexpr auto TransitionFinishedNative =
+		&UDoorStateControllerComponent::OnDoorStateTransitionFinishedNative;
+
+	static constexpr auto TransitionReversed = &UDoorStateControllerComponent::OnDoorTransitionReversed;
+
+	static constexpr auto TransitionReversedNative = &UDoorStateControllerComponent::OnDoorTransitionReversedNative;
+
+	static void CountTransition()
+	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(DoorTransitions, 1);
+	}
+};
+
+using FDoorStateControllerCore = TStateControllerComponentCore<UDoorStateControllerComponent>;
+
 UDoorStateControllerComponent::UDoorStateControllerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UDoorStateControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UDoorStateControllerComponent, ReplicatedStates, Params);
+}
+
+void UDoorStateControllerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(FDoorStateControllerCore::GetEventsAllocatedSize(*this));
 }
 
 void UDoorStateControllerComponent::InitializeComponent()
@@ -25,6 +74,14 @@ void UDoorStateControllerComponent::InitializeComponent()
 	}
 
 	CurrentState = InitialState;
+	FDoorStateControllerCore::Register(*this);
+}
+
+void UDoorStateControllerComponent::UninitializeComponent()
+{
+	FDoorStateControllerCore::Unregister(*this);
+
+	Super::UninitializeComponent();
 }
 
 void UDoorStateControllerComponent::SetInitialState(const EDoorState NewState)
@@ -44,6 +101,36 @@ void UDoorStateControllerComponent::SetInitialState(const EDoorState NewState)
 
 	InitialState = NewState;
 	CurrentState = InitialState;
+	FDoorStateControllerCore::SyncStates(*this);
+}
+
+void UDoorStateControllerComponent::RestoreInitialState(const EDoorState NewState)
+{
+	FDoorStateControllerCore::RestoreInitialState(*this, NewState);
+}
+
+void UDoorStateControllerComponent::SetTransitionDuration(const float NewDuration)
+{
+	TransitionDuration = FMath::Max(NewDuration, 0.f);
+}
+
+void UDoorStateControllerComponent::RestoreStates(const EDoorState NewCurrentState,
+                                                  const EDoorState NewTargetState,
+                                                  const EDoorState NewLastState,
+                                                  const float TransitionTimeLeft,
+                                                  const bool bBroadcastStateChanged)
+{
+	FDoorStateControllerCore::RestoreStates(*this,
+	                                        NewCurrentState,
+	                                        NewTargetState,
+	                                        NewLastState,
+	                                        TransitionTimeLeft,
+	                                        bBroadcastStateChanged);
+}
+
+void UDoorStateControllerComponent::RestoreReplicatedStates()
+{
+	FDoorStateControllerCore::RestoreReplicatedStates(*this);
 }
 
 bool UDoorStateControllerComponent::OpenDoor_Implementation(const bool bTransitImmediately)
@@ -114,7 +201,7 @@ bool UDoorStateControllerComponent::ForceDoorState_Implementation(const EDoorSta
 		return false;
 	}
 
-	if (NewState == EDoorState::Transition)
+	if (FDoorStateController::IsTransition(NewState))
 	{
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 		PrintWarning("Can't force state to Transition");
@@ -127,100 +214,22 @@ bool UDoorStateControllerComponent::ForceDoorState_Implementation(const EDoorSta
 
 bool UDoorStateControllerComponent::FinishDoorStateTransition_Implementation()
 {
-	if (CurrentState != EDoorState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't finish transition, because CurrentState isn't Transition");
-#endif
-		return false;
-	}
-
-	if (!ChangeCurrentState(TargetState, true))
-	{
-		return false;
-	}
-
-	OnDoorStateTransitionFinished.Broadcast(this, TargetState);
-	return true;
+	return FDoorStateControllerCore::FinishTransition(*this);
 }
 
 bool UDoorStateControllerComponent::ReverseDoorStateTransition_Implementation()
 {
-	if (CurrentState != EDoorState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't reverse transition, because CurrentState is Transition");
-#endif
-		return false;
-	}
-
-	const EDoorState NewTargetState = LastState;
-	LastState = TargetState;
-	TargetState = NewTargetState;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString TargetStateName = "NONE";
-	GetStateName(TargetStateName, TargetState);
-	FString LastStateName = "NONE";
-	GetStateName(LastStateName, LastState);
-	const FString LogMessage = FString::Printf(
-		TEXT("TargetState reversed from %s to %s"), *LastStateName, *TargetStateName);
-	PrintLog(LogMessage);
-#endif
-
-	OnDoorTransitionReversed.Broadcast(this, TargetState);
-	return true;
+	return FDoorStateControllerCore::ReverseTransition(*this);
 }
 
 bool UDoorStateControllerComponent::ChangeCurrentState(const EDoorState NewState, const bool bTransitImmediately)
 {
-	if (NewState == CurrentState)
-	{
-		return false;
-	}
-
-	if (NewState == EDoorState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't change CurrentState to Transition");
-#endif
-
-		return false;
-	}
-
-	TargetState = NewState;
-	LastState = CurrentState;
-
-	if (bTransitImmediately)
-	{
-		CurrentState = TargetState;
-	}
-	else
-	{
-		CurrentState = EDoorState::Transition;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		FString TargetStateName = "NONE";
-		GetStateName(TargetStateName, TargetState);
-		FString LastStateName = "NONE";
-		GetStateName(LastStateName, LastState);
-		const FString LogMessage = FString::Printf(
-			TEXT("Start state transition from %s to %s"), *LastStateName, *TargetStateName);
-		PrintLog(LogMessage);
-#endif
-
-		OnDoorStateTransitionStarted.Broadcast(this, TargetState);
-	}
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString StateName = "NONE";
-	GetStateName(StateName, CurrentState);
-	const FString LogMessage = FString::Printf(TEXT("State changed to %s"), *StateName);
-	PrintLog(LogMessage);
-#endif
+	return FDoorStateControllerCore::ChangeState(*this, NewState, bTransitImmediately);
+}
 
-	OnDoorStateChanged.Broadcast(this, CurrentState, bTransitImmediately);
-	return true;
+void UDoorStateControllerComponent::OnRep_ReplicatedStates()
+{
+	FDoorStateControllerCore::ApplyReplicatedStates(*this);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
@@ -240,9 +249,4 @@ void UDoorStateControllerComponent::PrintLog(const FString& Message) const
 	                                              *OwnerName);
 	UE_LOG(LogDoor, Display, TEXT("%s%s"), *SourceMessage, *Message);
 }
-
-void UDoorStateControllerComponent::GetStateName(FString& StateName, const EDoorState State)
-{
-	StateName = StaticEnum<EDoorState>()->GetNameStringByValue(static_cast<int64>(State));
-}
 #endif
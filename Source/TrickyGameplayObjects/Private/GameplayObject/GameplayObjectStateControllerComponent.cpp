@@ -2,14 +2,70 @@
 
 
 #include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "StateController/StateControllerComponentCore.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "Net/UnrealNetwork.h"
 #include "GameFramework/Actor.h"
 
 DEFINE_LOG_CATEGORY(LogGameplayObject)
 
+template <>
+struct TStateControllerComponentBinding<UGameplayObjectStateControllerComponent>
+{
+	using EnumType = EGameplayObjectState;
+
+	static constexpr auto StateChanged = &UGameplayObjectStateControllerComponent::OnGameplayObjectStateChanged;
+
+	static constexpr auto StateChangedNative =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateChangedNative;
+
+	static constexpr auto TransitionStarted =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionStarted;
+
+	static constexpr auto TransitionStartedNative =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionStartedNative;
+
+	static constexpr auto TransitionFinished =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionFinished;
+
+	static constexpr auto TransitionFinishedNative =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionFinishedNative;
+
+	static constexpr auto TransitionReversed =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionReversed;
+
+	static constexpr auto TransitionReversedNative =
+		&UGameplayObjectStateControllerComponent::OnGameplayObjectStateTransitionReversedNative;
+
+	static void CountTransition()
+	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(GameplayObjectTransitions, 1);
+	}
+};
+
+using FGameplayObjectStateControllerCore = TStateControllerComponentCore<UGameplayObjectStateControllerComponent>;
+
 UGameplayObjectStateControllerComponent::UGameplayObjectStateControllerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UGameplayObjectStateControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UGameplayObjectStateControllerComponent, ReplicatedStates, Params);
+}
+
+void UGameplayObjectStateControllerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(
+		FGameplayObjectStateControllerCore::GetEventsAllocatedSize(*this));
 }
 
 void UGameplayObjectStateControllerComponent::InitializeComponent()
@@ -25,6 +81,14 @@ void UGameplayObjectStateControllerComponent::InitializeComponent()
 	}
 
 	CurrentState = InitialState;
+	FGameplayObjectStateControllerCore::Register(*this);
+}
+
+void UGameplayObjectStateControllerComponent::UninitializeComponent()
+{
+	FGameplayObjectStateControllerCore::Unregister(*this);
+
+	Super::UninitializeComponent();
 }
 
 void UGameplayObjectStateControllerComponent::SetInitialState(const EGameplayObjectState NewState)
@@ -44,6 +108,31 @@ void UGameplayObjectStateControllerComponent::SetInitialState(const EGameplayObj
 
 	InitialState = NewState;
 	CurrentState = InitialState;
+	FGameplayObjectStateControllerCore::SyncStates(*this);
+}
+
+void UGameplayObjectStateControllerComponent::RestoreInitialState(const EGameplayObjectState NewState)
+{
+	FGameplayObjectStateControllerCore::RestoreInitialState(*this, NewState);
+}
+
+void UGameplayObjectStateControllerComponent::SetTransitionDuration(const float NewDuration)
+{
+	TransitionDuration = FMath::Max(NewDuration, 0.f);
+}
+
+void UGameplayObjectStateControllerComponent::RestoreStates(const EGameplayObjectState NewCurrentState,
+                                                            const EGameplayObjectState NewTargetState,
+                                                            const EGameplayObjectState NewLastState,
+                                                            const float TransitionTimeLeft,
+                                                            const bool bBroadcastStateChanged)
+{
+	FGameplayObjectStateControllerCore::RestoreStates(*this,
+	                                                  NewCurrentState,
+	                                                  NewTargetState,
+	                                                  NewLastState,
+	                                                  TransitionTimeLeft,
+	                                                  bBroadcastStateChanged);
 }
 
 bool UGameplayObjectStateControllerComponent::ActivateGameplayObject_Implementation(const bool bTransitImmediately)
@@ -94,7 +183,7 @@ bool UGameplayObjectStateControllerComponent::ForceGameplayObjectState_Implement
 		return false;
 	}
 
-	if (NewState == EGameplayObjectState::Transition)
+	if (FGameplayObjectStateController::IsTransition(NewState))
 	{
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 		PrintWarning("Can't force state to Transition");
@@ -107,95 +196,23 @@ bool UGameplayObjectStateControllerComponent::ForceGameplayObjectState_Implement
 
 bool UGameplayObjectStateControllerComponent::FinishGameplayObjetStateTransition_Implementation()
 {
-	if (CurrentState != EGameplayObjectState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't finish transition, because CurrentState isn't Transition");
-#endif
-		return false;
-	}
-
-	return ChangeCurrentState(TargetState, true);
+	return FGameplayObjectStateControllerCore::FinishTransition(*this);
 }
 
 bool UGameplayObjectStateControllerComponent::ReverseGameplayObjectStateTransition_Implementation()
 {
-	if (CurrentState != EGameplayObjectState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't reverse transition, because CurrentState is Transition");
-#endif
-		return false;
-	}
-
-	const EGameplayObjectState NewTargetState = LastState;
-	LastState = TargetState;
-	TargetState = NewTargetState;
-	
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString TargetStateName = "NONE";
-	GetStateName(TargetStateName, TargetState);
-	FString LastStateName = "NONE";
-	GetStateName(LastStateName, LastState);
-	const FString LogMessage = FString::Printf(
-		TEXT("TargetState reversed from %s to %s"), *LastStateName, *TargetStateName);
-	PrintLog(LogMessage);
-#endif
-	
-	OnGameplayObjectStateTransitionReversed.Broadcast(this, TargetState);
-	return true;
+	return FGameplayObjectStateControllerCore::ReverseTransition(*this);
 }
 
 bool UGameplayObjectStateControllerComponent::ChangeCurrentState(const EGameplayObjectState NewState,
                                                                  const bool bTransitImmediately)
 {
-	if (NewState == CurrentState)
-	{
-		return false;
-	}
-
-	if (NewState == EGameplayObjectState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't change CurrentState to Transition");
-#endif
-		
-		return false;
-	}
-
-	TargetState = NewState;
-	LastState = CurrentState;
-
-	if (bTransitImmediately)
-	{
-		CurrentState = TargetState;
-	}
-	else
-	{
-		CurrentState = EGameplayObjectState::Transition;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		FString TargetStateName = "NONE";
-		GetStateName(TargetStateName, TargetState);
-		FString LastStateName = "NONE";
-		GetStateName(LastStateName, LastState);
-		const FString LogMessage = FString::Printf(
-			TEXT("Start state transition from %s to %s"), *LastStateName, *TargetStateName);
-		PrintLog(LogMessage);
-#endif
-		
-		OnGameplayObjectStateTransitionStarted.Broadcast(this, TargetState);
-	}
+	return FGameplayObjectStateControllerCore::ChangeState(*this, NewState, bTransitImmediately);
+}
 
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString StateName = "NONE";
-	GetStateName(StateName, CurrentState);
-	const FString LogMessage = FString::Printf(TEXT("State changed to %s"), *StateName);
-	PrintLog(LogMessage);
-#endif
-	
-	OnGameplayObjectStateChanged.Broadcast(this, CurrentState, bTransitImmediately);
-	return true;
+void UGameplayObjectStateControllerComponent::OnRep_ReplicatedStates()
+{
+	FGameplayObjectStateControllerCore::ApplyReplicatedStates(*this);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
@@ -215,9 +232,4 @@ void UGameplayObjectStateControllerComponent::PrintLog(const FString& Message) c
 	                                              *OwnerName);
 	UE_LOG(LogGameplayObject, Display, TEXT("%s%s"), *SourceMessage, *Message);
 }
-
-void UGameplayObjectStateControllerComponent::GetStateName(FString& StateName, const EGameplayObjectState State)
-{
-	StateName = StaticEnum<EGameplayObjectState>()->GetNameStringByValue(static_cast<int64>(State));
-}
 #endif
@@ -7,13 +7,64 @@
 #include "LockKey/KeyringComponent.h"
 #include "LockKey/KeyringInterface.h"
 #include "LockKey/LockKeyType.h"
+#include "StateController/NativeInterfaceDispatch.h"
+#include "StateController/StateControllerComponentCore.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "TrickyGameplayObjectsTrace.h"
+#include "Net/UnrealNetwork.h"
 
 DEFINE_LOG_CATEGORY(LogLock);
 
+template <>
+struct TStateControllerComponentBinding<ULockStateControllerComponent>
+{
+	using EnumType = ELockState;
+
+	static constexpr auto StateChanged = &ULockStateControllerComponent::OnLockStateChanged;
+
+	static constexpr auto StateChangedNative = &ULockStateControllerComponent::OnLockStateChangedNative;
+
+	static constexpr auto TransitionStarted = &ULockStateControllerComponent::OnLockStateTransitionStarted;
+
+	static constexpr auto TransitionStartedNative = &ULockStateControllerComponent::OnLockStateTransitionStartedNative;
+
+	static constexpr auto TransitionFinished = &ULockStateControllerComponent::OnLockStateTransitionFinished;
+
+	static constexpr auto TransitionFinishedNative =
+		&ULockStateControllerComponent::OnLockStateTransitionFinishedNative;
+
+	static constexpr auto TransitionReversed = &ULockStateControllerComponent::OnLockTransitionReversed;
+
+	static constexpr auto TransitionReversedNative = &ULockStateControllerComponent::OnLockTransitionReversedNative;
+
+	static void CountTransition()
+	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(LockTransitions, 1);
+	}
+};
+
+using FLockStateControllerCore = TStateControllerComponentCore<ULockStateControllerComponent>;
+
 ULockStateControllerComponent::ULockStateControllerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void ULockStateControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ULockStateControllerComponent, ReplicatedStates, Params);
+}
+
+void ULockStateControllerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(FLockStateControllerCore::GetEventsAllocatedSize(*this));
 }
 
 void ULockStateControllerComponent::InitializeComponent()
@@ -29,6 +80,14 @@ void ULockStateControllerComponent::InitializeComponent()
 	}
 
 	CurrentState = InitialState;
+	FLockStateControllerCore::Register(*this);
+}
+
+void ULockStateControllerComponent::UninitializeComponent()
+{
+	FLockStateControllerCore::Unregister(*this);
+
+	Super::UninitializeComponent();
 }
 
 void ULockStateControllerComponent::SetRequiredKey(const TSubclassOf<ULockKeyType>& NewKey)
@@ -36,6 +95,34 @@ void ULockStateControllerComponent::SetRequiredKey(const TSubclassOf<ULockKeyTyp
 	RequiredKey = NewKey;
 }
 
+bool ULockStateControllerComponent::HasRequiredKey(const AActor* OtherActor) const
+{
+	if (!IsValid(OtherActor) || !IsValid(RequiredKey))
+	{
+		return false;
+	}
+
+	const UKeyringComponent* KeyringComponent = OtherActor->FindComponentByClass<UKeyringComponent>();
+
+	if (!IsValid(KeyringComponent))
+	{
+		return false;
+	}
+
+	if (bMatchKeyHierarchy)
+	{
+		return KeyringComponent->HasMatchingLockKey(RequiredKey);
+	}
+
+	if (const IKeyringInterface* Keyring = FNativeInterfaceDispatch::GetNativeInterface<IKeyringInterface>(
+		KeyringComponent, GET_FUNCTION_NAME_CHECKED(IKeyringInterface, HasLockKey)))
+	{
+		return Keyring->HasLockKey_Implementation(RequiredKey);
+	}
+
+	return IKeyringInterface::Execute_HasLockKey(KeyringComponent, RequiredKey);
+}
+
 void ULockStateControllerComponent::SetInitialState(const ELockState NewState)
 {
 	if (InitialState == ELockState::Transition)
@@ -48,6 +135,31 @@ void ULockStateControllerComponent::SetInitialState(const ELockState NewState)
 
 	InitialState = NewState;
 	CurrentState = InitialState;
+	FLockStateControllerCore::SyncStates(*this);
+}
+
+void ULockStateControllerComponent::RestoreInitialState(const ELockState NewState)
+{
+	FLockStateControllerCore::RestoreInitialState(*this, NewState);
+}
+
+void ULockStateControllerComponent::SetTransitionDuration(const float NewDuration)
+{
+	TransitionDuration = FMath::Max(NewDuration, 0.f);
+}
+
+void ULockStateControllerComponent::RestoreStates(const ELockState NewCurrentState,
+                                                  const ELockState NewTargetState,
+                                                  const ELockState NewLastState,
+                                                  const float TransitionTimeLeft,
+                                                  const bool bBroadcastStateChanged)
+{
+	FLockStateControllerCore::RestoreStates(*this,
+	                                        NewCurrentState,
+	                                        NewTargetState,
+	                                        NewLastState,
+	                                        TransitionTimeLeft,
+	                                        bBroadcastStateChanged);
 }
 
 bool ULockStateControllerComponent::Lock_Implementation(AActor* OtherActor,
@@ -58,11 +170,19 @@ bool ULockStateControllerComponent::Lock_Implementation(AActor* OtherActor,
 		return false;
 	}
 
-	if (!TryUseKeyFromActor(OtherActor))
+	const bool bUsedKey = TryUseKeyFromActor(OtherActor);
+	TRACE_LOCK_ATTEMPT(this, OtherActor, bUsedKey);
+
+	if (!bUsedKey)
 	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(FailedLockAttempts, 1);
 		return false;
 	}
 
+#if WITH_STATE_CONTROLLER_HISTORY
+	FStateControllerHistoryInstigatorScope InstigatorScope(OtherActor);
+#endif
+
 	return ChangeCurrentState(ELockState::Locked, bTransitImmediately);
 }
 
@@ -74,11 +194,19 @@ bool ULockStateControllerComponent::Unlock_Implementation(AActor* OtherActor,
 		return false;
 	}
 
-	if (!TryUseKeyFromActor(OtherActor))
+	const bool bUsedKey = TryUseKeyFromActor(OtherActor);
+	TRACE_LOCK_ATTEMPT(this, OtherActor, bUsedKey);
+
+	if (!bUsedKey)
 	{
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(FailedLockAttempts, 1);
 		return false;
 	}
 
+#if WITH_STATE_CONTROLLER_HISTORY
+	FStateControllerHistoryInstigatorScope InstigatorScope(OtherActor);
+#endif
+
 	return ChangeCurrentState(ELockState::Unlocked, bTransitImmediately);
 }
 
@@ -110,7 +238,7 @@ bool ULockStateControllerComponent::ForceLockState_Implementation(const ELockSta
 		return false;
 	}
 
-	if (NewState == ELockState::Transition)
+	if (FLockStateController::IsTransition(NewState))
 	{
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 		PrintWarning("Can't force state to Transition");
@@ -123,116 +251,57 @@ bool ULockStateControllerComponent::ForceLockState_Implementation(const ELockSta
 
 bool ULockStateControllerComponent::FinishLockStateTransition_Implementation()
 {
-	if (CurrentState != ELockState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't finish transition, because CurrentState isn't Transition");
-#endif
-		return false;
-	}
-
-	if (!ChangeCurrentState(TargetState, true))
-	{
-		return false;
-	}
-
-	OnLockStateTransitionFinished.Broadcast(this, TargetState);
-	return true;
+	return FLockStateControllerCore::FinishTransition(*this);
 }
 
 bool ULockStateControllerComponent::ReverseLockStateTransition_Implementation()
 {
-	if (CurrentState != ELockState::Transition)
-	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't reverse transition, because CurrentState is Transition");
-#endif
-		return false;
-	}
-
-	const ELockState NewTargetState = LastState;
-	LastState = TargetState;
-	TargetState = NewTargetState;
-
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString TargetStateName = "NONE";
-	GetStateName(TargetStateName, TargetState);
-	FString LastStateName = "NONE";
-	GetStateName(LastStateName, LastState);
-	const FString LogMessage = FString::Printf(
-		TEXT("TargetState reversed from %s to %s"), *LastStateName, *TargetStateName);
-	PrintLog(LogMessage);
-#endif
-
-	OnLockTransitionReversed.Broadcast(this, TargetState);
-	return true;
+	return FLockStateControllerCore::ReverseTransition(*this);
 }
 
 bool ULockStateControllerComponent::ChangeCurrentState(const ELockState NewState, const bool bTransitImmediately)
 {
-	if (CurrentState == NewState)
+	return FLockStateControllerCore::ChangeState(*this, NewState, bTransitImmediately);
+}
+
+bool ULockStateControllerComponent::TryUseKeyFromActor(const AActor* OtherActor)
+{
+	if (!IsValid(OtherActor) || !IsValid(RequiredKey))
 	{
 		return false;
 	}
 
-	if (NewState == ELockState::Transition)
+	UKeyringComponent* KeyringComponent = OtherActor->FindComponentByClass<UKeyringComponent>();
+	
+	if (!IsValid(KeyringComponent))
 	{
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		PrintWarning("Can't change CurrentState to Transition");
-#endif
 		return false;
 	}
 
-	TargetState = NewState;
-	LastState = CurrentState;
+	TSubclassOf<ULockKeyType> LockKey = RequiredKey;
 
-	if (bTransitImmediately)
+	if (bMatchKeyHierarchy)
 	{
-		CurrentState = TargetState;
-	}
-	else
-	{
-		CurrentState = ELockState::Transition;
+		LockKey = KeyringComponent->FindMatchingLockKey(RequiredKey);
 
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-		FString TargetStateName = "NONE";
-		GetStateName(TargetStateName, TargetState);
-		FString LastStateName = "NONE";
-		GetStateName(LastStateName, LastState);
-		const FString LogMessage = FString::Printf(
-			TEXT("Start state transition from %s to %s"), *LastStateName, *TargetStateName);
-		PrintLog(LogMessage);
-#endif
-
-		OnLockStateTransitionStarted.Broadcast(this, TargetState);
+		if (!IsValid(LockKey))
+		{
+			return false;
+		}
 	}
 
-#if WITH_EDITOR || !UE_BUILD_SHIPPING
-	FString StateName = "NONE";
-	GetStateName(StateName, CurrentState);
-	const FString LogMessage = FString::Printf(TEXT("State changed to %s"), *StateName);
-	PrintLog(LogMessage);
-#endif
-	
-	OnLockStateChanged.Broadcast(this, CurrentState, bTransitImmediately);
-	return true;
-}
-
-bool ULockStateControllerComponent::TryUseKeyFromActor(const AActor* OtherActor)
-{
-	if (!IsValid(OtherActor) || !IsValid(RequiredKey))
+	if (IKeyringInterface* Keyring = FNativeInterfaceDispatch::GetNativeInterface<IKeyringInterface>(
+		KeyringComponent, GET_FUNCTION_NAME_CHECKED(IKeyringInterface, UseLockKey)))
 	{
-		return false;
+		return Keyring->UseLockKey_Implementation(LockKey);
 	}
 
-	UKeyringComponent* KeyringComponent = OtherActor->FindComponentByClass<UKeyringComponent>();
-	
-	if (!IsValid(KeyringComponent))
-	{
-		return false;
-	}
+	return IKeyringInterface::Execute_UseLockKey(KeyringComponent, LockKey);
+}
 
-	return IKeyringInterface::Execute_UseLockKey(KeyringComponent, RequiredKey);
+void ULockStateControllerComponent::OnRep_ReplicatedStates()
+{
+	FLockStateControllerCore::ApplyReplicatedStates(*this);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
@@ -252,9 +321,4 @@ void ULockStateControllerComponent::PrintLog(const FString& Message) const
 	                                              *OwnerName);
 	UE_LOG(LogLock, Display, TEXT("%s%s"), *SourceMessage, *Message);
 }
-
-void ULockStateControllerComponent::GetStateName(FString& StateName, const ELockState State)
-{
-	StateName = StaticEnum<ELockState>()->GetNameStringByValue(static_cast<int64>(State));
-}
 #endif
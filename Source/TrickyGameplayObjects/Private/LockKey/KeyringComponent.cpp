@@ -5,6 +5,11 @@
 #include "GameFramework/Actor.h"
 
 #include "LockKey/LockKeyType.h"
+#include "LockKey/LockKeyTypeRegistry.h"
+#include "StateController/NativeInterfaceDispatch.h"
+#include "TrickyGameplayObjectsLog.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "TrickyGameplayObjectsTrace.h"
 
 DEFINE_LOG_CATEGORY(LogKeyRing);
 
@@ -14,6 +19,21 @@ UKeyringComponent::UKeyringComponent()
 	bWantsInitializeComponent = true;
 }
 
+void UKeyringComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	// Includes the slack of AcquiredKeys.
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(AcquiredKeys.GetAllocatedSize()
+		+ AcquiredKeyBits.GetAllocatedSize()
+		+ AcquiredKeyBitsView.GetAllocatedSize()
+		+ StackedKeyCounts.GetAllocatedSize()
+		+ OnLockKeyAdded.GetAllocatedSize()
+		+ OnLockKeyRemoved.GetAllocatedSize()
+		+ OnAllLockKeysRemoved.GetAllocatedSize()
+		+ OnLockKeyUsed.GetAllocatedSize());
+}
+
 void UKeyringComponent::InitializeComponent()
 {
 	Super::InitializeComponent();
@@ -21,17 +41,69 @@ void UKeyringComponent::InitializeComponent()
 
 void UKeyringComponent::GetAcquiredLockKeys_Implementation(TArray<TSubclassOf<ULockKeyType>>& AcquiredLockKeys) const
 {
-	AcquiredLockKeys = AcquiredKeys;
+	if (StorageMode == EKeyringStorageMode::Array && StackedKeyCounts.Num() == 0)
+	{
+		AcquiredLockKeys = AcquiredKeys;
+		return;
+	}
+
+	AcquiredLockKeys.Reset();
+
+	auto AddLockKeys = [this, &AcquiredLockKeys](const TSubclassOf<ULockKeyType>& LockKey)
+	{
+		const int32 Count = GetStackCount(LockKey);
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			AcquiredLockKeys.Add(LockKey);
+		}
+	};
+
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		for (const TSubclassOf<ULockKeyType>& LockKey : AcquiredKeys)
+		{
+			AddLockKeys(LockKey);
+		}
+
+		return;
+	}
+
+	for (TConstSetBitIterator<> It(AcquiredKeyBits); It; ++It)
+	{
+		if (const TSubclassOf<ULockKeyType> LockKey = FLockKeyTypeRegistry::GetKeyClass(It.GetIndex()))
+		{
+			AddLockKeys(LockKey);
+		}
+	}
 }
 
 bool UKeyringComponent::AddLockKey_Implementation(const TSubclassOf<ULockKeyType> LockKey)
 {
-	if (Execute_HasLockKey(this, LockKey))
+	if (HasLockKeyDispatched(LockKey))
 	{
-		return false;
+		const int32 Count = StackLockKey(LockKey);
+
+		if (Count == INDEX_NONE)
+		{
+			return false;
+		}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+		if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+		{
+			const FString LogMessage = FString::Printf(TEXT("LockKey Stacked: %s | Count: %d"),
+			                                           *LockKey->GetName(),
+			                                           Count);
+			PrintLog(LogMessage);
+		}
+#endif
+
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnLockKeyAdded, this, LockKey);
+		return true;
 	}
 
-	const int32 Index = AcquiredKeys.AddUnique(LockKey);
+	const int32 Index = AddToStorage(LockKey);
 
 	if (Index == INDEX_NONE)
 	{
@@ -39,73 +111,508 @@ bool UKeyringComponent::AddLockKey_Implementation(const TSubclassOf<ULockKeyType
 	}
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
-	const FString LogMessage = FString::Printf(TEXT("New LockKey Added: %s | Index: %d"), *LockKey->GetName(), Index);
-	PrintLog(LogMessage);
+	if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+	{
+		const FString LogMessage = FString::Printf(TEXT("New LockKey Added: %s | Index: %d"), *LockKey->GetName(), Index);
+		PrintLog(LogMessage);
+	}
 #endif
 	
-	OnLockKeyAdded.Broadcast(this, LockKey);
+	TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnLockKeyAdded, this, LockKey);
 	return true;
 }
 
 bool UKeyringComponent::RemoveLockKey_Implementation(const TSubclassOf<ULockKeyType> LockKey)
 {
-	if (!Execute_HasLockKey(this, LockKey))
+	if (!HasLockKeyDispatched(LockKey))
 	{
 		return false;
 	}
 
-	const int32 Num = AcquiredKeys.Remove(LockKey);
-
-	if (Num == 0)
+	if (!RemoveOneFromStorage(LockKey))
 	{
 		return false;
 	}
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
-	const FString LogMessage = FString::Printf(TEXT("Removed LockKey: %s"), *LockKey->GetName());
-	PrintLog(LogMessage);
+	if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+	{
+		const FString LogMessage = FString::Printf(TEXT("Removed LockKey: %s"), *LockKey->GetName());
+		PrintLog(LogMessage);
+	}
 #endif
 	
-	OnLockKeyRemoved.Broadcast(this, LockKey);
+	TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnLockKeyRemoved, this, LockKey);
 	return true;
 }
 
 bool UKeyringComponent::RemoveAllLockKeys_Implementation()
 {
-	if (AcquiredKeys.IsEmpty())
+	if (IsStorageEmpty())
 	{
 		return false;
 	}
 
-	AcquiredKeys.Empty();
+	ClearStorage();
 	
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
-	PrintLog("Removed all acquired LockKeys");
+	if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+	{
+		PrintLog("Removed all acquired LockKeys");
+	}
 #endif
 	
-	OnAllLockKeysRemoved.Broadcast(this);
+	TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnAllLockKeysRemoved, this);
 	return true;
 }
 
 bool UKeyringComponent::UseLockKey_Implementation(const TSubclassOf<ULockKeyType> LockKey)
 {
-	if (!Execute_HasLockKey(this, LockKey))
+	if (!HasLockKeyDispatched(LockKey))
 	{
 		return false;
 	}
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
-	const FString LogMessage = FString::Printf(TEXT("LockKey Used: %s"), *LockKey->GetName());
-	PrintLog(LogMessage);
+	if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+	{
+		const FString LogMessage = FString::Printf(TEXT("LockKey Used: %s"), *LockKey->GetName());
+		PrintLog(LogMessage);
+	}
 #endif
 	
-	OnLockKeyUsed.Broadcast(this, LockKey);
+	TRACE_LOCK_KEY_USED(this, LockKey);
+	TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnLockKeyUsed, this, LockKey);
+
+	if (IsValid(LockKey) && GetDefault<ULockKeyType>(LockKey)->GetConsumedOnUse() && RemoveOneFromStorage(LockKey))
+	{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+		if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+		{
+			const FString LogMessage = FString::Printf(TEXT("Consumed LockKey: %s"), *LockKey->GetName());
+			PrintLog(LogMessage);
+		}
+#endif
+
+		bIsConsumingLockKey = true;
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnLockKeyRemoved, this, LockKey);
+		bIsConsumingLockKey = false;
+	}
+
 	return true;
 }
 
 bool UKeyringComponent::HasLockKey_Implementation(const TSubclassOf<ULockKeyType> LockKey) const
 {
-	return IsValid(LockKey) && !AcquiredKeys.IsEmpty() && AcquiredKeys.Contains(LockKey);
+	TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(KeyringLookups, 1);
+	return IsValid(LockKey) && ContainsLockKey(LockKey);
+}
+
+bool UKeyringComponent::HasAllLockKeys(const TArray<TSubclassOf<ULockKeyType>>& LockKeys) const
+{
+	if (StorageMode == EKeyringStorageMode::Bitset)
+	{
+		return HasAllLockKeyBits(MakeLockKeyBits(LockKeys));
+	}
+
+	for (const TSubclassOf<ULockKeyType>& LockKey : LockKeys)
+	{
+		if (IsValid(LockKey) && !ContainsLockKey(LockKey))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool UKeyringComponent::HasAnyLockKey(const TArray<TSubclassOf<ULockKeyType>>& LockKeys) const
+{
+	if (IsStorageEmpty())
+	{
+		return false;
+	}
+
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		// A single pass over the acquired keys, which are usually fewer than the keys a lock or a quest asks for.
+		return AcquiredKeys.ContainsByPredicate([&LockKeys](const TSubclassOf<ULockKeyType>& LockKey)
+		{
+			return LockKeys.Contains(LockKey);
+		});
+	}
+
+	return HasAnyLockKeyBits(MakeLockKeyBits(LockKeys));
+}
+
+int32 UKeyringComponent::GetLockKeyCount(const TSubclassOf<ULockKeyType> LockKey) const
+{
+	return IsValid(LockKey) && ContainsLockKey(LockKey) ? GetStackCount(LockKey) : 0;
+}
+
+int32 UKeyringComponent::GetNumLockKeysOfClass(const TSubclassOf<ULockKeyType> BaseClass) const
+{
+	if (!IsValid(BaseClass))
+	{
+		return 0;
+	}
+
+	int32 Num = 0;
+
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		for (const TSubclassOf<ULockKeyType>& LockKey : AcquiredKeys)
+		{
+			Num += LockKey && LockKey->IsChildOf(BaseClass) ? GetStackCount(LockKey) : 0;
+		}
+
+		return Num;
+	}
+
+	for (TConstSetBitIterator<> It(AcquiredKeyBits); It; ++It)
+	{
+		const TSubclassOf<ULockKeyType> LockKey = FLockKeyTypeRegistry::GetKeyClass(It.GetIndex());
+		Num += LockKey && LockKey->IsChildOf(BaseClass) ? GetStackCount(LockKey) : 0;
+	}
+
+	return Num;
+}
+
+bool UKeyringComponent::HasMatchingLockKey(const TSubclassOf<ULockKeyType> RequiredKey) const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return FindMatchingLockKey(RequiredKey) != nullptr;
+	}
+
+	const int32 RequiredKeyId = FLockKeyTypeRegistry::FindKeyId(RequiredKey);
+	return RequiredKeyId != INDEX_NONE && HasAnyLockKeyBits(FLockKeyTypeRegistry::GetMatchingKeyBits(RequiredKeyId));
+}
+
+TSubclassOf<ULockKeyType> UKeyringComponent::FindMatchingLockKey(const TSubclassOf<ULockKeyType> RequiredKey) const
+{
+	if (!IsValid(RequiredKey) || IsStorageEmpty())
+	{
+		return nullptr;
+	}
+
+	if (ContainsLockKey(RequiredKey))
+	{
+		return RequiredKey;
+	}
+
+	const int32 RequiredKeyId = FLockKeyTypeRegistry::FindKeyId(RequiredKey);
+
+	if (RequiredKeyId == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const TBitArray<>& MatchingKeyBits = FLockKeyTypeRegistry::GetMatchingKeyBits(RequiredKeyId);
+	int32 MatchingKeyId = INDEX_NONE;
+
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		for (const TSubclassOf<ULockKeyType>& LockKey : AcquiredKeys)
+		{
+			const int32 KeyId = FLockKeyTypeRegistry::FindKeyId(LockKey);
+
+			if (MatchingKeyBits.IsValidIndex(KeyId) && MatchingKeyBits[KeyId]
+				&& (MatchingKeyId == INDEX_NONE || KeyId < MatchingKeyId))
+			{
+				MatchingKeyId = KeyId;
+			}
+		}
+
+		return FLockKeyTypeRegistry::GetKeyClass(MatchingKeyId);
+	}
+
+	const uint32* MatchingWords = MatchingKeyBits.GetData();
+	const uint32* AcquiredWords = AcquiredKeyBits.GetData();
+	const int32 NumWords = FMath::Min(FBitSet::CalculateNumWords(MatchingKeyBits.Num()),
+	                                  FBitSet::CalculateNumWords(AcquiredKeyBits.Num()));
+
+	for (int32 Index = 0; Index < NumWords; ++Index)
+	{
+		if (const uint32 Word = MatchingWords[Index] & AcquiredWords[Index]; Word != 0)
+		{
+			MatchingKeyId = Index * NumBitsPerDWORD + FMath::CountTrailingZeros(Word);
+			break;
+		}
+	}
+
+	return FLockKeyTypeRegistry::GetKeyClass(MatchingKeyId);
+}
+
+bool UKeyringComponent::HasAllLockKeyBits(const TBitArray<>& KeyBits) const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		for (TConstSetBitIterator<> It(KeyBits); It; ++It)
+		{
+			if (!ContainsLockKey(FLockKeyTypeRegistry::GetKeyClass(It.GetIndex())))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const uint32* RequiredWords = KeyBits.GetData();
+	const uint32* AcquiredWords = AcquiredKeyBits.GetData();
+	const int32 NumRequiredWords = FBitSet::CalculateNumWords(KeyBits.Num());
+	const int32 NumAcquiredWords = FBitSet::CalculateNumWords(AcquiredKeyBits.Num());
+
+	for (int32 Index = 0; Index < NumRequiredWords; ++Index)
+	{
+		const uint32 AcquiredWord = Index < NumAcquiredWords ? AcquiredWords[Index] : 0;
+
+		if ((RequiredWords[Index] & ~AcquiredWord) != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool UKeyringComponent::HasAnyLockKeyBits(const TBitArray<>& KeyBits) const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		for (TConstSetBitIterator<> It(KeyBits); It; ++It)
+		{
+			if (ContainsLockKey(FLockKeyTypeRegistry::GetKeyClass(It.GetIndex())))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	const uint32* RequiredWords = KeyBits.GetData();
+	const uint32* AcquiredWords = AcquiredKeyBits.GetData();
+	const int32 NumWords = FMath::Min(FBitSet::CalculateNumWords(KeyBits.Num()),
+	                                  FBitSet::CalculateNumWords(AcquiredKeyBits.Num()));
+
+	for (int32 Index = 0; Index < NumWords; ++Index)
+	{
+		if ((RequiredWords[Index] & AcquiredWords[Index]) != 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+TConstArrayView<TSubclassOf<ULockKeyType>> UKeyringComponent::GetAcquiredLockKeysView() const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return AcquiredKeys;
+	}
+
+	if (bIsAcquiredKeyBitsViewDirty)
+	{
+		AcquiredKeyBitsView.Reset();
+
+		for (TConstSetBitIterator<> It(AcquiredKeyBits); It; ++It)
+		{
+			if (const TSubclassOf<ULockKeyType> LockKey = FLockKeyTypeRegistry::GetKeyClass(It.GetIndex()))
+			{
+				AcquiredKeyBitsView.Add(LockKey);
+			}
+		}
+
+		bIsAcquiredKeyBitsViewDirty = false;
+	}
+
+	return AcquiredKeyBitsView;
+}
+
+void UKeyringComponent::RestoreLockKeys(TArray<TSubclassOf<ULockKeyType>> LockKeys)
+{
+	ClearStorage();
+
+	for (const TSubclassOf<ULockKeyType>& LockKey : LockKeys)
+	{
+		if (!IsValid(LockKey))
+		{
+			continue;
+		}
+
+		if (ContainsLockKey(LockKey))
+		{
+			StackLockKey(LockKey);
+		}
+		else
+		{
+			AddToStorage(LockKey);
+		}
+	}
+}
+
+void UKeyringComponent::SetStorageMode(const EKeyringStorageMode Value)
+{
+	if (StorageMode == Value)
+	{
+		return;
+	}
+
+	TArray<TSubclassOf<ULockKeyType>> LockKeys;
+	GetAcquiredLockKeys_Implementation(LockKeys);
+	ClearStorage();
+	StorageMode = Value;
+	RestoreLockKeys(MoveTemp(LockKeys));
+}
+
+bool UKeyringComponent::IsStorageEmpty() const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return AcquiredKeys.IsEmpty();
+	}
+
+	return !AcquiredKeyBits.Contains(true);
+}
+
+bool UKeyringComponent::ContainsLockKey(const TSubclassOf<ULockKeyType>& LockKey) const
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return !AcquiredKeys.IsEmpty() && AcquiredKeys.Contains(LockKey);
+	}
+
+	const int32 KeyId = FLockKeyTypeRegistry::FindKeyId(LockKey);
+	return AcquiredKeyBits.IsValidIndex(KeyId) && AcquiredKeyBits[KeyId];
+}
+
+int32 UKeyringComponent::AddToStorage(const TSubclassOf<ULockKeyType>& LockKey)
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return AcquiredKeys.AddUnique(LockKey);
+	}
+
+	const int32 KeyId = FLockKeyTypeRegistry::GetKeyId(LockKey);
+
+	if (KeyId == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	if (!AcquiredKeyBits.IsValidIndex(KeyId))
+	{
+		// Sized for all the registered keys at once to avoid growing the bitset key by key.
+		AcquiredKeyBits.SetNum(FMath::Max(FLockKeyTypeRegistry::GetNumKeyTypes(), KeyId + 1), false);
+	}
+
+	AcquiredKeyBits[KeyId] = true;
+	bIsAcquiredKeyBitsViewDirty = true;
+	return KeyId;
+}
+
+bool UKeyringComponent::RemoveFromStorage(const TSubclassOf<ULockKeyType>& LockKey)
+{
+	if (StorageMode == EKeyringStorageMode::Array)
+	{
+		return AcquiredKeys.Remove(LockKey) > 0;
+	}
+
+	const int32 KeyId = FLockKeyTypeRegistry::FindKeyId(LockKey);
+
+	if (!AcquiredKeyBits.IsValidIndex(KeyId) || !AcquiredKeyBits[KeyId])
+	{
+		return false;
+	}
+
+	AcquiredKeyBits[KeyId] = false;
+	bIsAcquiredKeyBitsViewDirty = true;
+	return true;
+}
+
+void UKeyringComponent::ClearStorage()
+{
+	AcquiredKeys.Empty();
+	AcquiredKeyBits.Empty();
+	AcquiredKeyBitsView.Empty();
+	StackedKeyCounts.Empty();
+	bIsAcquiredKeyBitsViewDirty = false;
+}
+
+int32 UKeyringComponent::GetStackCount(const TSubclassOf<ULockKeyType>& LockKey) const
+{
+	if (StackedKeyCounts.Num() == 0)
+	{
+		return 1;
+	}
+
+	const int32* Count = StackedKeyCounts.Find(FLockKeyTypeRegistry::FindKeyId(LockKey));
+	return Count ? *Count : 1;
+}
+
+int32 UKeyringComponent::StackLockKey(const TSubclassOf<ULockKeyType>& LockKey)
+{
+	if (!IsValid(LockKey) || !ContainsLockKey(LockKey))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Count = GetStackCount(LockKey);
+
+	if (Count >= GetDefault<ULockKeyType>(LockKey)->GetMaxStackSize())
+	{
+		return INDEX_NONE;
+	}
+
+	StackedKeyCounts.Add(FLockKeyTypeRegistry::GetKeyId(LockKey), Count + 1);
+	return Count + 1;
+}
+
+bool UKeyringComponent::RemoveOneFromStorage(const TSubclassOf<ULockKeyType>& LockKey)
+{
+	const int32 Count = GetStackCount(LockKey);
+
+	if (Count <= 1)
+	{
+		return RemoveFromStorage(LockKey);
+	}
+
+	const int32 KeyId = FLockKeyTypeRegistry::FindKeyId(LockKey);
+
+	if (Count == 2)
+	{
+		StackedKeyCounts.Remove(KeyId);
+	}
+	else
+	{
+		StackedKeyCounts.Add(KeyId, Count - 1);
+	}
+
+	return true;
+}
+
+const TBitArray<>& UKeyringComponent::MakeLockKeyBits(const TArray<TSubclassOf<ULockKeyType>>& LockKeys)
+{
+	// Reused to avoid allocating on every call, the registry is used only from the game thread anyway.
+	static TBitArray<> KeyBits;
+	FLockKeyTypeRegistry::MakeKeyBits(LockKeys, KeyBits);
+	return KeyBits;
+}
+
+bool UKeyringComponent::HasLockKeyDispatched(const TSubclassOf<ULockKeyType>& LockKey) const
+{
+	static const FName FunctionName = GET_FUNCTION_NAME_CHECKED(IKeyringInterface, HasLockKey);
+
+	if (FNativeInterfaceDispatch::IsNativeImplementation(GetClass(), FunctionName))
+	{
+		return HasLockKey_Implementation(LockKey);
+	}
+
+	return Execute_HasLockKey(this, LockKey);
 }
 
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
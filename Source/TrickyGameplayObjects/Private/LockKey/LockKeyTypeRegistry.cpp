@@ -0,0 +1,367 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "LockKey/LockKeyTypeRegistry.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "HAL/IConsoleManager.h"
+#include "LockKey/LockKeyType.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectIterator.h"
+
+namespace LockKeyTypeRegistry
+{
+	static TArray<FTopLevelAssetPath> KeyPaths;
+
+	/** Loaded classes by id. Blueprint classes are resolved by their paths again after reinstancing or reloading. */
+	static TArray<TWeakObjectPtr<UClass>> KeyClasses;
+
+	static TMap<FTopLevelAssetPath, int32> PathIds;
+
+	static TMap<TObjectKey<UClass>, int32> ClassIds;
+
+	/** Bits of the keys which open a lock requiring the key type by id. Rows grow only up to their highest set bit. */
+	static TArray<TBitArray<>> MatchingKeyBits;
+
+	/** Set when a key class is reinstanced or reloaded, since its old bits can't be removed one by one. */
+	static bool bMatchingKeyBitsDirty = false;
+
+	static FDelegateHandle PostEngineInitHandle;
+
+	static FDelegateHandle FilesLoadedHandle;
+
+	bool IsLockKeyClass(const UClass* Class)
+	{
+		return Class && Class->IsChildOf(ULockKeyType::StaticClass())
+			&& !Class->HasAnyClassFlags(CLASS_NewerVersionExists);
+	}
+
+	int32 RegisterPath(const FTopLevelAssetPath& Path)
+	{
+		if (const int32* KeyId = PathIds.Find(Path))
+		{
+			return *KeyId;
+		}
+
+		const int32 KeyId = KeyPaths.Add(Path);
+		KeyClasses.AddDefaulted();
+		MatchingKeyBits.AddDefaulted();
+		PathIds.Add(Path, KeyId);
+		return KeyId;
+	}
+
+	void SetMatchingKeyBit(const int32 RequiredKeyId, const int32 KeyId)
+	{
+		TBitArray<>& KeyBits = MatchingKeyBits[RequiredKeyId];
+
+		if (!KeyBits.IsValidIndex(KeyId))
+		{
+			KeyBits.SetNum(FMath::Max(KeyPaths.Num(), KeyId + 1), false);
+		}
+
+		KeyBits[KeyId] = true;
+	}
+
+	/**
+	 * Adds the bits matching the loaded key class with its ancestors. Its subclasses add their own bits when they are
+	 * cached, as they can't be loaded before it. Ancestors which weren't discovered yet are registered here, otherwise
+	 * the locks requiring them would never match the class.
+	 */
+	void AddMatchingKeyBits(UClass* Class, const int32 KeyId)
+	{
+		for (UClass* Ancestor = Class; IsLockKeyClass(Ancestor); Ancestor = Ancestor->GetSuperClass())
+		{
+			const int32 AncestorId = FLockKeyTypeRegistry::GetKeyId(Ancestor);
+
+			// Keys open the locks requiring their ancestors, and master keys open the locks requiring their subclasses.
+			SetMatchingKeyBit(AncestorId, KeyId);
+
+			if (GetDefault<ULockKeyType>(Ancestor)->IsMasterKey())
+			{
+				SetMatchingKeyBit(KeyId, AncestorId);
+			}
+		}
+	}
+
+	void CacheClass(UClass* Class, const int32 KeyId)
+	{
+		const bool bWasCached = !KeyClasses[KeyId].IsExplicitlyNull();
+		KeyClasses[KeyId] = Class;
+		ClassIds.Add(Class, KeyId);
+
+		if (bWasCached)
+		{
+			// The hierarchy or the master key flags of the new class can differ from the old one.
+			bMatchingKeyBitsDirty = true;
+		}
+		else
+		{
+			AddMatchingKeyBits(Class, KeyId);
+		}
+	}
+
+	/**
+	 * Rebuilds the bits from the cached classes only. Classes which aren't cached yet add their bits once they are.
+	 */
+	void RebuildMatchingKeyBits()
+	{
+		for (TBitArray<>& KeyBits : MatchingKeyBits)
+		{
+			KeyBits.Reset();
+		}
+
+		for (int32 KeyId = 0; KeyId < KeyClasses.Num(); ++KeyId)
+		{
+			if (UClass* Class = KeyClasses[KeyId].Get(); IsLockKeyClass(Class))
+			{
+				AddMatchingKeyBits(Class, KeyId);
+			}
+		}
+
+		// Caching the ancestors above can mark the bits dirty again, their bits are already added.
+		bMatchingKeyBitsDirty = false;
+	}
+
+	void OnFilesLoaded()
+	{
+		FLockKeyTypeRegistry::DiscoverKeyTypes();
+	}
+}
+
+void FLockKeyTypeRegistry::Initialize()
+{
+	using namespace LockKeyTypeRegistry;
+
+	PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddLambda([]()
+	{
+		DiscoverKeyTypes();
+
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+		if (AssetRegistry.IsLoadingAssets())
+		{
+			FilesLoadedHandle = AssetRegistry.OnFilesLoaded().AddStatic(&OnFilesLoaded);
+		}
+	});
+}
+
+void FLockKeyTypeRegistry::Shutdown()
+{
+	using namespace LockKeyTypeRegistry;
+
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+
+	if (FilesLoadedHandle.IsValid())
+	{
+		if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>(
+			"AssetRegistry"))
+		{
+			AssetRegistryModule->Get().OnFilesLoaded().Remove(FilesLoadedHandle);
+		}
+
+		FilesLoadedHandle.Reset();
+	}
+
+	KeyPaths.Empty();
+	KeyClasses.Empty();
+	PathIds.Empty();
+	ClassIds.Empty();
+	MatchingKeyBits.Empty();
+	bMatchingKeyBitsDirty = false;
+}
+
+void FLockKeyTypeRegistry::DiscoverKeyTypes()
+{
+	using namespace LockKeyTypeRegistry;
+
+	check(IsInGameThread());
+
+	TSet<FTopLevelAssetPath> ClassPaths;
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		if (It->HasAnyClassFlags(CLASS_Native) && IsLockKeyClass(*It))
+		{
+			ClassPaths.Add(It->GetClassPathName());
+		}
+	}
+
+	// Also returns the Blueprint classes which aren't loaded yet.
+	const IAssetRegistry& AssetRegistry =
+		FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	TSet<FTopLevelAssetPath> DerivedClassPaths;
+	AssetRegistry.GetDerivedClassNames({ULockKeyType::StaticClass()->GetClassPathName()}, {}, DerivedClassPaths);
+	ClassPaths.Append(DerivedClassPaths);
+
+	TArray<FTopLevelAssetPath> NewPaths;
+	NewPaths.Reserve(ClassPaths.Num());
+
+	for (const FTopLevelAssetPath& Path : ClassPaths)
+	{
+		if (!PathIds.Contains(Path))
+		{
+			NewPaths.Add(Path);
+		}
+	}
+
+	NewPaths.Sort([](const FTopLevelAssetPath& A, const FTopLevelAssetPath& B)
+	{
+		return A.ToString() < B.ToString();
+	});
+
+	for (const FTopLevelAssetPath& Path : NewPaths)
+	{
+		RegisterPath(Path);
+	}
+}
+
+int32 FLockKeyTypeRegistry::GetKeyId(const UClass* LockKey)
+{
+	using namespace LockKeyTypeRegistry;
+
+	const int32 FoundKeyId = FindKeyId(LockKey);
+
+	if (FoundKeyId != INDEX_NONE || !IsLockKeyClass(LockKey))
+	{
+		return FoundKeyId;
+	}
+
+	check(IsInGameThread());
+	const int32 KeyId = RegisterPath(LockKey->GetClassPathName());
+	CacheClass(const_cast<UClass*>(LockKey), KeyId);
+	return KeyId;
+}
+
+int32 FLockKeyTypeRegistry::FindKeyId(const UClass* LockKey)
+{
+	using namespace LockKeyTypeRegistry;
+
+	if (!LockKey)
+	{
+		return INDEX_NONE;
+	}
+
+	if (const int32* KeyId = ClassIds.Find(LockKey))
+	{
+		return *KeyId;
+	}
+
+	if (!IsLockKeyClass(LockKey))
+	{
+		return INDEX_NONE;
+	}
+
+	// The class was registered by its path before it was loaded or reinstanced.
+	const int32 KeyId = FindKeyIdByPath(LockKey->GetClassPathName());
+
+	if (KeyId != INDEX_NONE)
+	{
+		CacheClass(const_cast<UClass*>(LockKey), KeyId);
+	}
+
+	return KeyId;
+}
+
+int32 FLockKeyTypeRegistry::FindKeyIdByPath(const FTopLevelAssetPath& Path)
+{
+	const int32* KeyId = LockKeyTypeRegistry::PathIds.Find(Path);
+	return KeyId ? *KeyId : INDEX_NONE;
+}
+
+TSubclassOf<ULockKeyType> FLockKeyTypeRegistry::GetKeyClass(const int32 KeyId)
+{
+	using namespace LockKeyTypeRegistry;
+
+	if (!KeyClasses.IsValidIndex(KeyId))
+	{
+		return nullptr;
+	}
+
+	if (UClass* Class = KeyClasses[KeyId].Get(); IsLockKeyClass(Class))
+	{
+		return Class;
+	}
+
+	UClass* Class = FindObject<UClass>(KeyPaths[KeyId]);
+
+	if (!IsLockKeyClass(Class))
+	{
+		return nullptr;
+	}
+
+	CacheClass(Class, KeyId);
+	return Class;
+}
+
+FTopLevelAssetPath FLockKeyTypeRegistry::GetKeyPath(const int32 KeyId)
+{
+	using namespace LockKeyTypeRegistry;
+
+	return KeyPaths.IsValidIndex(KeyId) ? KeyPaths[KeyId] : FTopLevelAssetPath();
+}
+
+const TBitArray<>& FLockKeyTypeRegistry::GetMatchingKeyBits(const int32 RequiredKeyId)
+{
+	using namespace LockKeyTypeRegistry;
+
+	static const TBitArray<> EmptyKeyBits;
+
+	if (bMatchingKeyBitsDirty)
+	{
+		RebuildMatchingKeyBits();
+	}
+
+	return MatchingKeyBits.IsValidIndex(RequiredKeyId) ? MatchingKeyBits[RequiredKeyId] : EmptyKeyBits;
+}
+
+void FLockKeyTypeRegistry::MakeKeyBits(TConstArrayView<TSubclassOf<ULockKeyType>> LockKeys, TBitArray<>& OutKeyBits)
+{
+	OutKeyBits.Reset();
+
+	for (const TSubclassOf<ULockKeyType>& LockKey : LockKeys)
+	{
+		const int32 KeyId = GetKeyId(LockKey);
+
+		if (KeyId == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (!OutKeyBits.IsValidIndex(KeyId))
+		{
+			OutKeyBits.SetNum(FMath::Max(GetNumKeyTypes(), KeyId + 1), false);
+		}
+
+		OutKeyBits[KeyId] = true;
+	}
+}
+
+int32 FLockKeyTypeRegistry::GetNumKeyTypes()
+{
+	return LockKeyTypeRegistry::KeyPaths.Num();
+}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+namespace LockKeyTypeRegistry
+{
+	void ExecuteDumpLockKeyTypes(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		for (int32 KeyId = 0; KeyId < KeyPaths.Num(); ++KeyId)
+		{
+			Ar.Logf(TEXT("%4d | %s%s"),
+			        KeyId,
+			        *KeyPaths[KeyId].ToString(),
+			        FLockKeyTypeRegistry::GetKeyClass(KeyId) ? TEXT("") : TEXT(" | Not loaded"));
+		}
+
+		Ar.Logf(TEXT("Total: %d"), KeyPaths.Num());
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpLockKeyTypesCommand(
+		TEXT("TrickyGameplayObjects.DumpLockKeyTypes"),
+		TEXT("Prints the registered lock key types with their ids."),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteDumpLockKeyTypes));
+}
+#endif
@@ -3,6 +3,10 @@
 
 #include "Pickup/PickupBase.h"
 
+#include "TrickyGameplayObjectsLog.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "TrickyGameplayObjectsTrace.h"
+
 DEFINE_LOG_CATEGORY(LogPickup)
 
 APickupBase::APickupBase()
@@ -13,6 +17,12 @@ APickupBase::APickupBase()
 	SetRootComponent(Root);
 }
 
+void APickupBase::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(OnPickupActivated.GetAllocatedSize());
+}
+
 void APickupBase::BeginDestroy()
 {
 	this->OnPickupActivated.Clear();
@@ -22,6 +32,9 @@ void APickupBase::BeginDestroy()
 
 bool APickupBase::ActivatePickup(AActor* Activator)
 {
+	TRICKY_GAMEPLAY_OBJECTS_SCOPE_CYCLE_COUNTER(ActivatePickup);
+	TRACE_PICKUP_ACTIVATION_SCOPE(this, Activator);
+
 	if (!IsValid(Activator))
 	{
 #if WITH_EDITOR && !UE_BUILD_SHIPPING
@@ -38,30 +51,38 @@ bool APickupBase::ActivatePickup(AActor* Activator)
 	{
 		HandleActivationFailure(Activator);
 #if WITH_EDITOR && !UE_BUILD_SHIPPING
+		if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+		{
+			FString Name, ActivatorName;
+			GetActorName(this, Name);
+			GetActorName(Activator, ActivatorName);
+			const FString Message = FString::Printf(
+				TEXT("%s pickup activation failed. Reason: %s activation check failed."),
+				*Name,
+				*ActivatorName);
+			PrintLog(Message);
+		}
+#endif
+		return false;
+	}
+
+	HandleActivationSuccess(Activator);
+	TRACE_PICKUP_ACTIVATION_SUCCEEDED();
+	TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(PickupActivations, 1);
+	TRICKY_GAMEPLAY_OBJECTS_BROADCAST(OnPickupActivated, this, Activator);
+
+#if WITH_EDITOR && !UE_BUILD_SHIPPING
+	if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+	{
 		FString Name, ActivatorName;
 		GetActorName(this, Name);
 		GetActorName(Activator, ActivatorName);
 		const FString Message = FString::Printf(
-			TEXT("%s pickup activation failed. Reason: %s activation check failed."),
+			TEXT("%s pickup successfully activated by %s."),
 			*Name,
 			*ActivatorName);
 		PrintLog(Message);
-#endif
-		return false;
 	}
-
-	HandleActivationSuccess(Activator);
-	OnPickupActivated.Broadcast(this, Activator);
-
-#if WITH_EDITOR && !UE_BUILD_SHIPPING
-	FString Name, ActivatorName;
-	GetActorName(this, Name);
-	GetActorName(Activator, ActivatorName);
-	const FString Message = FString::Printf(
-		TEXT("%s pickup successfully activated by %s."),
-		*Name,
-		*ActivatorName);
-	PrintLog(Message);
 #endif
 
 	if (bDestroyAfterActivation)
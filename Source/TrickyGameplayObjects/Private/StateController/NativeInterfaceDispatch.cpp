@@ -0,0 +1,42 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/NativeInterfaceDispatch.h"
+
+#include "UObject/Class.h"
+#include "UObject/ObjectKey.h"
+
+namespace NativeInterfaceDispatch
+{
+	using FCacheKey = TPair<TObjectKey<UClass>, FName>;
+
+	static TMap<FCacheKey, bool> NativeImplementationCache;
+}
+
+bool FNativeInterfaceDispatch::IsNativeImplementation(const UClass* Class, const FName FunctionName)
+{
+	check(IsInGameThread());
+
+	if (!Class)
+	{
+		return false;
+	}
+
+	// Only Blueprint generated classes can override native events.
+	if (Class->HasAnyClassFlags(CLASS_Native))
+	{
+		return true;
+	}
+
+	const NativeInterfaceDispatch::FCacheKey Key(Class, FunctionName);
+
+	if (const bool* bCachedResult = NativeInterfaceDispatch::NativeImplementationCache.Find(Key))
+	{
+		return *bCachedResult;
+	}
+
+	const UFunction* Function = Class->FindFunctionByName(FunctionName);
+	const bool bIsNative = Function && Function->HasAnyFunctionFlags(FUNC_Native);
+	NativeInterfaceDispatch::NativeImplementationCache.Add(Key, bIsNative);
+	return bIsNative;
+}
@@ -0,0 +1,263 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerDormancyManager.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "StateController/StateControllerRegistry.h"
+#include "TrickyGameplayObjectsStats.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dormant Owners"),
+                               STAT_DormantStateControllerOwners,
+                               STATGROUP_TrickyGameplayObjects);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Awake Owners"),
+                               STAT_AwakeStateControllerOwners,
+                               STATGROUP_TrickyGameplayObjects);
+
+UStateControllerDormancyManager* UStateControllerDormancyManager::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerDormancyManager>() : nullptr;
+}
+
+void UStateControllerDormancyManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	StableTime = FMath::Max(StableTime, 0.f);
+	Registry = Collection.InitializeDependency<UStateControllerRegistry>();
+
+	if (!bManageNetDormancy || !IsValid(Registry))
+	{
+		return;
+	}
+
+	Registry->OnControllerRegistered.AddUObject(this, &UStateControllerDormancyManager::AddController);
+	Registry->OnControllerUnregistered.AddUObject(this, &UStateControllerDormancyManager::RemoveController);
+	Registry->OnControllerStatesChanged.AddUObject(this, &UStateControllerDormancyManager::HandleStatesChanged);
+}
+
+void UStateControllerDormancyManager::Deinitialize()
+{
+	if (IsValid(Registry))
+	{
+		Registry->OnControllerRegistered.RemoveAll(this);
+		Registry->OnControllerUnregistered.RemoveAll(this);
+		Registry->OnControllerStatesChanged.RemoveAll(this);
+	}
+
+	Owners.Empty();
+	PendingOwners.Empty();
+	PendingHead = 0;
+	NumDormantOwners = 0;
+	Registry = nullptr;
+	UpdateStats();
+
+	Super::Deinitialize();
+}
+
+void UStateControllerDormancyManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double CurrentTime = GetCurrentTime();
+
+	while (PendingHead < PendingOwners.Num() && PendingOwners[PendingHead].StableTime <= CurrentTime)
+	{
+		const FPendingOwner Pending = PendingOwners[PendingHead++];
+		FOwnerEntry* Entry = Owners.Find(Pending.Key);
+
+		if (!Entry || Entry->Serial != Pending.Serial || Entry->bIsDormant)
+		{
+			continue;
+		}
+
+		// Finishing the transition changes the states and enqueues the owner again.
+		const bool bIsInTransition = Entry->Handles.ContainsByPredicate([this](const FStateControllerHandle& Handle)
+		{
+			return Registry->IsInTransition(Handle);
+		});
+
+		AActor* Owner = Entry->Owner.Get();
+
+		if (bIsInTransition || !IsValid(Owner) || !ReplicatesOnlyStateControllers(Owner, *Entry))
+		{
+			continue;
+		}
+
+		Owner->SetNetDormancy(DORM_DormantAll);
+		Entry->bIsDormant = true;
+		++NumDormantOwners;
+	}
+
+	if (PendingHead == PendingOwners.Num())
+	{
+		PendingOwners.Reset();
+		PendingHead = 0;
+	}
+	else if (PendingHead > PendingOwners.Num() / 2)
+	{
+		PendingOwners.RemoveAt(0, PendingHead, false);
+		PendingHead = 0;
+	}
+
+	UpdateStats();
+}
+
+bool UStateControllerDormancyManager::IsTickable() const
+{
+	return PendingHead < PendingOwners.Num();
+}
+
+TStatId UStateControllerDormancyManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStateControllerDormancyManager, STATGROUP_Tickables);
+}
+
+bool UStateControllerDormancyManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UStateControllerDormancyManager::IsServer() const
+{
+	const UWorld* World = GetWorld();
+	return World && (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer);
+}
+
+double UStateControllerDormancyManager::GetCurrentTime() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void UStateControllerDormancyManager::AddController(const FStateControllerHandle& Handle,
+                                                    UActorComponent* Controller)
+{
+	AActor* Owner = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+
+	if (!Owner || !Owner->GetIsReplicated() || Owner->NetDormancy == DORM_Never || !IsServer())
+	{
+		return;
+	}
+
+	FOwnerEntry& Entry = Owners.FindOrAdd(Owner);
+	Entry.Owner = Owner;
+	Entry.Handles.Add(Handle);
+	EnqueueOwner(Owner, Entry);
+	UpdateStats();
+}
+
+void UStateControllerDormancyManager::RemoveController(const FStateControllerHandle& Handle,
+                                                       UActorComponent* Controller)
+{
+	const AActor* Owner = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+	FOwnerEntry* Entry = Owner ? Owners.Find(Owner) : nullptr;
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->Handles.RemoveSingleSwap(Handle);
+
+	if (!Entry->Handles.IsEmpty())
+	{
+		return;
+	}
+
+	NumDormantOwners -= Entry->bIsDormant;
+	Owners.Remove(Owner);
+	UpdateStats();
+}
+
+void UStateControllerDormancyManager::HandleStatesChanged(const FStateControllerHandle& Handle)
+{
+	if (Owners.IsEmpty())
+	{
+		return;
+	}
+
+	const UActorComponent* Controller = Registry->ResolveController(Handle);
+	AActor* Owner = Controller ? Controller->GetOwner() : nullptr;
+	FOwnerEntry* Entry = Owner ? Owners.Find(Owner) : nullptr;
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	WakeOwner(*Entry);
+	EnqueueOwner(Owner, *Entry);
+}
+
+void UStateControllerDormancyManager::EnqueueOwner(AActor* Owner, FOwnerEntry& Entry)
+{
+	FPendingOwner& Pending = PendingOwners.AddDefaulted_GetRef();
+	Pending.Key = Owner;
+	Pending.StableTime = GetCurrentTime() + StableTime;
+	Pending.Serial = ++Entry.Serial;
+}
+
+void UStateControllerDormancyManager::WakeOwner(FOwnerEntry& Entry)
+{
+	if (!Entry.bIsDormant)
+	{
+		return;
+	}
+
+	Entry.bIsDormant = false;
+	--NumDormantOwners;
+
+	if (AActor* Owner = Entry.Owner.Get())
+	{
+		// Waking up flushes the dormancy, so the changed states are replicated in the next net update.
+		Owner->SetNetDormancy(DORM_Awake);
+	}
+
+	UpdateStats();
+}
+
+bool UStateControllerDormancyManager::ReplicatesOnlyStateControllers(AActor* Owner, const FOwnerEntry& Entry) const
+{
+	if (Owner->IsReplicatingMovement())
+	{
+		return false;
+	}
+
+	UClass* OwnerClass = Owner->GetClass();
+	OwnerClass->SetUpRuntimeReplicationData();
+
+	for (const FRepRecord& RepRecord : OwnerClass->ClassReps)
+	{
+		if (RepRecord.Property->GetOwnerClass() != AActor::StaticClass())
+		{
+			return false;
+		}
+	}
+
+	TArray<const UActorComponent*, TInlineAllocator<2>> Controllers;
+
+	for (const FStateControllerHandle& Handle : Entry.Handles)
+	{
+		Controllers.Add(Registry->ResolveController(Handle));
+	}
+
+	for (const UActorComponent* Component : Owner->GetComponents())
+	{
+		if (Component && Component->GetIsReplicated() && !Controllers.Contains(Component))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void UStateControllerDormancyManager::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_DormantStateControllerOwners, GetNumDormantOwners());
+	SET_DWORD_STAT(STAT_AwakeStateControllerOwners, GetNumAwakeOwners());
+}
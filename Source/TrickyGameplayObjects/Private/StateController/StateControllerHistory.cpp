@@ -0,0 +1,110 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerHistory.h"
+
+#if WITH_STATE_CONTROLLER_HISTORY
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+
+FObjectKey FStateControllerHistoryInstigatorScope::CurrentInstigator;
+
+FStateControllerHistoryInstigatorScope::FStateControllerHistoryInstigatorScope(const UObject* Instigator)
+	: PreviousInstigator(CurrentInstigator)
+{
+	CurrentInstigator = FObjectKey(Instigator);
+}
+
+FStateControllerHistoryInstigatorScope::~FStateControllerHistoryInstigatorScope()
+{
+	CurrentInstigator = PreviousInstigator;
+}
+
+void FStateControllerHistoryUtils::StampEntry(const UObject* Controller, FStateControllerHistoryEntry& Entry)
+{
+	const UWorld* World = Controller ? Controller->GetWorld() : nullptr;
+	Entry.FrameNumber = static_cast<uint32>(GFrameCounter);
+	Entry.Timestamp = World ? World->GetTimeSeconds() : 0.f;
+	Entry.Instigator = FStateControllerHistoryInstigatorScope::GetCurrentInstigator();
+}
+
+void FStateControllerHistoryUtils::PrintEntry(FOutputDevice& Ar,
+                                              const FStateControllerHistoryEntry& Entry,
+                                              const UEnum* StateEnum)
+{
+	const UObject* Instigator = Entry.Instigator.ResolveObjectPtr();
+
+	Ar.Logf(TEXT("  Frame: %u | Time: %.3f | %s -> %s | Target: %s | Instigator: %s"),
+	        Entry.FrameNumber,
+	        Entry.Timestamp,
+	        *StateEnum->GetNameStringByValue(Entry.FromState),
+	        *StateEnum->GetNameStringByValue(Entry.ToState),
+	        *StateEnum->GetNameStringByValue(Entry.TargetState),
+	        Instigator ? *Instigator->GetName() : TEXT("NONE"));
+}
+
+namespace StateControllerHistory
+{
+	template <typename ComponentType>
+	void DumpHistory(const UActorComponent* Component, FOutputDevice& Ar)
+	{
+		const ComponentType* Controller = Cast<ComponentType>(Component);
+
+		if (!Controller)
+		{
+			return;
+		}
+
+		Ar.Logf(TEXT("%s (%u changes):"), *Controller->GetName(), Controller->GetStateHistory().GetNumRecorded());
+		Controller->GetStateHistory().Dump(Ar);
+	}
+
+	void DumpActorHistory(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (Args.IsEmpty() || !World)
+		{
+			Ar.Log(TEXT("Usage: TrickyGameplayObjects.DumpStateHistory <ActorName>"));
+			return;
+		}
+
+		bool bFoundActor = false;
+
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			if (!It->GetName().Equals(Args[0]) && !It->GetActorNameOrLabel().Equals(Args[0]))
+			{
+				continue;
+			}
+
+			bFoundActor = true;
+			Ar.Logf(TEXT("State history of %s:"), *It->GetActorNameOrLabel());
+
+			for (const UActorComponent* Component : It->GetComponents())
+			{
+				DumpHistory<UDoorStateControllerComponent>(Component, Ar);
+				DumpHistory<UChestStateControllerComponent>(Component, Ar);
+				DumpHistory<ULockStateControllerComponent>(Component, Ar);
+				DumpHistory<UButtonStateControllerComponent>(Component, Ar);
+				DumpHistory<UGameplayObjectStateControllerComponent>(Component, Ar);
+			}
+		}
+
+		if (!bFoundActor)
+		{
+			Ar.Logf(TEXT("Actor %s wasn't found"), *Args[0]);
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpStateHistoryCommand(
+		TEXT("TrickyGameplayObjects.DumpStateHistory"),
+		TEXT("Prints the last state changes of all the state controllers of the actor. Usage: <ActorName>"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&DumpActorHistory));
+}
+#endif
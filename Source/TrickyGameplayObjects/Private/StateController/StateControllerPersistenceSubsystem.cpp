@@ -0,0 +1,274 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerPersistenceSubsystem.h"
+
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "StateController/StateControllerRegistry.h"
+#include "StateController/StateControllerSnapshotSubsystem.h"
+
+UStateControllerPersistenceSubsystem* UStateControllerPersistenceSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerPersistenceSubsystem>() : nullptr;
+}
+
+void UStateControllerPersistenceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Registry = Collection.InitializeDependency<UStateControllerRegistry>();
+
+	if (!bPersistStreamedOutStates || !IsValid(Registry))
+	{
+		return;
+	}
+
+	Registry->OnControllerUnregistered.AddUObject(this,
+	                                              &UStateControllerPersistenceSubsystem::HandleControllerUnregistered);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(
+		this, &UStateControllerPersistenceSubsystem::HandleLevelRemoved);
+}
+
+void UStateControllerPersistenceSubsystem::Deinitialize()
+{
+	if (IsValid(Registry))
+	{
+		Registry->OnControllerUnregistered.RemoveAll(this);
+	}
+
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	LevelRemovedHandle.Reset();
+
+	Reset();
+	Registry = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UStateControllerPersistenceSubsystem::Reset()
+{
+	Keys.Empty();
+	Values.Empty();
+	PendingKeys.Empty();
+	PendingValues.Empty();
+	bIsDirty |= NumEntries > 0;
+	NumEntries = 0;
+}
+
+void UStateControllerPersistenceSubsystem::GetStoredStates(TArray<uint64>& OutKeys, TArray<uint16>& OutPackedStates)
+{
+	FlushPendingStates();
+
+	OutKeys.Reset(NumEntries);
+	OutPackedStates.Reset(NumEntries);
+
+	for (int32 Slot = 0; Slot < Keys.Num(); ++Slot)
+	{
+		if (Keys[Slot] != EmptyKey)
+		{
+			OutKeys.Add(Keys[Slot]);
+			OutPackedStates.Add(Values[Slot]);
+		}
+	}
+}
+
+void UStateControllerPersistenceSubsystem::RestoreStoredStates(TConstArrayView<uint64> InKeys,
+                                                               TConstArrayView<uint16> InPackedStates)
+{
+	check(InKeys.Num() == InPackedStates.Num());
+
+	Reset();
+	Reserve(InKeys.Num());
+
+	for (int32 Index = 0; Index < InKeys.Num(); ++Index)
+	{
+		StoreStates(MakeKey(InKeys[Index]), InPackedStates[Index]);
+	}
+}
+
+bool UStateControllerPersistenceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+uint64 UStateControllerPersistenceSubsystem::MakeKey(const UObject* Object)
+{
+	return MakeKey(UStateControllerSnapshotSubsystem::GetStableId(Object));
+}
+
+uint64 UStateControllerPersistenceSubsystem::MakeKey(const uint64 StableId)
+{
+	return StableId == EmptyKey ? EmptyKey + 1 : StableId;
+}
+
+bool UStateControllerPersistenceSubsystem::TakeStates(const UActorComponent* Controller, uint16& OutPackedStates)
+{
+	// A level can be streamed in again in the same frame it was removed in.
+	FlushPendingStates();
+
+	// Most controllers are initialized before anything is streamed out, so building the key is skipped for them.
+	if (NumEntries == 0)
+	{
+		return false;
+	}
+
+	const uint64 Key = MakeKey(Controller);
+	const uint32 SlotMask = static_cast<uint32>(Keys.Num() - 1);
+
+	for (uint32 Slot = static_cast<uint32>(Key) & SlotMask; Keys[Slot] != EmptyKey; Slot = Slot + 1 & SlotMask)
+	{
+		if (Keys[Slot] == Key)
+		{
+			// The controller is registered again, so its states are saved with it until it's streamed out again.
+			OutPackedStates = Values[Slot];
+			RemoveSlot(Slot);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UStateControllerPersistenceSubsystem::StoreStates(const uint64 Key, const uint16 PackedStates)
+{
+	// The load factor is kept below 3/4, so probing always finds an empty slot.
+	if ((NumEntries + 1) * 4 > Keys.Num() * 3)
+	{
+		Reserve(NumEntries + 1);
+	}
+
+	const uint32 SlotMask = static_cast<uint32>(Keys.Num() - 1);
+	uint32 Slot = static_cast<uint32>(Key) & SlotMask;
+
+	while (Keys[Slot] != EmptyKey && Keys[Slot] != Key)
+	{
+		Slot = Slot + 1 & SlotMask;
+	}
+
+	NumEntries += Keys[Slot] == EmptyKey;
+	Keys[Slot] = Key;
+	Values[Slot] = PackedStates;
+	bIsDirty = true;
+}
+
+void UStateControllerPersistenceSubsystem::AddPendingStates(const uint64 Key, const uint16 PackedStates)
+{
+	PendingKeys.Add(Key);
+	PendingValues.Add(PackedStates);
+}
+
+void UStateControllerPersistenceSubsystem::FlushPendingStates()
+{
+	if (PendingKeys.IsEmpty())
+	{
+		return;
+	}
+
+	Reserve(NumEntries + PendingKeys.Num());
+
+	for (int32 Index = 0; Index < PendingKeys.Num(); ++Index)
+	{
+		StoreStates(PendingKeys[Index], PendingValues[Index]);
+	}
+
+	PendingKeys.Reset();
+	PendingValues.Reset();
+}
+
+void UStateControllerPersistenceSubsystem::Reserve(const int32 NumElements)
+{
+	constexpr int32 MinNumSlots = 1024;
+
+	if (NumElements * 4 <= Keys.Num() * 3)
+	{
+		return;
+	}
+
+	const uint32 NumSlots = FMath::RoundUpToPowerOfTwo(FMath::Max(NumElements * 4 / 3 + 1, MinNumSlots));
+	Rehash(static_cast<int32>(NumSlots));
+}
+
+void UStateControllerPersistenceSubsystem::Rehash(const int32 NumSlots)
+{
+	TArray<uint64> OldKeys = MoveTemp(Keys);
+	TArray<uint16> OldValues = MoveTemp(Values);
+	const bool bWasDirty = bIsDirty;
+
+	Keys.Init(EmptyKey, NumSlots);
+	Values.SetNumZeroed(NumSlots);
+	NumEntries = 0;
+
+	for (int32 Index = 0; Index < OldKeys.Num(); ++Index)
+	{
+		if (OldKeys[Index] != EmptyKey)
+		{
+			StoreStates(OldKeys[Index], OldValues[Index]);
+		}
+	}
+
+	// Moving the entries doesn't change the stored states.
+	bIsDirty = bWasDirty;
+}
+
+void UStateControllerPersistenceSubsystem::RemoveSlot(uint32 Slot)
+{
+	const uint32 SlotMask = static_cast<uint32>(Keys.Num() - 1);
+
+	for (uint32 NextSlot = Slot + 1 & SlotMask; Keys[NextSlot] != EmptyKey; NextSlot = NextSlot + 1 & SlotMask)
+	{
+		const uint32 HomeSlot = static_cast<uint32>(Keys[NextSlot]) & SlotMask;
+
+		// The entry can fill the hole only if the hole is between its home slot and its current one.
+		if ((NextSlot - HomeSlot & SlotMask) >= (NextSlot - Slot & SlotMask))
+		{
+			Keys[Slot] = Keys[NextSlot];
+			Values[Slot] = Values[NextSlot];
+			Slot = NextSlot;
+		}
+	}
+
+	Keys[Slot] = EmptyKey;
+	--NumEntries;
+	bIsDirty = true;
+}
+
+void UStateControllerPersistenceSubsystem::HandleControllerUnregistered(const FStateControllerHandle& Handle,
+                                                                        UActorComponent* Controller)
+{
+	const AActor* Owner = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+	const ULevel* Level = Owner ? Owner->GetLevel() : nullptr;
+
+	// Only the controllers streamed out with their level are stored, destroyed ones are reset on the next load.
+	if (!Level || !Level->bIsBeingRemoved)
+	{
+		return;
+	}
+
+	uint8 CurrentState = 0;
+	uint8 TargetState = 0;
+	uint8 LastState = 0;
+
+	if (!Registry->GetRawStates(Handle, CurrentState, TargetState, LastState))
+	{
+		return;
+	}
+
+	// LastState already holds the state the transition started from, so only the current state is finished.
+	if (Registry->IsInTransition(Handle))
+	{
+		CurrentState = TargetState;
+	}
+
+	AddPendingStates(MakeKey(Controller), PackStates(CurrentState, TargetState, LastState));
+}
+
+void UStateControllerPersistenceSubsystem::HandleLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		FlushPendingStates();
+	}
+}
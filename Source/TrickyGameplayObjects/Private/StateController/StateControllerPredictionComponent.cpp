@@ -0,0 +1,342 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerPredictionComponent.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "UObject/UObjectIterator.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+
+UStateControllerPredictionComponent::UStateControllerPredictionComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+bool UStateControllerPredictionComponent::PredictOpenDoor(UDoorStateControllerComponent* Door,
+                                                          const bool bTransitImmediately)
+{
+	if (!IsValid(Door))
+	{
+		return false;
+	}
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return IDoorInterface::Execute_OpenDoor(Door, bTransitImmediately);
+	}
+
+	if (!CanPredict() || !IDoorInterface::Execute_OpenDoor(Door, bTransitImmediately))
+	{
+		return false;
+	}
+
+	ServerOpenDoor(Door, bTransitImmediately, AddPendingPrediction(Door));
+	return true;
+}
+
+bool UStateControllerPredictionComponent::PredictPressButton(UButtonStateControllerComponent* Button,
+                                                             const bool bTransitImmediately)
+{
+	if (!IsValid(Button))
+	{
+		return false;
+	}
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return IButtonInterface::Execute_PressButton(Button, bTransitImmediately);
+	}
+
+	if (!CanPredict() || !IButtonInterface::Execute_PressButton(Button, bTransitImmediately))
+	{
+		return false;
+	}
+
+	ServerPressButton(Button, bTransitImmediately, AddPendingPrediction(Button));
+	return true;
+}
+
+bool UStateControllerPredictionComponent::CanPredict() const
+{
+	const AActor* Owner = GetOwner();
+
+	// Server RPCs run locally in standalone worlds.
+	return IsValid(Owner) && GetOwnerRole() == ROLE_AutonomousProxy
+		&& (GetNetMode() == NM_Standalone || Owner->GetNetConnection() != nullptr);
+}
+
+void UStateControllerPredictionComponent::ServerOpenDoor_Implementation(UDoorStateControllerComponent* Door,
+                                                                        const bool bTransitImmediately,
+                                                                        const uint16 PredictionKey)
+{
+#if WITH_STATE_CONTROLLER_HISTORY
+	FStateControllerHistoryInstigatorScope InstigatorScope(GetOwner());
+#endif
+
+	const bool bAccepted = CanInteractWith(Door) && IDoorInterface::Execute_OpenDoor(Door, bTransitImmediately);
+	ClientResolvePrediction(PredictionKey, bAccepted);
+}
+
+void UStateControllerPredictionComponent::ServerPressButton_Implementation(UButtonStateControllerComponent* Button,
+                                                                           const bool bTransitImmediately,
+                                                                           const uint16 PredictionKey)
+{
+#if WITH_STATE_CONTROLLER_HISTORY
+	FStateControllerHistoryInstigatorScope InstigatorScope(GetOwner());
+#endif
+
+	const bool bAccepted = CanInteractWith(Button)
+		&& IButtonInterface::Execute_PressButton(Button, bTransitImmediately);
+	ClientResolvePrediction(PredictionKey, bAccepted);
+}
+
+void UStateControllerPredictionComponent::ClientResolvePrediction_Implementation(const uint16 PredictionKey,
+                                                                                 const bool bAccepted)
+{
+	const int32 Index = PendingPredictions.IndexOfByPredicate([PredictionKey](const FPendingPrediction& Prediction)
+	{
+		return Prediction.Key == PredictionKey;
+	});
+
+	// The prediction could have expired already.
+	if (Index != INDEX_NONE)
+	{
+		ResolvePrediction(Index, bAccepted);
+	}
+}
+
+uint16 UStateControllerPredictionComponent::AddPendingPrediction(UActorComponent* Controller)
+{
+	// 0 is skipped on overflow to keep it as an invalid key.
+	LastPredictionKey = LastPredictionKey == MAX_uint16 ? 1 : LastPredictionKey + 1;
+
+	FPendingPrediction& Prediction = PendingPredictions.AddDefaulted_GetRef();
+	Prediction.Key = LastPredictionKey;
+	Prediction.Controller = Controller;
+	Prediction.SendTime = GetCurrentTime();
+	ScheduleTimeout();
+	return Prediction.Key;
+}
+
+void UStateControllerPredictionComponent::ResolvePrediction(const int32 Index, const bool bAccepted)
+{
+	const FPendingPrediction Prediction = PendingPredictions[Index];
+	PendingPredictions.RemoveAt(Index);
+
+	if (!bAccepted)
+	{
+		// If the server changed the controller, its new states replicate later and are applied as usual.
+		UActorComponent* Controller = Prediction.Controller.Get();
+
+		if (UDoorStateControllerComponent* Door = Cast<UDoorStateControllerComponent>(Controller))
+		{
+			Door->RestoreReplicatedStates();
+		}
+		else if (UButtonStateControllerComponent* Button = Cast<UButtonStateControllerComponent>(Controller))
+		{
+			Button->RestoreReplicatedStates();
+		}
+	}
+
+	OnPredictionResolved.Broadcast(Prediction.Key,
+	                               bAccepted,
+	                               static_cast<float>(GetCurrentTime() - Prediction.SendTime));
+}
+
+void UStateControllerPredictionComponent::ExpirePredictions()
+{
+	const double ExpiredSendTime = GetCurrentTime() - PredictionTimeout;
+
+	while (!PendingPredictions.IsEmpty() && PendingPredictions[0].SendTime <= ExpiredSendTime)
+	{
+		ResolvePrediction(0, false);
+	}
+
+	ScheduleTimeout();
+}
+
+void UStateControllerPredictionComponent::ScheduleTimeout()
+{
+	UWorld* World = GetWorld();
+
+	if (PredictionTimeout <= 0.f || PendingPredictions.IsEmpty() || !World
+		|| World->GetTimerManager().IsTimerActive(TimeoutTimerHandle))
+	{
+		return;
+	}
+
+	const double Delay = PendingPredictions[0].SendTime + PredictionTimeout - GetCurrentTime();
+	World->GetTimerManager().SetTimer(TimeoutTimerHandle,
+	                                  this,
+	                                  &UStateControllerPredictionComponent::ExpirePredictions,
+	                                  FMath::Max(static_cast<float>(Delay), KINDA_SMALL_NUMBER));
+}
+
+bool UStateControllerPredictionComponent::CanInteractWith(const UActorComponent* Controller) const
+{
+	const AActor* Target = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+	const AActor* Owner = GetOwner();
+
+	if (!IsValid(Target) || !IsValid(Owner))
+	{
+		return false;
+	}
+
+	const APlayerController* PlayerController = Cast<APlayerController>(Owner);
+
+	if (const APawn* Pawn = Cast<APawn>(Owner))
+	{
+		PlayerController = Cast<APlayerController>(Pawn->GetController());
+	}
+
+	const AActor* ViewTarget = PlayerController ? PlayerController->GetViewTarget() : nullptr;
+	ViewTarget = ViewTarget ? ViewTarget : Owner;
+	const FVector ViewLocation = ViewTarget->GetActorLocation();
+
+	if (MaxInteractionDistance > 0.f
+		&& FVector::DistSquared(ViewLocation, Target->GetActorLocation()) > FMath::Square(MaxInteractionDistance))
+	{
+		return false;
+	}
+
+	// Clients can't see objects which aren't relevant for them, so they can't request to change them.
+	return !PlayerController || Target->IsNetRelevantFor(PlayerController, ViewTarget, ViewLocation);
+}
+
+double UStateControllerPredictionComponent::GetCurrentTime() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetRealTimeSeconds() : 0.0;
+}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+namespace StateControllerPrediction
+{
+	/**
+	 * Results of the predictions sent by the MeasurePredictionLatency command, collected until all are resolved.
+	 */
+	struct FLatencyMeasurement
+	{
+		TArray<uint16> SentKeys;
+
+		TMap<uint16, float> RoundTripTimes;
+
+		int32 NumAccepted = 0;
+
+		double MaxLocalStartTime = 0.0;
+
+		bool bSending = true;
+
+		FDelegateHandle ResolvedHandle;
+	};
+
+	void PrintLatencyMeasurement(const FLatencyMeasurement& Measurement)
+	{
+		float MinTime = MAX_flt;
+		float MaxTime = 0.f;
+		float TotalTime = 0.f;
+
+		for (const TPair<uint16, float>& Pair : Measurement.RoundTripTimes)
+		{
+			MinTime = FMath::Min(MinTime, Pair.Value);
+			MaxTime = FMath::Max(MaxTime, Pair.Value);
+			TotalTime += Pair.Value;
+		}
+
+		const int32 NumResolved = FMath::Max(Measurement.RoundTripTimes.Num(), 1);
+		UE_LOG(LogDoor,
+		       Display,
+		       TEXT("Prediction latency | Doors: %d | Accepted: %d | Rejected or timed out: %d | "
+			       "Predicted start: %.3f ms max | "
+			       "Round trip (unpredicted start): %.1f / %.1f / %.1f ms min / avg / max"),
+		       Measurement.SentKeys.Num(),
+		       Measurement.NumAccepted,
+		       Measurement.SentKeys.Num() - Measurement.NumAccepted,
+		       Measurement.MaxLocalStartTime * 1000.0,
+		       Measurement.RoundTripTimes.IsEmpty() ? 0.f : MinTime * 1000.f,
+		       TotalTime / NumResolved * 1000.f,
+		       MaxTime * 1000.f);
+	}
+
+	void FinishLatencyMeasurement(UStateControllerPredictionComponent* Prediction,
+	                              const TSharedRef<FLatencyMeasurement>& Measurement)
+	{
+		if (Measurement->bSending || Measurement->RoundTripTimes.Num() < Measurement->SentKeys.Num())
+		{
+			return;
+		}
+
+		PrintLatencyMeasurement(*Measurement);
+		Prediction->OnPredictionResolved.Remove(Measurement->ResolvedHandle);
+	}
+
+	/**
+	 * Predicts opening closed doors from the local player of a client and logs how long the local start and the
+	 * server confirmation take. Run it on a client connected to a listen or dedicated server.
+	 */
+	void ExecuteMeasurePredictionLatency(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UStateControllerPredictionComponent* Prediction = nullptr;
+
+		for (TObjectIterator<UStateControllerPredictionComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World && It->CanPredict())
+			{
+				Prediction = *It;
+				break;
+			}
+		}
+
+		if (!Prediction)
+		{
+			Ar.Log(TEXT("No StateControllerPredictionComponent of the local player can send requests to the server"));
+			return;
+		}
+
+		const int32 MaxDoors = Args.IsEmpty() ? 10 : FMath::Max(FCString::Atoi(*Args[0]), 1);
+		const TSharedRef<FLatencyMeasurement> Measurement = MakeShared<FLatencyMeasurement>();
+		Measurement->ResolvedHandle = Prediction->OnPredictionResolved.AddLambda(
+			[Prediction, Measurement](const uint16 PredictionKey, const bool bAccepted, const float RoundTripTime)
+			{
+				Measurement->RoundTripTimes.Add(PredictionKey, RoundTripTime);
+				Measurement->NumAccepted += bAccepted;
+				FinishLatencyMeasurement(Prediction, Measurement);
+			});
+
+		for (TObjectIterator<UDoorStateControllerComponent> It; It && Measurement->SentKeys.Num() < MaxDoors; ++It)
+		{
+			if (It->GetWorld() != World || It->GetCurrentState() != EDoorState::Closed)
+			{
+				continue;
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+
+			if (Prediction->PredictOpenDoor(*It, false))
+			{
+				Measurement->MaxLocalStartTime = FMath::Max(Measurement->MaxLocalStartTime,
+				                                            FPlatformTime::Seconds() - StartTime);
+				Measurement->SentKeys.Add(Prediction->GetLastPredictionKey());
+			}
+		}
+
+		Ar.Logf(TEXT("Predicted opening %d doors, the results are logged once the server answers"),
+		        Measurement->SentKeys.Num());
+		Measurement->bSending = false;
+		FinishLatencyMeasurement(Prediction, Measurement);
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice MeasurePredictionLatencyCommand(
+		TEXT("TrickyGameplayObjects.MeasurePredictionLatency"),
+		TEXT("Predicts opening closed doors on a client and logs the local start and round trip times. "
+			"Usage: [NumDoors]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteMeasurePredictionLatency));
+}
+#endif
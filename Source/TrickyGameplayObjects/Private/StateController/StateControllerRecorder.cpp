@@ -0,0 +1,879 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerRecorder.h"
+
+#include "Algo/Transform.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/SoftObjectPath.h"
+#include "UObject/UObjectIterator.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+#include "LockKey/KeyringComponent.h"
+#include "LockKey/LockKeyType.h"
+#include "StateController/StateControllerRegistry.h"
+#include "StateController/StateControllerSnapshotSubsystem.h"
+
+namespace StateControllerRecorder
+{
+	enum class EEventType : uint8
+	{
+		DefineKey,
+		InitialStates,
+		ControllerStates,
+		LockKeyAdded,
+		LockKeyRemoved,
+		AllLockKeysRemoved,
+		LockKeyUsed,
+		FinalStates
+	};
+
+	/**
+	 * Type, CurrentState, TargetState and LastState are packed into 3 bits each.
+	 */
+	constexpr uint32 BitsPerField = 3;
+
+	uint16 PackStates(const EStateControllerType Type,
+	                  const uint8 CurrentState,
+	                  const uint8 TargetState,
+	                  const uint8 LastState)
+	{
+		return static_cast<uint16>(static_cast<uint32>(Type)
+			| CurrentState << BitsPerField
+			| TargetState << BitsPerField * 2
+			| LastState << BitsPerField * 3);
+	}
+
+	uint8 UnpackField(const uint16 PackedStates, const uint32 FieldIndex)
+	{
+		return static_cast<uint8>(PackedStates >> FieldIndex * BitsPerField & ((1u << BitsPerField) - 1u));
+	}
+
+	void WriteEventHeader(FArchive& Ar, const EEventType EventType)
+	{
+		uint8 RawEventType = static_cast<uint8>(EventType);
+		uint32 FrameNumber = static_cast<uint32>(GFrameCounter);
+		Ar << RawEventType;
+		Ar << FrameNumber;
+	}
+
+	bool IsInWorld(const UActorComponent* Component, const UWorld* World)
+	{
+		return IsValid(Component) && !Component->IsTemplate() && Component->GetWorld() == World;
+	}
+
+	struct FControllerState
+	{
+		uint64 Id = 0;
+
+		uint16 PackedStates = 0;
+	};
+
+	struct FKeyringState
+	{
+		uint64 Id = 0;
+
+		TArray<uint16> KeyIndices;
+	};
+
+	void SerializeWorldStates(FArchive& Ar, TArray<FControllerState>& Controllers, TArray<FKeyringState>& Keyrings)
+	{
+		int32 NumControllers = Controllers.Num();
+		Ar << NumControllers;
+
+		if (Ar.IsLoading())
+		{
+			Controllers.SetNum(FMath::Max(NumControllers, 0));
+		}
+
+		for (FControllerState& Controller : Controllers)
+		{
+			Ar << Controller.Id;
+			Ar << Controller.PackedStates;
+		}
+
+		int32 NumKeyrings = Keyrings.Num();
+		Ar << NumKeyrings;
+
+		if (Ar.IsLoading())
+		{
+			Keyrings.SetNum(FMath::Max(NumKeyrings, 0));
+		}
+
+		for (FKeyringState& Keyring : Keyrings)
+		{
+			Ar << Keyring.Id;
+			Ar << Keyring.KeyIndices;
+		}
+	}
+
+	bool ForceState(UDoorStateControllerComponent* Door, const EDoorState NewState, const bool bTransitImmediately)
+	{
+		return IDoorInterface::Execute_ForceDoorState(Door, NewState, bTransitImmediately);
+	}
+
+	bool FinishTransition(UDoorStateControllerComponent* Door)
+	{
+		return IDoorInterface::Execute_FinishDoorStateTransition(Door);
+	}
+
+	bool ReverseTransition(UDoorStateControllerComponent* Door)
+	{
+		return IDoorInterface::Execute_ReverseDoorStateTransition(Door);
+	}
+
+	bool ForceState(UChestStateControllerComponent* Chest, const EChestState NewState, const bool bTransitImmediately)
+	{
+		return IChestInterface::Execute_ForceChestState(Chest, NewState, bTransitImmediately);
+	}
+
+	bool FinishTransition(UChestStateControllerComponent* Chest)
+	{
+		return IChestInterface::Execute_FinishChestStateTransition(Chest);
+	}
+
+	bool ReverseTransition(UChestStateControllerComponent* Chest)
+	{
+		return IChestInterface::Execute_ReverseChestStateTransition(Chest);
+	}
+
+	bool ForceState(ULockStateControllerComponent* Lock, const ELockState NewState, const bool bTransitImmediately)
+	{
+		return ILockInterface::Execute_ForceLockState(Lock, NewState, bTransitImmediately);
+	}
+
+	bool FinishTransition(ULockStateControllerComponent* Lock)
+	{
+		return ILockInterface::Execute_FinishLockStateTransition(Lock);
+	}
+
+	bool ReverseTransition(ULockStateControllerComponent* Lock)
+	{
+		return ILockInterface::Execute_ReverseLockStateTransition(Lock);
+	}
+
+	bool ForceState(UButtonStateControllerComponent* Button,
+	                const EButtonState NewState,
+	                const bool bTransitImmediately)
+	{
+		return IButtonInterface::Execute_ForceButtonState(Button, NewState, bTransitImmediately);
+	}
+
+	bool FinishTransition(UButtonStateControllerComponent* Button)
+	{
+		return IButtonInterface::Execute_FinishButtonStateTransition(Button);
+	}
+
+	bool ReverseTransition(UButtonStateControllerComponent* Button)
+	{
+		return IButtonInterface::Execute_ReverseButtonStateTransition(Button);
+	}
+
+	bool ForceState(UGameplayObjectStateControllerComponent* GameplayObject,
+	                const EGameplayObjectState NewState,
+	                const bool bTransitImmediately)
+	{
+		return IGameplayObjectInterface::Execute_ForceGameplayObjectState(GameplayObject,
+		                                                                  NewState,
+		                                                                  bTransitImmediately);
+	}
+
+	bool FinishTransition(UGameplayObjectStateControllerComponent* GameplayObject)
+	{
+		return IGameplayObjectInterface::Execute_FinishGameplayObjetStateTransition(GameplayObject);
+	}
+
+	bool ReverseTransition(UGameplayObjectStateControllerComponent* GameplayObject)
+	{
+		return IGameplayObjectInterface::Execute_ReverseGameplayObjectStateTransition(GameplayObject);
+	}
+
+	/**
+	 * Calls Func with the controller cast to its component type.
+	 */
+	template <typename FuncType>
+	void VisitController(UActorComponent* Controller, const EStateControllerType Type, FuncType&& Func)
+	{
+		switch (Type)
+		{
+		case EStateControllerType::Door:
+			if (UDoorStateControllerComponent* Door = Cast<UDoorStateControllerComponent>(Controller))
+			{
+				Func(Door);
+			}
+			break;
+
+		case EStateControllerType::Chest:
+			if (UChestStateControllerComponent* Chest = Cast<UChestStateControllerComponent>(Controller))
+			{
+				Func(Chest);
+			}
+			break;
+
+		case EStateControllerType::Lock:
+			if (ULockStateControllerComponent* Lock = Cast<ULockStateControllerComponent>(Controller))
+			{
+				Func(Lock);
+			}
+			break;
+
+		case EStateControllerType::Button:
+			if (UButtonStateControllerComponent* Button = Cast<UButtonStateControllerComponent>(Controller))
+			{
+				Func(Button);
+			}
+			break;
+
+		case EStateControllerType::GameplayObject:
+			if (UGameplayObjectStateControllerComponent* GameplayObject =
+				Cast<UGameplayObjectStateControllerComponent>(Controller))
+			{
+				Func(GameplayObject);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	template <typename ComponentType>
+	bool HasStates(const ComponentType* Controller, const uint16 PackedStates)
+	{
+		return static_cast<uint8>(Controller->GetCurrentState()) == UnpackField(PackedStates, 1)
+			&& static_cast<uint8>(Controller->GetTargetState()) == UnpackField(PackedStates, 2)
+			&& static_cast<uint8>(Controller->GetLastState()) == UnpackField(PackedStates, 3);
+	}
+
+	template <typename ComponentType>
+	void RestoreStates(ComponentType* Controller, const uint16 PackedStates)
+	{
+		using EnumType = decltype(Controller->GetCurrentState());
+
+		Controller->RestoreStates(static_cast<EnumType>(UnpackField(PackedStates, 1)),
+		                          static_cast<EnumType>(UnpackField(PackedStates, 2)),
+		                          static_cast<EnumType>(UnpackField(PackedStates, 3)));
+	}
+
+	/**
+	 * Repeats the recorded change through the controller interface. If the result differs from the recorded states,
+	 * they're restored directly, so the following events are applied to the same states as during the recording.
+	 *
+	 * @return True if the change resulted in the recorded states.
+	 */
+	template <typename ComponentType>
+	bool ApplyStates(ComponentType* Controller, const uint16 PackedStates)
+	{
+		using EnumType = decltype(Controller->GetCurrentState());
+		using FStateController = TStateController<EnumType>;
+
+		const EnumType CurrentState = static_cast<EnumType>(UnpackField(PackedStates, 1));
+		const EnumType TargetState = static_cast<EnumType>(UnpackField(PackedStates, 2));
+		const EnumType LastState = static_cast<EnumType>(UnpackField(PackedStates, 3));
+
+		if (HasStates(Controller, PackedStates))
+		{
+			return true;
+		}
+
+		if (Controller->GetCurrentState() == CurrentState
+			&& Controller->GetTargetState() == LastState
+			&& Controller->GetLastState() == TargetState)
+		{
+			ReverseTransition(Controller);
+		}
+		else if (FStateController::IsTransition(Controller->GetCurrentState())
+			&& Controller->GetTargetState() == CurrentState)
+		{
+			FinishTransition(Controller);
+		}
+		else if (FStateController::IsTransition(CurrentState))
+		{
+			ForceState(Controller, TargetState, false);
+		}
+		else
+		{
+			ForceState(Controller, CurrentState, true);
+		}
+
+		if (HasStates(Controller, PackedStates))
+		{
+			return true;
+		}
+
+		RestoreStates(Controller, PackedStates);
+		return false;
+	}
+
+	bool HasLockKeys(const UKeyringComponent* Keyring, TConstArrayView<TSubclassOf<ULockKeyType>> LockKeys)
+	{
+		TArray<TSubclassOf<ULockKeyType>> AcquiredKeys;
+		IKeyringInterface::Execute_GetAcquiredLockKeys(Keyring, AcquiredKeys);
+
+		if (AcquiredKeys.Num() != LockKeys.Num())
+		{
+			return false;
+		}
+
+		for (const TSubclassOf<ULockKeyType>& LockKey : LockKeys)
+		{
+			if (!AcquiredKeys.Contains(LockKey))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+UStateControllerRecorder* UStateControllerRecorder::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerRecorder>() : nullptr;
+}
+
+void UStateControllerRecorder::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Registry = Collection.InitializeDependency<UStateControllerRegistry>();
+}
+
+void UStateControllerRecorder::Deinitialize()
+{
+	TArray<uint8> DiscardedStream;
+	StopRecording(DiscardedStream);
+	Registry = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UStateControllerRecorder::StartRecording()
+{
+	UWorld* World = GetWorld();
+
+	if (bIsRecording || !IsValid(Registry) || !World)
+	{
+		return;
+	}
+
+	bIsRecording = true;
+	Stream.Reset();
+	ControllerIds.Reset();
+	KeyIndices.Reset();
+
+	FMemoryWriter Ar(Stream);
+	uint32 Magic = RecordingMagic;
+	uint8 Version = RecordingVersion;
+	Ar << Magic;
+	Ar << Version;
+
+	WriteWorldStates(static_cast<uint8>(StateControllerRecorder::EEventType::InitialStates));
+
+	Registry->OnControllerStatesChanged.AddUObject(this, &UStateControllerRecorder::HandleStatesChanged);
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &UStateControllerRecorder::HandleActorSpawned));
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (StateControllerRecorder::IsInWorld(*It, World))
+		{
+			BindKeyring(*It);
+		}
+	}
+}
+
+bool UStateControllerRecorder::StopRecording(TArray<uint8>& OutStream)
+{
+	if (!bIsRecording)
+	{
+		return false;
+	}
+
+	WriteWorldStates(static_cast<uint8>(StateControllerRecorder::EEventType::FinalStates));
+
+	if (IsValid(Registry))
+	{
+		Registry->OnControllerStatesChanged.RemoveAll(this);
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	UnbindKeyrings();
+	ActorSpawnedHandle.Reset();
+	ControllerIds.Empty();
+	KeyIndices.Empty();
+	bIsRecording = false;
+	OutStream = MoveTemp(Stream);
+	return true;
+}
+
+bool UStateControllerRecorder::Replay(const TArray<uint8>& InStream, FStateControllerReplayResult& OutResult)
+{
+	using namespace StateControllerRecorder;
+
+	OutResult = FStateControllerReplayResult();
+	FMemoryReader Ar(InStream);
+
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != RecordingMagic || Version != RecordingVersion || !IsValid(Registry))
+	{
+		return false;
+	}
+
+	const UWorld* World = GetWorld();
+	TMap<uint64, UActorComponent*> Controllers;
+	TMap<uint64, UKeyringComponent*> Keyrings;
+	TArray<TSubclassOf<ULockKeyType>> KeyClasses;
+
+	for (uint8 TypeIndex = 0; TypeIndex < static_cast<uint8>(EStateControllerType::Num); ++TypeIndex)
+	{
+		for (const FStateControllerHandle& Handle : Registry->GetHandles(static_cast<EStateControllerType>(TypeIndex)))
+		{
+			if (UActorComponent* Controller = Registry->ResolveController(Handle))
+			{
+				Controllers.Add(UStateControllerSnapshotSubsystem::GetStableId(Controller), Controller);
+			}
+		}
+	}
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (IsInWorld(*It, World))
+		{
+			Keyrings.Add(UStateControllerSnapshotSubsystem::GetStableId(*It), *It);
+		}
+	}
+
+	auto GetKeyClass = [&KeyClasses](const uint16 KeyIndex)
+	{
+		return KeyClasses.IsValidIndex(KeyIndex) ? KeyClasses[KeyIndex] : TSubclassOf<ULockKeyType>();
+	};
+
+	while (!Ar.AtEnd() && !Ar.IsError())
+	{
+		uint8 RawEventType = 0;
+		uint32 FrameNumber = 0;
+		Ar << RawEventType;
+		Ar << FrameNumber;
+
+		const EEventType EventType = static_cast<EEventType>(RawEventType);
+
+		if (EventType == EEventType::DefineKey)
+		{
+			uint16 KeyIndex = 0;
+			FSoftClassPath KeyPath;
+			Ar << KeyIndex;
+			Ar << KeyPath;
+
+			if (KeyClasses.Num() <= KeyIndex)
+			{
+				KeyClasses.SetNum(KeyIndex + 1);
+			}
+
+			KeyClasses[KeyIndex] = KeyPath.TryLoadClass<ULockKeyType>();
+			continue;
+		}
+
+		if (EventType == EEventType::InitialStates || EventType == EEventType::FinalStates)
+		{
+			const bool bIsFinal = EventType == EEventType::FinalStates;
+			TArray<FControllerState> ControllerStates;
+			TArray<FKeyringState> KeyringStates;
+			SerializeWorldStates(Ar, ControllerStates, KeyringStates);
+
+			for (const FControllerState& State : ControllerStates)
+			{
+				const EStateControllerType Type = static_cast<EStateControllerType>(UnpackField(State.PackedStates, 0));
+
+				VisitController(Controllers.FindRef(State.Id), Type, [&State, &OutResult, bIsFinal](auto* Controller)
+				{
+					if (!bIsFinal)
+					{
+						RestoreStates(Controller, State.PackedStates);
+					}
+					else if (!HasStates(Controller, State.PackedStates))
+					{
+						++OutResult.NumMismatchedFinalStates;
+					}
+				});
+			}
+
+			for (const FKeyringState& State : KeyringStates)
+			{
+				UKeyringComponent* Keyring = Keyrings.FindRef(State.Id);
+
+				if (!Keyring)
+				{
+					continue;
+				}
+
+				TArray<TSubclassOf<ULockKeyType>> LockKeys;
+				Algo::Transform(State.KeyIndices, LockKeys, GetKeyClass);
+
+				if (!bIsFinal)
+				{
+					Keyring->RestoreLockKeys(LockKeys);
+				}
+				else if (!HasLockKeys(Keyring, LockKeys))
+				{
+					++OutResult.NumMismatchedFinalStates;
+				}
+			}
+
+			continue;
+		}
+
+		uint64 Id = 0;
+		Ar << Id;
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		bool bFound = true;
+		bool bMatched = true;
+
+		if (EventType == EEventType::ControllerStates)
+		{
+			uint16 PackedStates = 0;
+			Ar << PackedStates;
+
+			const EStateControllerType Type = static_cast<EStateControllerType>(UnpackField(PackedStates, 0));
+			bFound = false;
+
+			VisitController(Controllers.FindRef(Id), Type, [PackedStates, &bFound, &bMatched](auto* Controller)
+			{
+				bFound = true;
+				bMatched = ApplyStates(Controller, PackedStates);
+			});
+		}
+		else
+		{
+			uint16 KeyIndex = 0;
+
+			if (EventType != EEventType::AllLockKeysRemoved)
+			{
+				Ar << KeyIndex;
+			}
+
+			UKeyringComponent* Keyring = Keyrings.FindRef(Id);
+			bFound = Keyring != nullptr;
+
+			switch (EventType)
+			{
+			case EEventType::LockKeyAdded:
+				bMatched = bFound && IKeyringInterface::Execute_AddLockKey(Keyring, GetKeyClass(KeyIndex));
+				break;
+
+			case EEventType::LockKeyRemoved:
+				bMatched = bFound && IKeyringInterface::Execute_RemoveLockKey(Keyring, GetKeyClass(KeyIndex));
+				break;
+
+			case EEventType::AllLockKeysRemoved:
+				bMatched = bFound && IKeyringInterface::Execute_RemoveAllLockKeys(Keyring);
+				break;
+
+			case EEventType::LockKeyUsed:
+				bMatched = bFound && IKeyringInterface::Execute_UseLockKey(Keyring, GetKeyClass(KeyIndex));
+				break;
+
+			default:
+				// Unknown events can't be skipped, because their size is unknown.
+				Ar.SetError();
+				break;
+			}
+		}
+
+		const double EventSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		OutResult.TotalSeconds += EventSeconds;
+		OutResult.MaxEventSeconds = FMath::Max(OutResult.MaxEventSeconds, EventSeconds);
+		++OutResult.NumEvents;
+		OutResult.NumSkippedEvents += !bFound;
+		OutResult.NumMismatchedEvents += bFound && !bMatched;
+	}
+
+	return !Ar.IsError();
+}
+
+bool UStateControllerRecorder::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStateControllerRecorder::HandleStatesChanged(const FStateControllerHandle& Handle)
+{
+	using namespace StateControllerRecorder;
+
+	uint8 CurrentState = 0;
+	uint8 TargetState = 0;
+	uint8 LastState = 0;
+
+	if (!Registry->GetRawStates(Handle, CurrentState, TargetState, LastState))
+	{
+		return;
+	}
+
+	uint64* Id = ControllerIds.Find(Handle);
+
+	if (!Id)
+	{
+		const uint64 NewId = UStateControllerSnapshotSubsystem::GetStableId(Registry->ResolveController(Handle));
+		Id = &ControllerIds.Add(Handle, NewId);
+	}
+
+	uint16 PackedStates = PackStates(Handle.Type, CurrentState, TargetState, LastState);
+
+	FMemoryWriter Ar(Stream, false, true);
+	WriteEventHeader(Ar, EEventType::ControllerStates);
+	Ar << *Id;
+	Ar << PackedStates;
+}
+
+void UStateControllerRecorder::HandleActorSpawned(AActor* Actor)
+{
+	TInlineComponentArray<UKeyringComponent*> ActorKeyrings(Actor);
+
+	for (UKeyringComponent* Keyring : ActorKeyrings)
+	{
+		BindKeyring(Keyring);
+	}
+}
+
+void UStateControllerRecorder::BindKeyring(UKeyringComponent* Keyring)
+{
+	Keyring->OnLockKeyAdded.AddUniqueDynamic(this, &UStateControllerRecorder::HandleLockKeyAdded);
+	Keyring->OnLockKeyRemoved.AddUniqueDynamic(this, &UStateControllerRecorder::HandleLockKeyRemoved);
+	Keyring->OnAllLockKeysRemoved.AddUniqueDynamic(this, &UStateControllerRecorder::HandleAllLockKeysRemoved);
+	Keyring->OnLockKeyUsed.AddUniqueDynamic(this, &UStateControllerRecorder::HandleLockKeyUsed);
+}
+
+void UStateControllerRecorder::UnbindKeyrings()
+{
+	const UWorld* World = GetWorld();
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (StateControllerRecorder::IsInWorld(*It, World))
+		{
+			It->OnLockKeyAdded.RemoveAll(this);
+			It->OnLockKeyRemoved.RemoveAll(this);
+			It->OnAllLockKeysRemoved.RemoveAll(this);
+			It->OnLockKeyUsed.RemoveAll(this);
+		}
+	}
+}
+
+void UStateControllerRecorder::HandleLockKeyAdded(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey)
+{
+	WriteKeyEvent(static_cast<uint8>(StateControllerRecorder::EEventType::LockKeyAdded), Component, LockKey);
+}
+
+void UStateControllerRecorder::HandleLockKeyRemoved(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey)
+{
+	// Replaying the preceding LockKeyUsed event consumes the key again.
+	if (IsValid(Component) && Component->IsConsumingLockKey())
+	{
+		return;
+	}
+
+	WriteKeyEvent(static_cast<uint8>(StateControllerRecorder::EEventType::LockKeyRemoved), Component, LockKey);
+}
+
+void UStateControllerRecorder::HandleAllLockKeysRemoved(UKeyringComponent* Component)
+{
+	WriteKeyEvent(static_cast<uint8>(StateControllerRecorder::EEventType::AllLockKeysRemoved), Component, nullptr);
+}
+
+void UStateControllerRecorder::HandleLockKeyUsed(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey)
+{
+	WriteKeyEvent(static_cast<uint8>(StateControllerRecorder::EEventType::LockKeyUsed), Component, LockKey);
+}
+
+void UStateControllerRecorder::WriteKeyEvent(const uint8 EventType,
+                                             const UKeyringComponent* Keyring,
+                                             const UClass* LockKey)
+{
+	using namespace StateControllerRecorder;
+
+	FMemoryWriter Ar(Stream, false, true);
+
+	// The key is defined before the event which uses it.
+	uint16 KeyIndex = LockKey ? GetKeyIndex(Ar, LockKey) : 0;
+	uint64 Id = UStateControllerSnapshotSubsystem::GetStableId(Keyring);
+
+	WriteEventHeader(Ar, static_cast<EEventType>(EventType));
+	Ar << Id;
+
+	if (static_cast<EEventType>(EventType) != EEventType::AllLockKeysRemoved)
+	{
+		Ar << KeyIndex;
+	}
+}
+
+uint16 UStateControllerRecorder::GetKeyIndex(FArchive& Ar, const UClass* LockKey)
+{
+	using namespace StateControllerRecorder;
+
+	if (const uint16* KeyIndex = KeyIndices.Find(LockKey))
+	{
+		return *KeyIndex;
+	}
+
+	uint16 KeyIndex = static_cast<uint16>(KeyIndices.Num());
+	FSoftClassPath KeyPath(LockKey);
+	KeyIndices.Add(LockKey, KeyIndex);
+
+	WriteEventHeader(Ar, EEventType::DefineKey);
+	Ar << KeyIndex;
+	Ar << KeyPath;
+	return KeyIndex;
+}
+
+void UStateControllerRecorder::WriteWorldStates(const uint8 EventType)
+{
+	using namespace StateControllerRecorder;
+
+	const UWorld* World = GetWorld();
+	FMemoryWriter Ar(Stream, false, true);
+	TArray<FControllerState> ControllerStates;
+	TArray<FKeyringState> KeyringStates;
+
+	for (uint8 TypeIndex = 0; TypeIndex < static_cast<uint8>(EStateControllerType::Num); ++TypeIndex)
+	{
+		const EStateControllerType Type = static_cast<EStateControllerType>(TypeIndex);
+
+		for (const FStateControllerHandle& Handle : Registry->GetHandles(Type))
+		{
+			uint8 CurrentState = 0;
+			uint8 TargetState = 0;
+			uint8 LastState = 0;
+			Registry->GetRawStates(Handle, CurrentState, TargetState, LastState);
+
+			FControllerState& State = ControllerStates.AddDefaulted_GetRef();
+			State.Id = UStateControllerSnapshotSubsystem::GetStableId(Registry->ResolveController(Handle));
+			State.PackedStates = PackStates(Type, CurrentState, TargetState, LastState);
+		}
+	}
+
+	TArray<TSubclassOf<ULockKeyType>> AcquiredKeys;
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (!IsInWorld(*It, World))
+		{
+			continue;
+		}
+
+		IKeyringInterface::Execute_GetAcquiredLockKeys(*It, AcquiredKeys);
+
+		FKeyringState& State = KeyringStates.AddDefaulted_GetRef();
+		State.Id = UStateControllerSnapshotSubsystem::GetStableId(*It);
+
+		for (const TSubclassOf<ULockKeyType>& LockKey : AcquiredKeys)
+		{
+			State.KeyIndices.Add(GetKeyIndex(Ar, LockKey));
+		}
+	}
+
+	WriteEventHeader(Ar, static_cast<EEventType>(EventType));
+	SerializeWorldStates(Ar, ControllerStates, KeyringStates);
+}
+
+namespace StateControllerRecorder
+{
+	FString GetRecordingPath(const TArray<FString>& Args)
+	{
+		const FString FileName = Args.IsEmpty() ? TEXT("StateRecording") : Args[0];
+		return FPaths::ProjectSavedDir() / TEXT("StateRecordings") / FileName + TEXT(".bin");
+	}
+
+	void ExecuteStartRecording(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (UStateControllerRecorder* Recorder = UStateControllerRecorder::Get(World))
+		{
+			Recorder->StartRecording();
+			Ar.Log(TEXT("State recording started"));
+		}
+	}
+
+	void ExecuteStopRecording(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UStateControllerRecorder* Recorder = UStateControllerRecorder::Get(World);
+		TArray<uint8> RecordedStream;
+
+		if (!Recorder || !Recorder->StopRecording(RecordedStream))
+		{
+			Ar.Log(TEXT("State recording isn't in progress"));
+			return;
+		}
+
+		const FString Path = GetRecordingPath(Args);
+
+		if (FFileHelper::SaveArrayToFile(RecordedStream, *Path))
+		{
+			Ar.Logf(TEXT("State recording saved to %s (%d bytes)"), *Path, RecordedStream.Num());
+		}
+	}
+
+	void ExecuteReplay(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		UStateControllerRecorder* Recorder = UStateControllerRecorder::Get(World);
+		const FString Path = GetRecordingPath(Args);
+		TArray<uint8> RecordedStream;
+
+		if (!Recorder || !FFileHelper::LoadFileToArray(RecordedStream, *Path))
+		{
+			Ar.Logf(TEXT("Can't load the state recording %s"), *Path);
+			return;
+		}
+
+		FStateControllerReplayResult Result;
+
+		if (!Recorder->Replay(RecordedStream, Result))
+		{
+			Ar.Logf(TEXT("%s isn't a valid state recording"), *Path);
+			return;
+		}
+
+		Ar.Logf(TEXT("Replayed %d events in %.3f ms | %.0f events/s | Avg: %.3f us | Max: %.3f us"),
+		        Result.NumEvents,
+		        Result.TotalSeconds * 1000.0,
+		        Result.GetEventsPerSecond(),
+		        Result.GetAverageEventSeconds() * 1000000.0,
+		        Result.MaxEventSeconds * 1000000.0);
+		Ar.Logf(TEXT("Skipped: %d | Mismatched: %d | Mismatched final states: %d"),
+		        Result.NumSkippedEvents,
+		        Result.NumMismatchedEvents,
+		        Result.NumMismatchedFinalStates);
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice StartRecordingCommand(
+		TEXT("TrickyGameplayObjects.StartRecording"),
+		TEXT("Starts recording the state changes and keyring operations in the world."),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteStartRecording));
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice StopRecordingCommand(
+		TEXT("TrickyGameplayObjects.StopRecording"),
+		TEXT("Stops the recording and saves it to Saved/StateRecordings. Usage: [FileName]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteStopRecording));
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice ReplayCommand(
+		TEXT("TrickyGameplayObjects.Replay"),
+		TEXT("Replays a recording from Saved/StateRecordings and prints the results. Usage: [FileName]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ExecuteReplay));
+}
@@ -0,0 +1,119 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerRegistry.h"
+
+#include "Components/ActorComponent.h"
+#include "Engine/World.h"
+
+UStateControllerRegistry* UStateControllerRegistry::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerRegistry>() : nullptr;
+}
+
+void UStateControllerRegistry::Deinitialize()
+{
+	for (FControllerStorage& Storage : Storages)
+	{
+		Storage = FControllerStorage();
+	}
+
+	OnControllerRegistered.Clear();
+	OnControllerUnregistered.Clear();
+	OnControllerStatesChanged.Clear();
+
+	Super::Deinitialize();
+}
+
+void UStateControllerRegistry::UnregisterController(FStateControllerHandle& Handle)
+{
+	if (!IsValidHandle(Handle))
+	{
+		Handle.Reset();
+		return;
+	}
+
+	OnControllerUnregistered.Broadcast(Handle, ResolveController(Handle));
+
+	// Listeners may have changed the registry, so the dense index is fetched after the broadcast.
+	const int32 DenseIndex = GetDenseIndex(Handle);
+
+	if (DenseIndex == INDEX_NONE)
+	{
+		Handle.Reset();
+		return;
+	}
+
+	FControllerStorage& Storage = GetStorage(Handle.Type);
+	const int32 LastIndex = Storage.Handles.Num() - 1;
+
+	if (DenseIndex != LastIndex)
+	{
+		Storage.DenseIndices[Storage.Handles[LastIndex].Index] = DenseIndex;
+	}
+
+	Storage.CurrentStates.RemoveAtSwap(DenseIndex, 1, false);
+	Storage.TargetStates.RemoveAtSwap(DenseIndex, 1, false);
+	Storage.LastStates.RemoveAtSwap(DenseIndex, 1, false);
+	Storage.Handles.RemoveAtSwap(DenseIndex, 1, false);
+	Storage.Controllers.RemoveAtSwap(DenseIndex, 1, false);
+
+	Storage.DenseIndices[Handle.Index] = INDEX_NONE;
+	// Invalidate all the copies of the handle.
+	++Storage.Serials[Handle.Index];
+	Storage.FreeIndices.Add(Handle.Index);
+	Handle.Reset();
+}
+
+UActorComponent* UStateControllerRegistry::ResolveController(const FStateControllerHandle& Handle) const
+{
+	const int32 DenseIndex = GetDenseIndex(Handle);
+	return DenseIndex == INDEX_NONE ? nullptr : GetStorage(Handle.Type).Controllers[DenseIndex].Get();
+}
+
+bool UStateControllerRegistry::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FStateControllerHandle UStateControllerRegistry::RegisterControllerInternal(UActorComponent* Controller,
+                                                                            const EStateControllerType Type,
+                                                                            const uint8 CurrentState,
+                                                                            const uint8 TargetState,
+                                                                            const uint8 LastState,
+                                                                            const uint8 TransitionState)
+{
+	if (!IsValid(Controller) || Type >= EStateControllerType::Num)
+	{
+		return FStateControllerHandle();
+	}
+
+	FControllerStorage& Storage = GetStorage(Type);
+	Storage.TransitionState = TransitionState;
+	uint32 Index = 0;
+
+	if (!Storage.FreeIndices.IsEmpty())
+	{
+		Index = Storage.FreeIndices.Pop(false);
+	}
+	else
+	{
+		Index = Storage.Serials.Add(0);
+		Storage.DenseIndices.Add(INDEX_NONE);
+	}
+
+	// Serial 0 is reserved for unset handles.
+	uint32& Serial = Storage.Serials[Index];
+	Serial = FMath::Max(Serial, 1u);
+
+	const FStateControllerHandle Handle(Index, Serial, Type);
+	Storage.DenseIndices[Index] = Storage.Handles.Add(Handle);
+	Storage.CurrentStates.Add(CurrentState);
+	Storage.TargetStates.Add(TargetState);
+	Storage.LastStates.Add(LastState);
+	Storage.Controllers.Add(Controller);
+
+	OnControllerRegistered.Broadcast(Handle, Controller);
+	return Handle;
+}
@@ -0,0 +1,28 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerReplicatedStates.h"
+
+bool FStateControllerReplicatedStates::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedStates = 0;
+
+	if (Ar.IsSaving())
+	{
+		PackedStates = (CurrentState & StateMask)
+			| (TargetState & StateMask) << BitsPerState
+			| (LastState & StateMask) << BitsPerState * 2;
+	}
+
+	Ar.SerializeBits(&PackedStates, BitsPerState * 3);
+
+	if (Ar.IsLoading())
+	{
+		CurrentState = static_cast<uint8>(PackedStates & StateMask);
+		TargetState = static_cast<uint8>(PackedStates >> BitsPerState & StateMask);
+		LastState = static_cast<uint8>(PackedStates >> BitsPerState * 2 & StateMask);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
@@ -0,0 +1,909 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerSnapshotSubsystem.h"
+
+#include "Engine/World.h"
+#include "Hash/CityHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/SoftObjectPath.h"
+#include "UObject/UObjectIterator.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+#include "LockKey/KeyringComponent.h"
+#include "LockKey/LockKeyType.h"
+#include "StateController/StateControllerPersistenceSubsystem.h"
+#include "StateController/StateControllerRegistry.h"
+#include "StateController/StateControllerTransitionScheduler.h"
+#include "TrickyGameplayObjectsStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Save Snapshot"), STAT_SaveStateSnapshot, STATGROUP_TrickyGameplayObjects);
+DECLARE_CYCLE_STAT(TEXT("Save Delta"), STAT_SaveStateDelta, STATGROUP_TrickyGameplayObjects);
+DECLARE_CYCLE_STAT(TEXT("Restore Snapshot"), STAT_RestoreStateSnapshot, STATGROUP_TrickyGameplayObjects);
+DECLARE_CYCLE_STAT(TEXT("Compact Snapshots"), STAT_CompactStateSnapshots, STATGROUP_TrickyGameplayObjects);
+
+namespace StateControllerSnapshot
+{
+	/**
+	 * Type and all four states of a controller are packed into 15 bits.
+	 */
+	constexpr uint32 BitsPerField = 3;
+
+	constexpr uint32 FieldMask = (1u << BitsPerField) - 1u;
+
+	template <typename ComponentType>
+	using TStateEnum = decltype(DeclVal<const ComponentType&>().GetCurrentState());
+
+	uint8 UnpackField(const uint16 PackedStates, const uint32 FieldIndex)
+	{
+		return static_cast<uint8>(PackedStates >> FieldIndex * BitsPerField & FieldMask);
+	}
+
+	uint16 PackFields(const uint32 Type,
+	                  const uint32 InitialState,
+	                  const uint32 CurrentState,
+	                  const uint32 TargetState,
+	                  const uint32 LastState)
+	{
+		return static_cast<uint16>(Type
+			| InitialState << BitsPerField
+			| CurrentState << BitsPerField * 2
+			| TargetState << BitsPerField * 3
+			| LastState << BitsPerField * 4);
+	}
+
+	template <typename EnumType>
+	constexpr uint8 GetRawTransitionState()
+	{
+		return static_cast<uint8>(TStateControllerTraits<EnumType>::TransitionState);
+	}
+
+	/**
+	 * Returns MAX_uint8 for unknown controller types.
+	 */
+	uint8 GetRawTransitionState(const EStateControllerType Type)
+	{
+		switch (Type)
+		{
+		case EStateControllerType::Door:
+			return GetRawTransitionState<EDoorState>();
+
+		case EStateControllerType::Chest:
+			return GetRawTransitionState<EChestState>();
+
+		case EStateControllerType::Lock:
+			return GetRawTransitionState<ELockState>();
+
+		case EStateControllerType::Button:
+			return GetRawTransitionState<EButtonState>();
+
+		case EStateControllerType::GameplayObject:
+			return GetRawTransitionState<EGameplayObjectState>();
+
+		default:
+			return MAX_uint8;
+		}
+	}
+
+	struct FControllerRecord
+	{
+		uint64 Id = 0;
+
+		/** Type, InitialState, CurrentState, TargetState and LastState. */
+		uint16 PackedStates = 0;
+
+		/** Only serialized if CurrentState is Transition. */
+		float TransitionTimeLeft = -1.f;
+
+		EStateControllerType GetType() const { return static_cast<EStateControllerType>(UnpackField(PackedStates, 0)); }
+
+		template <typename EnumType>
+		EnumType GetState(const uint32 FieldIndex) const
+		{
+			return static_cast<EnumType>(UnpackField(PackedStates, FieldIndex));
+		}
+
+		FStateControllerSnapshotRecord ToSnapshotRecord() const
+		{
+			FStateControllerSnapshotRecord Record;
+			Record.Id = Id;
+			Record.Type = GetType();
+			Record.InitialState = UnpackField(PackedStates, 1);
+			Record.CurrentState = UnpackField(PackedStates, 2);
+			Record.TargetState = UnpackField(PackedStates, 3);
+			Record.LastState = UnpackField(PackedStates, 4);
+			Record.TransitionTimeLeft = TransitionTimeLeft;
+			return Record;
+		}
+
+		static FControllerRecord FromSnapshotRecord(const FStateControllerSnapshotRecord& SnapshotRecord)
+		{
+			FControllerRecord Record;
+			Record.Id = SnapshotRecord.Id;
+			Record.PackedStates = PackFields(static_cast<uint32>(SnapshotRecord.Type),
+			                                 SnapshotRecord.InitialState,
+			                                 SnapshotRecord.CurrentState,
+			                                 SnapshotRecord.TargetState,
+			                                 SnapshotRecord.LastState);
+			Record.TransitionTimeLeft = SnapshotRecord.TransitionTimeLeft;
+			return Record;
+		}
+	};
+
+	/**
+	 * Reads or writes the record depending on the archive.
+	 */
+	void SerializeRecord(FArchive& Ar, FControllerRecord& Record)
+	{
+		Ar << Record.Id;
+		Ar << Record.PackedStates;
+
+		const uint8 TransitionState = GetRawTransitionState(Record.GetType());
+
+		if (TransitionState == MAX_uint8)
+		{
+			// Unknown types can't be skipped, because the size of their records is unknown.
+			Ar.SetError();
+			return;
+		}
+
+		// The remaining time is only meaningful during transitions, so it isn't stored for the rest.
+		if (UnpackField(Record.PackedStates, 2) == TransitionState)
+		{
+			Ar << Record.TransitionTimeLeft;
+		}
+	}
+
+	template <typename ComponentType>
+	FControllerRecord MakeRecord(const ComponentType* Controller,
+	                             const EStateControllerType Type,
+	                             const UStateControllerTransitionScheduler* Scheduler)
+	{
+		using EnumType = TStateEnum<ComponentType>;
+
+		FControllerRecord Record;
+		Record.Id = UStateControllerSnapshotSubsystem::GetStableId(Controller);
+		Record.PackedStates = PackFields(static_cast<uint32>(Type),
+		                                 static_cast<uint32>(Controller->GetInitialState()),
+		                                 static_cast<uint32>(Controller->GetCurrentState()),
+		                                 static_cast<uint32>(Controller->GetTargetState()),
+		                                 static_cast<uint32>(Controller->GetLastState()));
+
+		if (TStateController<EnumType>::IsTransition(Controller->GetCurrentState()) && Scheduler)
+		{
+			Record.TransitionTimeLeft = Scheduler->GetRemainingTime(Controller);
+		}
+
+		return Record;
+	}
+
+	/**
+	 * @return False if the controller type is unknown.
+	 */
+	bool MakeControllerRecord(const UActorComponent* Controller,
+	                          const EStateControllerType Type,
+	                          const UStateControllerTransitionScheduler* Scheduler,
+	                          FControllerRecord& OutRecord)
+	{
+		switch (Type)
+		{
+		case EStateControllerType::Door:
+			OutRecord = MakeRecord(CastChecked<UDoorStateControllerComponent>(Controller), Type, Scheduler);
+			return true;
+
+		case EStateControllerType::Chest:
+			OutRecord = MakeRecord(CastChecked<UChestStateControllerComponent>(Controller), Type, Scheduler);
+			return true;
+
+		case EStateControllerType::Lock:
+			OutRecord = MakeRecord(CastChecked<ULockStateControllerComponent>(Controller), Type, Scheduler);
+			return true;
+
+		case EStateControllerType::Button:
+			OutRecord = MakeRecord(CastChecked<UButtonStateControllerComponent>(Controller), Type, Scheduler);
+			return true;
+
+		case EStateControllerType::GameplayObject:
+			OutRecord = MakeRecord(CastChecked<UGameplayObjectStateControllerComponent>(Controller), Type, Scheduler);
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	template <typename ComponentType>
+	void ApplyRecord(const FControllerRecord& Record, UActorComponent* FoundController, const bool bBroadcastEvents)
+	{
+		using EnumType = TStateEnum<ComponentType>;
+
+		ComponentType* Controller = Cast<ComponentType>(FoundController);
+
+		if (!Controller)
+		{
+			return;
+		}
+
+		Controller->RestoreInitialState(Record.GetState<EnumType>(1));
+		Controller->RestoreStates(Record.GetState<EnumType>(2),
+		                          Record.GetState<EnumType>(3),
+		                          Record.GetState<EnumType>(4),
+		                          Record.TransitionTimeLeft,
+		                          bBroadcastEvents);
+	}
+
+	struct FKeyringRecord
+	{
+		uint64 Id = 0;
+
+		TArray<FSoftClassPath> LockKeys;
+	};
+
+	/**
+	 * Key classes are written once and referenced by index from the keyrings.
+	 */
+	void WriteKeyringRecords(FArchive& Ar, TConstArrayView<FKeyringRecord> Records)
+	{
+		TMap<FSoftClassPath, uint16> KeyIndices;
+		TArray<FSoftClassPath> KeyPaths;
+
+		for (const FKeyringRecord& Record : Records)
+		{
+			for (const FSoftClassPath& LockKey : Record.LockKeys)
+			{
+				if (!KeyIndices.Contains(LockKey))
+				{
+					KeyIndices.Add(LockKey, static_cast<uint16>(KeyPaths.Add(LockKey)));
+				}
+			}
+		}
+
+		Ar << KeyPaths;
+
+		int32 NumKeyrings = Records.Num();
+		Ar << NumKeyrings;
+
+		for (const FKeyringRecord& Record : Records)
+		{
+			uint64 Id = Record.Id;
+			uint16 NumKeys = static_cast<uint16>(Record.LockKeys.Num());
+			Ar << Id;
+			Ar << NumKeys;
+
+			for (const FSoftClassPath& LockKey : Record.LockKeys)
+			{
+				uint16 KeyIndex = KeyIndices.FindChecked(LockKey);
+				Ar << KeyIndex;
+			}
+		}
+	}
+
+	void ReadKeyringRecords(FArchive& Ar, TArray<FKeyringRecord>& OutRecords)
+	{
+		TArray<FSoftClassPath> KeyPaths;
+		Ar << KeyPaths;
+
+		int32 NumKeyrings = 0;
+		Ar << NumKeyrings;
+
+		if (Ar.IsError() || NumKeyrings < 0)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		for (int32 Index = 0; Index < NumKeyrings && !Ar.IsError(); ++Index)
+		{
+			FKeyringRecord& Record = OutRecords.AddDefaulted_GetRef();
+			uint16 NumKeys = 0;
+			Ar << Record.Id;
+			Ar << NumKeys;
+
+			Record.LockKeys.Reserve(NumKeys);
+
+			for (uint16 KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+			{
+				uint16 KeyPathIndex = 0;
+				Ar << KeyPathIndex;
+
+				if (KeyPaths.IsValidIndex(KeyPathIndex))
+				{
+					Record.LockKeys.Add(KeyPaths[KeyPathIndex]);
+				}
+			}
+		}
+	}
+
+	/**
+	 * The stored states of the streamed out controllers follow the keyrings. Deltas write them only if they changed,
+	 * and the last written ones replace the previous ones.
+	 */
+	void WriteStoredStates(FArchive& Ar, TArray<uint64>& Keys, TArray<uint16>& PackedStates)
+	{
+		bool bHasStoredStates = true;
+		Ar << bHasStoredStates;
+		Keys.BulkSerialize(Ar);
+		PackedStates.BulkSerialize(Ar);
+	}
+
+	/**
+	 * @return False if the stored states weren't written.
+	 */
+	bool ReadStoredStates(FArchive& Ar, TArray<uint64>& OutKeys, TArray<uint16>& OutPackedStates)
+	{
+		bool bHasStoredStates = false;
+		Ar << bHasStoredStates;
+
+		if (Ar.IsError() || !bHasStoredStates)
+		{
+			return false;
+		}
+
+		OutKeys.BulkSerialize(Ar);
+		OutPackedStates.BulkSerialize(Ar);
+
+		if (OutKeys.Num() != OutPackedStates.Num())
+		{
+			Ar.SetError();
+		}
+
+		return !Ar.IsError();
+	}
+
+	/**
+	 * @return False if the data isn't a snapshot of the current version.
+	 */
+	bool ReadHeader(FArchive& Ar, const uint32 ExpectedMagic, const uint8 ExpectedVersion, bool& bOutIsDelta)
+	{
+		uint32 Magic = 0;
+		uint8 Version = 0;
+		bool bIsDelta = false;
+		Ar << Magic;
+		Ar << Version;
+		Ar << bIsDelta;
+		bOutIsDelta = bIsDelta;
+		return !Ar.IsError() && Magic == ExpectedMagic && Version == ExpectedVersion;
+	}
+}
+
+UStateControllerSnapshotSubsystem* UStateControllerSnapshotSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerSnapshotSubsystem>() : nullptr;
+}
+
+void UStateControllerSnapshotSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	MaxDeltasPerSnapshot = FMath::Max(MaxDeltasPerSnapshot, 0);
+	Registry = Collection.InitializeDependency<UStateControllerRegistry>();
+
+	if (!IsValid(Registry))
+	{
+		return;
+	}
+
+	Registry->OnControllerStatesChanged.AddUObject(this, &UStateControllerSnapshotSubsystem::MarkControllerDirty);
+	Registry->OnControllerUnregistered.AddUObject(this, &UStateControllerSnapshotSubsystem::RemoveController);
+}
+
+void UStateControllerSnapshotSubsystem::Deinitialize()
+{
+	if (IsValid(Registry))
+	{
+		Registry->OnControllerStatesChanged.RemoveAll(this);
+		Registry->OnControllerUnregistered.RemoveAll(this);
+	}
+
+	for (TBitArray<>& Flags : DirtyFlags)
+	{
+		Flags.Empty();
+	}
+
+	DirtyHandles.Empty();
+	RemovedRecords.Empty();
+	OnSavingControllers.Clear();
+	OnRestoringControllers.Clear();
+	NumDeltasSinceSnapshot = 0;
+	Registry = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UStateControllerSnapshotSubsystem::SaveSnapshot(TArray<uint8>& OutData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SaveStateSnapshot);
+
+	OutData.Reset();
+	FMemoryWriter Ar(OutData);
+	WriteHeader(Ar, false);
+	SaveControllers(Ar, false);
+	SaveKeyrings(Ar);
+	SaveStoredStates(Ar, false);
+
+	ClearDirtyControllers();
+	NumDeltasSinceSnapshot = 0;
+}
+
+void UStateControllerSnapshotSubsystem::SaveDelta(TArray<uint8>& OutData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SaveStateDelta);
+
+	OutData.Reset();
+	FMemoryWriter Ar(OutData);
+	WriteHeader(Ar, true);
+	SaveControllers(Ar, true);
+	SaveKeyrings(Ar);
+	SaveStoredStates(Ar, true);
+
+	ClearDirtyControllers();
+	++NumDeltasSinceSnapshot;
+}
+
+bool UStateControllerSnapshotSubsystem::RestoreSnapshot(const TArray<uint8>& Data, const bool bBroadcastEvents)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RestoreStateSnapshot);
+
+	FMemoryReader Ar(Data);
+	bool bIsDelta = false;
+
+	if (!StateControllerSnapshot::ReadHeader(Ar, SnapshotMagic, SnapshotVersion, bIsDelta))
+	{
+		return false;
+	}
+
+	RestoreControllers(Ar, bBroadcastEvents);
+	RestoreKeyrings(Ar, bBroadcastEvents);
+	RestoreStoredStates(Ar);
+
+	// The restored states are already saved, so they must not get into the next delta.
+	ClearDirtyControllers();
+	return !Ar.IsError();
+}
+
+bool UStateControllerSnapshotSubsystem::CompactSnapshots(TConstArrayView<TArray<uint8>> Snapshots,
+                                                         TArray<uint8>& OutSnapshot)
+{
+	using namespace StateControllerSnapshot;
+
+	SCOPE_CYCLE_COUNTER(STAT_CompactStateSnapshots);
+
+	TMap<uint64, FControllerRecord> ControllerRecords;
+	TMap<uint64, TArray<FSoftClassPath>> KeyringKeys;
+	TArray<FKeyringRecord> KeyringRecords;
+	TArray<uint64> StoredKeys;
+	TArray<uint16> StoredPackedStates;
+
+	for (int32 SnapshotIndex = 0; SnapshotIndex < Snapshots.Num(); ++SnapshotIndex)
+	{
+		FMemoryReader Ar(Snapshots[SnapshotIndex]);
+		bool bIsDelta = false;
+
+		if (!ReadHeader(Ar, SnapshotMagic, SnapshotVersion, bIsDelta) || (SnapshotIndex == 0 && bIsDelta))
+		{
+			return false;
+		}
+
+		int32 NumControllers = 0;
+		Ar << NumControllers;
+		ControllerRecords.Reserve(ControllerRecords.Num() + NumControllers);
+
+		for (int32 Index = 0; Index < NumControllers && !Ar.IsError(); ++Index)
+		{
+			FControllerRecord Record;
+			SerializeRecord(Ar, Record);
+			ControllerRecords.Add(Record.Id, Record);
+		}
+
+		KeyringRecords.Reset();
+		ReadKeyringRecords(Ar, KeyringRecords);
+
+		for (FKeyringRecord& Record : KeyringRecords)
+		{
+			KeyringKeys.Add(Record.Id, MoveTemp(Record.LockKeys));
+		}
+
+		ReadStoredStates(Ar, StoredKeys, StoredPackedStates);
+
+		if (Ar.IsError())
+		{
+			return false;
+		}
+	}
+
+	OutSnapshot.Reset();
+	FMemoryWriter Ar(OutSnapshot);
+
+	WriteHeader(Ar, false);
+
+	int32 NumControllers = ControllerRecords.Num();
+	Ar << NumControllers;
+
+	for (TPair<uint64, FControllerRecord>& Pair : ControllerRecords)
+	{
+		SerializeRecord(Ar, Pair.Value);
+	}
+
+	KeyringRecords.Reset(KeyringKeys.Num());
+
+	for (TPair<uint64, TArray<FSoftClassPath>>& Pair : KeyringKeys)
+	{
+		FKeyringRecord& Record = KeyringRecords.AddDefaulted_GetRef();
+		Record.Id = Pair.Key;
+		Record.LockKeys = MoveTemp(Pair.Value);
+	}
+
+	WriteKeyringRecords(Ar, KeyringRecords);
+	WriteStoredStates(Ar, StoredKeys, StoredPackedStates);
+	return true;
+}
+
+uint64 UStateControllerSnapshotSubsystem::GetStableId(const UObject* Object)
+{
+	if (!IsValid(Object))
+	{
+		return 0;
+	}
+
+	const FString PathName = UWorld::RemovePIEPrefix(Object->GetPathName());
+	return CityHash64(reinterpret_cast<const char*>(*PathName), PathName.Len() * sizeof(TCHAR));
+}
+
+bool UStateControllerSnapshotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStateControllerSnapshotSubsystem::MarkControllerDirty(const FStateControllerHandle& Handle)
+{
+	TBitArray<>& Flags = DirtyFlags[static_cast<uint8>(Handle.Type)];
+	const int32 Index = static_cast<int32>(Handle.Index);
+
+	if (Flags.Num() <= Index)
+	{
+		Flags.PadToNum(Index + 1, false);
+	}
+
+	if (Flags[Index])
+	{
+		return;
+	}
+
+	Flags[Index] = true;
+	DirtyHandles.Add(Handle);
+}
+
+void UStateControllerSnapshotSubsystem::RemoveController(const FStateControllerHandle& Handle,
+                                                         UActorComponent* Controller)
+{
+	TBitArray<>& Flags = DirtyFlags[static_cast<uint8>(Handle.Type)];
+	const int32 Index = static_cast<int32>(Handle.Index);
+
+	if (Index >= Flags.Num() || !Flags[Index])
+	{
+		return;
+	}
+
+	// The handle index is reused by the next registered controller, so the flag must not stay set.
+	Flags[Index] = false;
+	DirtyHandles.RemoveSingleSwap(Handle);
+
+	// The change wasn't saved yet, so the final states are kept for the next save.
+	const UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(this);
+	StateControllerSnapshot::FControllerRecord Record;
+
+	if (IsValid(Controller)
+		&& StateControllerSnapshot::MakeControllerRecord(Controller, Handle.Type, Scheduler, Record))
+	{
+		RemovedRecords.Add(Record.Id, Record.ToSnapshotRecord());
+	}
+}
+
+void UStateControllerSnapshotSubsystem::ClearDirtyControllers()
+{
+	for (const FStateControllerHandle& Handle : DirtyHandles)
+	{
+		DirtyFlags[static_cast<uint8>(Handle.Type)][static_cast<int32>(Handle.Index)] = false;
+	}
+
+	DirtyHandles.Reset();
+	RemovedRecords.Reset();
+}
+
+void UStateControllerSnapshotSubsystem::WriteHeader(FArchive& Ar, const bool bIsDelta)
+{
+	uint32 Magic = SnapshotMagic;
+	uint8 Version = SnapshotVersion;
+	bool bIsDeltaValue = bIsDelta;
+	Ar << Magic;
+	Ar << Version;
+	Ar << bIsDeltaValue;
+}
+
+void UStateControllerSnapshotSubsystem::SaveControllers(FArchive& Ar, const bool bOnlyDirty) const
+{
+	using namespace StateControllerSnapshot;
+
+	const UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(this);
+
+	// The number of controllers is patched after writing them, because some handles may not resolve.
+	const int64 NumControllersOffset = Ar.Tell();
+	int32 NumControllers = 0;
+	Ar << NumControllers;
+
+	auto WriteController = [this, &Ar, &NumControllers, Scheduler](const FStateControllerHandle& Handle)
+	{
+		const UActorComponent* Controller = Registry->ResolveController(Handle);
+
+		if (!IsValid(Controller))
+		{
+			return;
+		}
+
+		FControllerRecord Record;
+
+		if (MakeControllerRecord(Controller, Handle.Type, Scheduler, Record))
+		{
+			SerializeRecord(Ar, Record);
+			++NumControllers;
+		}
+	};
+
+	auto WriteSnapshotRecord = [&Ar, &NumControllers](const FStateControllerSnapshotRecord& SnapshotRecord)
+	{
+		FControllerRecord Record = FControllerRecord::FromSnapshotRecord(SnapshotRecord);
+		SerializeRecord(Ar, Record);
+		++NumControllers;
+	};
+
+	// Restoring and compacting apply the records in order, so registered controllers override removed ones, and
+	// the ones outside of the registry override the removed ones they were demoted from.
+	for (const TPair<uint64, FStateControllerSnapshotRecord>& Pair : RemovedRecords)
+	{
+		WriteSnapshotRecord(Pair.Value);
+	}
+
+	if (OnSavingControllers.IsBound())
+	{
+		TArray<FStateControllerSnapshotRecord> ExternalRecords;
+		OnSavingControllers.Broadcast(bOnlyDirty, ExternalRecords);
+
+		for (const FStateControllerSnapshotRecord& Record : ExternalRecords)
+		{
+			WriteSnapshotRecord(Record);
+		}
+	}
+
+	if (bOnlyDirty && IsValid(Registry))
+	{
+		for (const FStateControllerHandle& Handle : DirtyHandles)
+		{
+			WriteController(Handle);
+		}
+	}
+	else if (IsValid(Registry))
+	{
+		for (uint8 TypeIndex = 0; TypeIndex < static_cast<uint8>(EStateControllerType::Num); ++TypeIndex)
+		{
+			const EStateControllerType Type = static_cast<EStateControllerType>(TypeIndex);
+
+			for (const FStateControllerHandle& Handle : Registry->GetHandles(Type))
+			{
+				WriteController(Handle);
+			}
+		}
+	}
+
+	const int64 EndOffset = Ar.Tell();
+	Ar.Seek(NumControllersOffset);
+	Ar << NumControllers;
+	Ar.Seek(EndOffset);
+}
+
+void UStateControllerSnapshotSubsystem::SaveKeyrings(FArchive& Ar) const
+{
+	using namespace StateControllerSnapshot;
+
+	const UWorld* World = GetWorld();
+	TArray<FKeyringRecord> Records;
+	TArray<TSubclassOf<ULockKeyType>> AcquiredKeys;
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (!IsValid(*It) || It->GetWorld() != World || It->IsTemplate())
+		{
+			continue;
+		}
+
+		IKeyringInterface::Execute_GetAcquiredLockKeys(*It, AcquiredKeys);
+
+		FKeyringRecord& Record = Records.AddDefaulted_GetRef();
+		Record.Id = GetStableId(*It);
+		Record.LockKeys.Reserve(AcquiredKeys.Num());
+
+		for (const TSubclassOf<ULockKeyType>& LockKey : AcquiredKeys)
+		{
+			Record.LockKeys.Emplace(LockKey.Get());
+		}
+	}
+
+	WriteKeyringRecords(Ar, Records);
+}
+
+void UStateControllerSnapshotSubsystem::RestoreControllers(FArchive& Ar, const bool bBroadcastEvents) const
+{
+	using namespace StateControllerSnapshot;
+
+	TMap<uint64, UActorComponent*> ControllersById;
+
+	for (uint8 TypeIndex = 0; IsValid(Registry) && TypeIndex < static_cast<uint8>(EStateControllerType::Num);
+	     ++TypeIndex)
+	{
+		const EStateControllerType Type = static_cast<EStateControllerType>(TypeIndex);
+		ControllersById.Reserve(ControllersById.Num() + Registry->GetNumControllers(Type));
+
+		for (const FStateControllerHandle& Handle : Registry->GetHandles(Type))
+		{
+			if (UActorComponent* Controller = Registry->ResolveController(Handle))
+			{
+				ControllersById.Add(GetStableId(Controller), Controller);
+			}
+		}
+	}
+
+	int32 NumControllers = 0;
+	Ar << NumControllers;
+
+	TArray<FStateControllerSnapshotRecord> UnmatchedRecords;
+
+	for (int32 Index = 0; Index < NumControllers && !Ar.IsError(); ++Index)
+	{
+		FControllerRecord Record;
+		SerializeRecord(Ar, Record);
+
+		if (Ar.IsError())
+		{
+			break;
+		}
+
+		UActorComponent* Controller = ControllersById.FindRef(Record.Id);
+
+		if (!Controller)
+		{
+			if (OnRestoringControllers.IsBound())
+			{
+				UnmatchedRecords.Add(Record.ToSnapshotRecord());
+			}
+
+			continue;
+		}
+
+		switch (Record.GetType())
+		{
+		case EStateControllerType::Door:
+			ApplyRecord<UDoorStateControllerComponent>(Record, Controller, bBroadcastEvents);
+			break;
+
+		case EStateControllerType::Chest:
+			ApplyRecord<UChestStateControllerComponent>(Record, Controller, bBroadcastEvents);
+			break;
+
+		case EStateControllerType::Lock:
+			ApplyRecord<ULockStateControllerComponent>(Record, Controller, bBroadcastEvents);
+			break;
+
+		case EStateControllerType::Button:
+			ApplyRecord<UButtonStateControllerComponent>(Record, Controller, bBroadcastEvents);
+			break;
+
+		case EStateControllerType::GameplayObject:
+			ApplyRecord<UGameplayObjectStateControllerComponent>(Record, Controller, bBroadcastEvents);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	OnRestoringControllers.Broadcast(UnmatchedRecords);
+}
+
+void UStateControllerSnapshotSubsystem::RestoreKeyrings(FArchive& Ar, const bool bBroadcastEvents) const
+{
+	using namespace StateControllerSnapshot;
+
+	TArray<FKeyringRecord> Records;
+	ReadKeyringRecords(Ar, Records);
+
+	if (Ar.IsError())
+	{
+		return;
+	}
+
+	const UWorld* World = GetWorld();
+	TMap<uint64, UKeyringComponent*> KeyringsById;
+
+	for (TObjectIterator<UKeyringComponent> It; It; ++It)
+	{
+		if (IsValid(*It) && It->GetWorld() == World && !It->IsTemplate())
+		{
+			KeyringsById.Add(GetStableId(*It), *It);
+		}
+	}
+
+	TMap<FSoftClassPath, TSubclassOf<ULockKeyType>> KeyClasses;
+	TArray<TSubclassOf<ULockKeyType>> LockKeys;
+
+	for (const FKeyringRecord& Record : Records)
+	{
+		UKeyringComponent* Keyring = KeyringsById.FindRef(Record.Id);
+
+		if (!Keyring)
+		{
+			continue;
+		}
+
+		LockKeys.Reset(Record.LockKeys.Num());
+
+		for (const FSoftClassPath& KeyPath : Record.LockKeys)
+		{
+			const TSubclassOf<ULockKeyType>* KeyClass = KeyClasses.Find(KeyPath);
+			LockKeys.Add(KeyClass ? *KeyClass : KeyClasses.Add(KeyPath, KeyPath.TryLoadClass<ULockKeyType>()));
+		}
+
+		if (!bBroadcastEvents)
+		{
+			Keyring->RestoreLockKeys(LockKeys);
+			continue;
+		}
+
+		IKeyringInterface::Execute_RemoveAllLockKeys(Keyring);
+
+		for (const TSubclassOf<ULockKeyType>& LockKey : LockKeys)
+		{
+			IKeyringInterface::Execute_AddLockKey(Keyring, LockKey);
+		}
+	}
+}
+
+void UStateControllerSnapshotSubsystem::SaveStoredStates(FArchive& Ar, const bool bOnlyDirty) const
+{
+	UStateControllerPersistenceSubsystem* Persistence = UStateControllerPersistenceSubsystem::Get(this);
+
+	if (!Persistence || (bOnlyDirty && !Persistence->IsDirty()))
+	{
+		bool bHasStoredStates = false;
+		Ar << bHasStoredStates;
+		return;
+	}
+
+	TArray<uint64> Keys;
+	TArray<uint16> PackedStates;
+	Persistence->GetStoredStates(Keys, PackedStates);
+	StateControllerSnapshot::WriteStoredStates(Ar, Keys, PackedStates);
+	Persistence->ClearDirty();
+}
+
+void UStateControllerSnapshotSubsystem::RestoreStoredStates(FArchive& Ar) const
+{
+	TArray<uint64> Keys;
+	TArray<uint16> PackedStates;
+
+	if (!StateControllerSnapshot::ReadStoredStates(Ar, Keys, PackedStates))
+	{
+		return;
+	}
+
+	if (UStateControllerPersistenceSubsystem* Persistence = UStateControllerPersistenceSubsystem::Get(this))
+	{
+		Persistence->RestoreStoredStates(Keys, PackedStates);
+
+		// The restored states are already saved, the same as the restored controllers.
+		Persistence->ClearDirty();
+	}
+}
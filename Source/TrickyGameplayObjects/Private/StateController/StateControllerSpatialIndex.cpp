@@ -0,0 +1,408 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerSpatialIndex.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "StateController/StateControllerRegistry.h"
+
+namespace StateControllerSpatialIndex
+{
+	/** Cell coordinates are clamped to this value, so cell ranges and rings can't overflow int32. */
+	constexpr double MaxCellCoordinate = 1 << 30;
+
+	/** Rings beyond this one are far outside any world, and the cube of the range still fits in int64. */
+	constexpr int32 MaxRingLimit = 1 << 19;
+}
+
+UStateControllerSpatialIndex* UStateControllerSpatialIndex::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerSpatialIndex>() : nullptr;
+}
+
+void UStateControllerSpatialIndex::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CellSize, 1.f);
+	Registry = Collection.InitializeDependency<UStateControllerRegistry>();
+
+	if (!IsValid(Registry))
+	{
+		return;
+	}
+
+	Registry->OnControllerRegistered.AddUObject(this, &UStateControllerSpatialIndex::AddEntry);
+	Registry->OnControllerUnregistered.AddUObject(this, &UStateControllerSpatialIndex::RemoveEntry);
+
+	for (uint8 TypeIndex = 0; TypeIndex < static_cast<uint8>(EStateControllerType::Num); ++TypeIndex)
+	{
+		for (const FStateControllerHandle& Handle : Registry->GetHandles(static_cast<EStateControllerType>(TypeIndex)))
+		{
+			AddEntry(Handle, Registry->ResolveController(Handle));
+		}
+	}
+}
+
+void UStateControllerSpatialIndex::Deinitialize()
+{
+	if (IsValid(Registry))
+	{
+		Registry->OnControllerRegistered.RemoveAll(this);
+		Registry->OnControllerUnregistered.RemoveAll(this);
+	}
+
+	for (const TPair<FStateControllerHandle, FEntry>& Entry : Entries)
+	{
+		if (USceneComponent* RootComponent = Entry.Value.RootComponent.Get())
+		{
+			RootComponent->TransformUpdated.Remove(Entry.Value.TransformUpdatedHandle);
+		}
+	}
+
+	Entries.Empty();
+	Cells.Empty();
+	Registry = nullptr;
+
+	Super::Deinitialize();
+}
+
+template <typename FuncType>
+void UStateControllerSpatialIndex::ForEachCellEntry(const FIntVector& MinCell,
+                                                    const FIntVector& MaxCell,
+                                                    FuncType&& Func) const
+{
+	// The product is computed in doubles, because the size of every axis can exceed 2^31 cells.
+	const double NumCellsInRange = (static_cast<double>(static_cast<int64>(MaxCell.X) - MinCell.X) + 1.0)
+		* (static_cast<double>(static_cast<int64>(MaxCell.Y) - MinCell.Y) + 1.0)
+		* (static_cast<double>(static_cast<int64>(MaxCell.Z) - MinCell.Z) + 1.0);
+
+	// Big ranges are mostly empty, so it's cheaper to check all the occupied cells.
+	if (NumCellsInRange > Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<FCellEntry>>& Cell : Cells)
+		{
+			if (Cell.Key.X < MinCell.X || Cell.Key.Y < MinCell.Y || Cell.Key.Z < MinCell.Z
+				|| Cell.Key.X > MaxCell.X || Cell.Key.Y > MaxCell.Y || Cell.Key.Z > MaxCell.Z)
+			{
+				continue;
+			}
+
+			for (const FCellEntry& CellEntry : Cell.Value)
+			{
+				Func(CellEntry);
+			}
+		}
+
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const TArray<FCellEntry>* CellEntries = Cells.Find(FIntVector(X, Y, Z)))
+				{
+					for (const FCellEntry& CellEntry : *CellEntries)
+					{
+						Func(CellEntry);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UStateControllerSpatialIndex::QueryRadius(const FVector& Center,
+                                               const float Radius,
+                                               const EStateControllerType Type,
+                                               const uint8 StateMask,
+                                               TArray<FStateControllerHandle>& OutHandles) const
+{
+	if (Radius < 0.f)
+	{
+		return;
+	}
+
+	const double RadiusSquared = FMath::Square(static_cast<double>(Radius));
+
+	ForEachCellEntry(GetCell(Center - FVector(Radius)),
+	                 GetCell(Center + FVector(Radius)),
+	                 [&](const FCellEntry& CellEntry)
+	                 {
+		                 if (FVector::DistSquared(CellEntry.Location, Center) <= RadiusSquared
+			                 && MatchesFilter(CellEntry.Handle, Type, StateMask))
+		                 {
+			                 OutHandles.Add(CellEntry.Handle);
+		                 }
+	                 });
+}
+
+void UStateControllerSpatialIndex::QueryBox(const FBox& Box,
+                                            const EStateControllerType Type,
+                                            const uint8 StateMask,
+                                            TArray<FStateControllerHandle>& OutHandles) const
+{
+	if (!Box.IsValid)
+	{
+		return;
+	}
+
+	ForEachCellEntry(GetCell(Box.Min),
+	                 GetCell(Box.Max),
+	                 [&](const FCellEntry& CellEntry)
+	                 {
+		                 if (Box.IsInsideOrOn(CellEntry.Location) && MatchesFilter(CellEntry.Handle, Type, StateMask))
+		                 {
+			                 OutHandles.Add(CellEntry.Handle);
+		                 }
+	                 });
+}
+
+void UStateControllerSpatialIndex::QueryNearest(const FVector& Location,
+                                                const int32 Count,
+                                                const float MaxRadius,
+                                                const EStateControllerType Type,
+                                                const uint8 StateMask,
+                                                TArray<FStateControllerHandle>& OutHandles) const
+{
+	if (Count <= 0 || MaxRadius < 0.f)
+	{
+		return;
+	}
+
+	struct FCandidate
+	{
+		double DistanceSquared = 0.0;
+
+		FStateControllerHandle Handle;
+	};
+
+	// Max-heap by distance, so the farthest candidate is replaced first.
+	auto FartherFirst = [](const FCandidate& A, const FCandidate& B)
+	{
+		return A.DistanceSquared > B.DistanceSquared;
+	};
+
+	TArray<FCandidate, TInlineAllocator<16>> Candidates;
+	const FIntVector CenterCell = GetCell(Location);
+	const double MaxRadiusSquared = FMath::Square(static_cast<double>(MaxRadius));
+	const int32 MaxRing = static_cast<int32>(FMath::Min(FMath::CeilToDouble(MaxRadius / CellSize),
+	                                                    static_cast<double>(StateControllerSpatialIndex::MaxRingLimit)));
+
+	auto AddCandidate = [&](const FCellEntry& CellEntry)
+	{
+		const double DistanceSquared = FVector::DistSquared(CellEntry.Location, Location);
+
+		if (DistanceSquared > MaxRadiusSquared || !MatchesFilter(CellEntry.Handle, Type, StateMask))
+		{
+			return;
+		}
+
+		if (Candidates.Num() < Count)
+		{
+			Candidates.HeapPush({DistanceSquared, CellEntry.Handle}, FartherFirst);
+		}
+		else if (DistanceSquared < Candidates.HeapTop().DistanceSquared)
+		{
+			Candidates.HeapPopDiscard(FartherFirst);
+			Candidates.HeapPush({DistanceSquared, CellEntry.Handle}, FartherFirst);
+		}
+	};
+
+	const int64 RangeSize = 2 * static_cast<int64>(MaxRing) + 1;
+
+	if (RangeSize * RangeSize * RangeSize > Cells.Num())
+	{
+		// The grid is sparse for this radius, a single pass over the occupied cells is cheaper than ring expansion.
+		ForEachCellEntry(CenterCell - FIntVector(MaxRing), CenterCell + FIntVector(MaxRing), AddCandidate);
+	}
+	else
+	{
+		// Visit the cells ring by ring. Any entry outside ring N is at least N * CellSize away from the location.
+		for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+		{
+			for (int32 X = -Ring; X <= Ring; ++X)
+			{
+				for (int32 Y = -Ring; Y <= Ring; ++Y)
+				{
+					for (int32 Z = -Ring; Z <= Ring; ++Z)
+					{
+						if (FMath::Max3(FMath::Abs(X), FMath::Abs(Y), FMath::Abs(Z)) != Ring)
+						{
+							continue;
+						}
+
+						if (const TArray<FCellEntry>* CellEntries = Cells.Find(CenterCell + FIntVector(X, Y, Z)))
+						{
+							for (const FCellEntry& CellEntry : *CellEntries)
+							{
+								AddCandidate(CellEntry);
+							}
+						}
+					}
+				}
+			}
+
+			if (Candidates.Num() == Count
+				&& Candidates.HeapTop().DistanceSquared <= FMath::Square(static_cast<double>(Ring) * CellSize))
+			{
+				break;
+			}
+		}
+	}
+
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B)
+	{
+		return A.DistanceSquared < B.DistanceSquared;
+	});
+
+	for (const FCandidate& Candidate : Candidates)
+	{
+		OutHandles.Add(Candidate.Handle);
+	}
+}
+
+bool UStateControllerSpatialIndex::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntVector UStateControllerSpatialIndex::GetCell(const FVector& Location) const
+{
+	using namespace StateControllerSpatialIndex;
+
+	auto GetCellCoordinate = [this](const double Coordinate)
+	{
+		return static_cast<int32>(FMath::Clamp(FMath::FloorToDouble(Coordinate / CellSize),
+		                                       -MaxCellCoordinate,
+		                                       MaxCellCoordinate));
+	};
+
+	return FIntVector(GetCellCoordinate(Location.X), GetCellCoordinate(Location.Y), GetCellCoordinate(Location.Z));
+}
+
+bool UStateControllerSpatialIndex::MatchesFilter(const FStateControllerHandle& Handle,
+                                                 const EStateControllerType Type,
+                                                 const uint8 StateMask) const
+{
+	if (Handle.Type != Type)
+	{
+		return false;
+	}
+
+	if (StateMask == AnyStateMask)
+	{
+		return true;
+	}
+
+	const int32 CurrentState = Registry->GetRawCurrentState(Handle);
+	return CurrentState != INDEX_NONE && (StateMask & (1 << CurrentState)) != 0;
+}
+
+void UStateControllerSpatialIndex::AddEntry(const FStateControllerHandle& Handle, UActorComponent* Controller)
+{
+	const AActor* Owner = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+	USceneComponent* RootComponent = Owner ? Owner->GetRootComponent() : nullptr;
+
+	if (!IsValid(RootComponent) || Entries.Contains(Handle))
+	{
+		return;
+	}
+
+	const FVector Location = RootComponent->GetComponentLocation();
+	FEntry& Entry = Entries.Add(Handle);
+	Entry.Cell = GetCell(Location);
+	Entry.RootComponent = RootComponent;
+	Cells.FindOrAdd(Entry.Cell).Add({Handle, Location});
+
+	if (RootComponent->Mobility == EComponentMobility::Movable)
+	{
+		Entry.TransformUpdatedHandle = RootComponent->TransformUpdated.AddUObject(
+			this, &UStateControllerSpatialIndex::HandleTransformUpdated, Handle);
+	}
+}
+
+void UStateControllerSpatialIndex::RemoveEntry(const FStateControllerHandle& Handle, UActorComponent* Controller)
+{
+	FEntry Entry;
+
+	if (!Entries.RemoveAndCopyValue(Handle, Entry))
+	{
+		return;
+	}
+
+	if (USceneComponent* RootComponent = Entry.RootComponent.Get())
+	{
+		RootComponent->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+	}
+
+	if (TArray<FCellEntry>* CellEntries = Cells.Find(Entry.Cell))
+	{
+		CellEntries->RemoveAllSwap([&Handle](const FCellEntry& CellEntry) { return CellEntry.Handle == Handle; });
+
+		if (CellEntries->IsEmpty())
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+}
+
+void UStateControllerSpatialIndex::MoveEntry(const FStateControllerHandle& Handle, const FVector& NewLocation)
+{
+	FEntry* Entry = Entries.Find(Handle);
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	const FIntVector NewCell = GetCell(NewLocation);
+	TArray<FCellEntry>* CellEntries = Cells.Find(Entry->Cell);
+
+	if (!CellEntries)
+	{
+		return;
+	}
+
+	const int32 Index = CellEntries->IndexOfByPredicate([&Handle](const FCellEntry& CellEntry)
+	{
+		return CellEntry.Handle == Handle;
+	});
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (NewCell == Entry->Cell)
+	{
+		(*CellEntries)[Index].Location = NewLocation;
+		return;
+	}
+
+	CellEntries->RemoveAtSwap(Index);
+
+	if (CellEntries->IsEmpty())
+	{
+		Cells.Remove(Entry->Cell);
+	}
+
+	Entry->Cell = NewCell;
+	Cells.FindOrAdd(NewCell).Add({Handle, NewLocation});
+}
+
+void UStateControllerSpatialIndex::HandleTransformUpdated(USceneComponent* UpdatedComponent,
+                                                          EUpdateTransformFlags UpdateTransformFlags,
+                                                          ETeleportType Teleport,
+                                                          FStateControllerHandle Handle)
+{
+	if (IsValid(UpdatedComponent))
+	{
+		MoveEntry(Handle, UpdatedComponent->GetComponentLocation());
+	}
+}
@@ -0,0 +1,224 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerTransitionScheduler.h"
+
+#include "Engine/World.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "Lock/LockStateControllerComponent.h"
+#include "StateController/NativeInterfaceDispatch.h"
+
+UStateControllerTransitionScheduler* UStateControllerTransitionScheduler::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerTransitionScheduler>() : nullptr;
+}
+
+void UStateControllerTransitionScheduler::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double CurrentTime = GetCurrentTime();
+
+	while (!Heap.IsEmpty() && Heap.HeapTop().FinishTime <= CurrentTime)
+	{
+		FHeapEntry Entry;
+		Heap.HeapPop(Entry, FHeapEntryPredicate());
+
+		if (IsStaleEntry(Entry))
+		{
+			continue;
+		}
+
+		const EStateControllerType Type = ScheduledTransitions.FindChecked(Entry.Key).Type;
+		ScheduledTransitions.Remove(Entry.Key);
+
+		if (UActorComponent* Controller = Entry.Controller.Get())
+		{
+			FinishTransition(Controller, Type);
+		}
+	}
+}
+
+bool UStateControllerTransitionScheduler::IsTickable() const
+{
+	return !Heap.IsEmpty();
+}
+
+TStatId UStateControllerTransitionScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStateControllerTransitionScheduler, STATGROUP_Tickables);
+}
+
+void UStateControllerTransitionScheduler::Deinitialize()
+{
+	Heap.Empty();
+	ScheduledTransitions.Empty();
+
+	Super::Deinitialize();
+}
+
+void UStateControllerTransitionScheduler::ScheduleTransition(UActorComponent* Controller,
+                                                             const EStateControllerType Type,
+                                                             const float Duration,
+                                                             const float RemainingTime)
+{
+	if (!IsValid(Controller) || Duration <= 0.f)
+	{
+		return;
+	}
+
+	const float Delay = RemainingTime >= 0.f ? FMath::Min(RemainingTime, Duration) : Duration;
+
+	FScheduledTransition& Transition = ScheduledTransitions.FindOrAdd(Controller);
+	Transition.Duration = Duration;
+	Transition.FinishTime = GetCurrentTime() + Delay;
+	Transition.Serial = ++NextSerial;
+	Transition.Type = Type;
+	PushEntry(Controller, Transition);
+}
+
+void UStateControllerTransitionScheduler::ReverseTransition(UActorComponent* Controller)
+{
+	FScheduledTransition* Transition = ScheduledTransitions.Find(Controller);
+
+	if (!Transition)
+	{
+		return;
+	}
+
+	const double CurrentTime = GetCurrentTime();
+	const double RemainingTime = FMath::Max(Transition->FinishTime - CurrentTime, 0.0);
+	const double ElapsedTime = FMath::Max(Transition->Duration - RemainingTime, 0.0);
+	Transition->FinishTime = CurrentTime + ElapsedTime;
+	Transition->Serial = ++NextSerial;
+	PushEntry(Controller, *Transition);
+}
+
+void UStateControllerTransitionScheduler::CancelTransition(const UActorComponent* Controller)
+{
+	ScheduledTransitions.Remove(Controller);
+	CompactHeap();
+}
+
+bool UStateControllerTransitionScheduler::IsTransitionScheduled(const UActorComponent* Controller) const
+{
+	return ScheduledTransitions.Contains(Controller);
+}
+
+float UStateControllerTransitionScheduler::GetRemainingTime(const UActorComponent* Controller) const
+{
+	const FScheduledTransition* Transition = ScheduledTransitions.Find(Controller);
+	return Transition ? FMath::Max(static_cast<float>(Transition->FinishTime - GetCurrentTime()), 0.f) : -1.f;
+}
+
+bool UStateControllerTransitionScheduler::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+double UStateControllerTransitionScheduler::GetCurrentTime() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void UStateControllerTransitionScheduler::PushEntry(UActorComponent* Controller,
+                                                    const FScheduledTransition& Transition)
+{
+	FHeapEntry Entry;
+	Entry.FinishTime = Transition.FinishTime;
+	Entry.Serial = Transition.Serial;
+	Entry.Key = Controller;
+	Entry.Controller = Controller;
+	Heap.HeapPush(MoveTemp(Entry), FHeapEntryPredicate());
+	CompactHeap();
+}
+
+bool UStateControllerTransitionScheduler::IsStaleEntry(const FHeapEntry& Entry) const
+{
+	const FScheduledTransition* Transition = ScheduledTransitions.Find(Entry.Key);
+	return !Transition || Transition->Serial != Entry.Serial;
+}
+
+void UStateControllerTransitionScheduler::CompactHeap()
+{
+	// Every scheduled transition has exactly one live entry in the heap.
+	const int32 NumStaleEntries = Heap.Num() - ScheduledTransitions.Num();
+
+	if (NumStaleEntries <= ScheduledTransitions.Num())
+	{
+		return;
+	}
+
+	Heap.RemoveAllSwap([this](const FHeapEntry& Entry) { return IsStaleEntry(Entry); });
+	Heap.Heapify(FHeapEntryPredicate());
+}
+
+void UStateControllerTransitionScheduler::FinishTransition(UActorComponent* Controller, const EStateControllerType Type)
+{
+	switch (Type)
+	{
+	case EStateControllerType::Door:
+		if (IDoorInterface* Door = FNativeInterfaceDispatch::GetNativeInterface<IDoorInterface>(
+			Controller, GET_FUNCTION_NAME_CHECKED(IDoorInterface, FinishDoorStateTransition)))
+		{
+			Door->FinishDoorStateTransition_Implementation();
+			break;
+		}
+
+		IDoorInterface::Execute_FinishDoorStateTransition(Controller);
+		break;
+
+	case EStateControllerType::Chest:
+		if (IChestInterface* Chest = FNativeInterfaceDispatch::GetNativeInterface<IChestInterface>(
+			Controller, GET_FUNCTION_NAME_CHECKED(IChestInterface, FinishChestStateTransition)))
+		{
+			Chest->FinishChestStateTransition_Implementation();
+			break;
+		}
+
+		IChestInterface::Execute_FinishChestStateTransition(Controller);
+		break;
+
+	case EStateControllerType::Lock:
+		if (ILockInterface* Lock = FNativeInterfaceDispatch::GetNativeInterface<ILockInterface>(
+			Controller, GET_FUNCTION_NAME_CHECKED(ILockInterface, FinishLockStateTransition)))
+		{
+			Lock->FinishLockStateTransition_Implementation();
+			break;
+		}
+
+		ILockInterface::Execute_FinishLockStateTransition(Controller);
+		break;
+
+	case EStateControllerType::Button:
+		if (IButtonInterface* Button = FNativeInterfaceDispatch::GetNativeInterface<IButtonInterface>(
+			Controller, GET_FUNCTION_NAME_CHECKED(IButtonInterface, FinishButtonStateTransition)))
+		{
+			Button->FinishButtonStateTransition_Implementation();
+			break;
+		}
+
+		IButtonInterface::Execute_FinishButtonStateTransition(Controller);
+		break;
+
+	case EStateControllerType::GameplayObject:
+		if (IGameplayObjectInterface* GameplayObject = FNativeInterfaceDispatch::GetNativeInterface<
+			IGameplayObjectInterface>(
+			Controller, GET_FUNCTION_NAME_CHECKED(IGameplayObjectInterface, FinishGameplayObjetStateTransition)))
+		{
+			GameplayObject->FinishGameplayObjetStateTransition_Implementation();
+			break;
+		}
+
+		IGameplayObjectInterface::Execute_FinishGameplayObjetStateTransition(Controller);
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,69 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerPersistenceSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Engine/Level.h"
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "Tests/TrickyGameplayObjectsTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateControllerPersistenceRoundTripTest,
+                                 "TrickyGameplayObjects.StateController.PersistenceRoundTrip",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Finishes a door transition, streams the door out and back in and checks that its states were restored.
+ * Streaming is emulated by unregistering the door while its level is marked as being removed.
+ */
+bool FStateControllerPersistenceRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace TrickyGameplayObjectsTestWorld;
+
+	UWorld* World = CreateGameWorld();
+	UStateControllerPersistenceSubsystem* Persistence = UStateControllerPersistenceSubsystem::Get(World);
+
+	if (!Persistence || !Persistence->IsPersistingStreamedOutStates())
+	{
+		AddInfo(TEXT("Skipped: streamed out states aren't persisted"));
+		DestroyGameWorld(World);
+		return true;
+	}
+
+	static const FName DoorName = TEXT("PersistenceRoundTripDoor");
+	AActor* Actor = World->SpawnActor<AActor>();
+	UDoorStateControllerComponent* Door = NewObject<UDoorStateControllerComponent>(Actor, DoorName);
+	Actor->AddInstanceComponent(Door);
+	Door->RegisterComponent();
+	Door->OpenDoor_Implementation(false);
+	Door->FinishDoorStateTransition_Implementation();
+
+	const EDoorState ExpectedCurrentState = Door->GetCurrentState();
+	const EDoorState ExpectedLastState = Door->GetLastState();
+	const int32 NumStoredControllers = Persistence->GetNumStoredControllers();
+
+	ULevel* Level = Actor->GetLevel();
+	Level->bIsBeingRemoved = true;
+	Door->DestroyComponent();
+	Level->bIsBeingRemoved = false;
+
+	if (TestTrue(TEXT("The streamed out door states are stored"),
+	             Persistence->GetNumStoredControllers() > NumStoredControllers))
+	{
+		// The streamed in door must have the same path to be matched with the stored states.
+		Door->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors);
+		UDoorStateControllerComponent* StreamedInDoor = NewObject<UDoorStateControllerComponent>(Actor, DoorName);
+		Actor->AddInstanceComponent(StreamedInDoor);
+		StreamedInDoor->RegisterComponent();
+		TestTrue(TEXT("The finished transition is restored"),
+		         StreamedInDoor->GetCurrentState() == ExpectedCurrentState
+		         && StreamedInDoor->GetLastState() == ExpectedLastState);
+	}
+
+	Actor->Destroy();
+	DestroyGameWorld(World);
+	return true;
+}
+#endif
@@ -0,0 +1,81 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "StateController/StateControllerPredictionComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "Tests/TrickyGameplayObjectsTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateControllerPredictionRollbackTest,
+                                 "TrickyGameplayObjects.StateController.PredictionRollback",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Predicts opening a door with and without a transition and checks that the rejected predictions are rolled back
+ * to the last replicated states of the door.
+ * The prediction owner acts as a client, and in a standalone world its server RPC runs locally and rejects
+ * the prediction, because the door is already opened.
+ * A door of an authority actor keeps the opened state, as it's the same door the server opened and replicated.
+ * A door of a simulated proxy returns to the closed state, which it received from the server last.
+ */
+bool FStateControllerPredictionRollbackTest::RunTest(const FString& Parameters)
+{
+	using namespace TrickyGameplayObjectsTestWorld;
+
+	UWorld* World = CreateGameWorld();
+
+	AActor* Client = World->SpawnActor<AActor>();
+	Client->SetRole(ROLE_AutonomousProxy);
+	UStateControllerPredictionComponent* Prediction = NewObject<UStateControllerPredictionComponent>(Client);
+	Client->AddInstanceComponent(Prediction);
+	Prediction->RegisterComponent();
+
+	int32 NumRejected = 0;
+	Prediction->OnPredictionResolved.AddLambda([&NumRejected](uint16, const bool bAccepted, float)
+	{
+		NumRejected += !bAccepted;
+	});
+
+	int32 NumPredictions = 0;
+
+	for (const ENetRole DoorRole : {ROLE_Authority, ROLE_SimulatedProxy})
+	{
+		for (const bool bTransitImmediately : {false, true})
+		{
+			AActor* Actor = World->SpawnActor<AActor>();
+			Actor->SetRole(DoorRole);
+			UDoorStateControllerComponent* Door = NewObject<UDoorStateControllerComponent>(Actor);
+			Door->SetTransitionDuration(0.f);
+			Actor->AddInstanceComponent(Door);
+			Door->RegisterComponent();
+
+			TestTrue(TEXT("The door opening is predicted"), Prediction->PredictOpenDoor(Door, bTransitImmediately));
+
+			if (DoorRole == ROLE_Authority)
+			{
+				TestTrue(TEXT("The authority door keeps the opened state"),
+				         Door->GetTargetState() == EDoorState::Opened);
+			}
+			else
+			{
+				TestTrue(TEXT("The simulated proxy door is rolled back to the closed state"),
+				         Door->GetCurrentState() == EDoorState::Closed);
+			}
+
+			++NumPredictions;
+
+			Actor->Destroy();
+		}
+	}
+
+	TestEqual(TEXT("Rejected predictions"), NumRejected, NumPredictions);
+	TestEqual(TEXT("Pending predictions"), Prediction->GetNumPendingPredictions(), 0);
+
+	Client->Destroy();
+	DestroyGameWorld(World);
+	return true;
+}
+#endif
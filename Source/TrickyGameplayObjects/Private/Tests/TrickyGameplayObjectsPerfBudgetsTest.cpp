@@ -0,0 +1,24 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Benchmark/TrickyGameplayObjectsPerfBudgets.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Misc/AutomationTest.h"
+#include "Tests/TrickyGameplayObjectsTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrickyGameplayObjectsPerfBudgetsTest,
+                                 "TrickyGameplayObjects.PerfBudgets",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FTrickyGameplayObjectsPerfBudgetsTest::RunTest(const FString& Parameters)
+{
+	using namespace TrickyGameplayObjectsTestWorld;
+
+	UWorld* World = CreateGameWorld();
+	const bool bMet = UTrickyGameplayObjectsPerfBudgets::CheckBudgets(World, *GLog);
+	DestroyGameWorld(World);
+
+	return TestTrue(TEXT("Performance budgets are met"), bMet);
+}
+#endif
@@ -0,0 +1,18 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "TrickyGameplayObjectsLog.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarTrickyGameplayObjectsVerboseLog(
+	TEXT("TrickyGameplayObjects.VerboseLog"),
+	false,
+	TEXT("If true, state changes, lock key operations and pickup activations are logged."));
+
+bool FTrickyGameplayObjectsLog::IsVerboseLogEnabled()
+{
+	return CVarTrickyGameplayObjectsVerboseLog.GetValueOnAnyThread();
+}
+#endif
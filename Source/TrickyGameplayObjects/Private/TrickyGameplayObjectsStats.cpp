@@ -0,0 +1,38 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "TrickyGameplayObjectsStats.h"
+
+DEFINE_STAT(STAT_DoorTransitions);
+DEFINE_STAT(STAT_ChestTransitions);
+DEFINE_STAT(STAT_LockTransitions);
+DEFINE_STAT(STAT_ButtonTransitions);
+DEFINE_STAT(STAT_GameplayObjectTransitions);
+DEFINE_STAT(STAT_DelegateBroadcasts);
+DEFINE_STAT(STAT_ListenerInvocations);
+DEFINE_STAT(STAT_PickupActivations);
+DEFINE_STAT(STAT_FailedLockAttempts);
+DEFINE_STAT(STAT_KeyringLookups);
+DEFINE_STAT(STAT_ChangeCurrentState);
+DEFINE_STAT(STAT_ActivatePickup);
+
+CSV_DEFINE_CATEGORY_MODULE(TRICKYGAMEPLAYOBJECTS_API, TrickyGameplayObjects, true);
+
+bool FTrickyGameplayObjectsStats::IsCollecting()
+{
+#if STATS
+	if (FThreadStats::IsCollectingData())
+	{
+		return true;
+	}
+#endif
+
+#if CSV_PROFILER
+	if (FCsvProfiler::Get()->IsCapturing())
+	{
+		return true;
+	}
+#endif
+
+	return false;
+}
@@ -0,0 +1,197 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "TrickyGameplayObjectsTrace.h"
+
+#if TRICKY_GAMEPLAY_OBJECTS_TRACE_ENABLED
+#include "Trace/Trace.inl"
+#include "UObject/ObjectKey.h"
+#include "StateController/StateControllerHistory.h"
+
+UE_TRACE_CHANNEL_DEFINE(TrickyGameplayObjectsChannel)
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, ObjectName, NoSync|Important)
+	UE_TRACE_EVENT_FIELD(uint32, Id)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Name)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, StateName, NoSync|Important)
+	UE_TRACE_EVENT_FIELD(uint8, ControllerType)
+	UE_TRACE_EVENT_FIELD(uint8, State)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Name)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, StateChanged)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint32, ControllerId)
+	UE_TRACE_EVENT_FIELD(uint32, InstigatorId)
+	UE_TRACE_EVENT_FIELD(uint8, ControllerType)
+	UE_TRACE_EVENT_FIELD(bool, bReversed)
+	UE_TRACE_EVENT_FIELD(uint8, LastState)
+	UE_TRACE_EVENT_FIELD(uint8, CurrentState)
+	UE_TRACE_EVENT_FIELD(uint8, TargetState)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, LockAttempt)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, LockId)
+	UE_TRACE_EVENT_FIELD(uint32, InstigatorId)
+	UE_TRACE_EVENT_FIELD(bool, bSucceeded)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, LockKeyUsed)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, KeyringId)
+	UE_TRACE_EVENT_FIELD(uint32, LockKeyId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TrickyGameplayObjects, PickupActivated)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint32, PickupId)
+	UE_TRACE_EVENT_FIELD(uint32, ActivatorId)
+	UE_TRACE_EVENT_FIELD(bool, bSucceeded)
+UE_TRACE_EVENT_END()
+
+namespace TrickyGameplayObjectsTrace
+{
+	/** Objects which names were already emitted. Unique ids are reused, so the object key is checked as well. */
+	TMap<uint32, FObjectKey> TracedObjects;
+
+	bool TracedStateNames[static_cast<uint8>(EStateControllerType::Num)] = {};
+
+	/**
+	 * Returns the id used by all the events and emits the name of the object the first time it's seen.
+	 */
+	uint32 TraceObject(const UObject* Object)
+	{
+		if (!Object)
+		{
+			return 0;
+		}
+
+		const uint32 Id = Object->GetUniqueID();
+		const FObjectKey ObjectKey(Object);
+		FObjectKey* TracedKey = TracedObjects.Find(Id);
+
+		if (TracedKey && *TracedKey == ObjectKey)
+		{
+			return Id;
+		}
+
+		TracedObjects.Add(Id, ObjectKey);
+
+		const FString Name = Object->GetPathName();
+		UE_TRACE_LOG(TrickyGameplayObjects, ObjectName, TrickyGameplayObjectsChannel)
+			<< ObjectName.Id(Id)
+			<< ObjectName.Name(*Name, Name.Len());
+		return Id;
+	}
+
+	void TraceStateNames(const EStateControllerType ControllerType, const UEnum* StateEnum)
+	{
+		bool& bTraced = TracedStateNames[static_cast<uint8>(ControllerType)];
+
+		if (bTraced || !StateEnum)
+		{
+			return;
+		}
+
+		bTraced = true;
+
+		// The last entry is the generated _MAX value.
+		for (int32 Index = 0; Index < StateEnum->NumEnums() - 1; ++Index)
+		{
+			const FString Name = StateEnum->GetNameStringByIndex(Index);
+			UE_TRACE_LOG(TrickyGameplayObjects, StateName, TrickyGameplayObjectsChannel)
+				<< StateName.ControllerType(static_cast<uint8>(ControllerType))
+				<< StateName.State(static_cast<uint8>(StateEnum->GetValueByIndex(Index)))
+				<< StateName.Name(*Name, Name.Len());
+		}
+	}
+}
+
+bool FTrickyGameplayObjectsTrace::IsEnabled()
+{
+	return UE_TRACE_CHANNELEXPR_IS_ENABLED(TrickyGameplayObjectsChannel);
+}
+
+void FTrickyGameplayObjectsTrace::OutputStateChanged(const UObject* Controller,
+                                                     const EStateControllerType ControllerType,
+                                                     const UEnum* StateEnum,
+                                                     const bool bReversed,
+                                                     const uint8 LastState,
+                                                     const uint8 CurrentState,
+                                                     const uint8 TargetState,
+                                                     const uint64 StartCycle)
+{
+	using namespace TrickyGameplayObjectsTrace;
+
+	const uint64 EndCycle = FPlatformTime::Cycles64();
+	TraceStateNames(ControllerType, StateEnum);
+	const uint32 ControllerId = TraceObject(Controller);
+	uint32 InstigatorId = 0;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	InstigatorId = TraceObject(FStateControllerHistoryInstigatorScope::GetCurrentInstigator().ResolveObjectPtr());
+#endif
+
+	UE_TRACE_LOG(TrickyGameplayObjects, StateChanged, TrickyGameplayObjectsChannel)
+		<< StateChanged.StartCycle(StartCycle)
+		<< StateChanged.EndCycle(EndCycle)
+		<< StateChanged.ControllerId(ControllerId)
+		<< StateChanged.InstigatorId(InstigatorId)
+		<< StateChanged.ControllerType(static_cast<uint8>(ControllerType))
+		<< StateChanged.bReversed(bReversed)
+		<< StateChanged.LastState(LastState)
+		<< StateChanged.CurrentState(CurrentState)
+		<< StateChanged.TargetState(TargetState);
+}
+
+void FTrickyGameplayObjectsTrace::OutputLockAttempt(const UObject* Lock, const UObject* Instigator, const bool bSucceeded)
+{
+	using namespace TrickyGameplayObjectsTrace;
+
+	const uint32 LockId = TraceObject(Lock);
+	const uint32 InstigatorId = TraceObject(Instigator);
+
+	UE_TRACE_LOG(TrickyGameplayObjects, LockAttempt, TrickyGameplayObjectsChannel)
+		<< LockAttempt.Cycle(FPlatformTime::Cycles64())
+		<< LockAttempt.LockId(LockId)
+		<< LockAttempt.InstigatorId(InstigatorId)
+		<< LockAttempt.bSucceeded(bSucceeded);
+}
+
+void FTrickyGameplayObjectsTrace::OutputLockKeyUsed(const UObject* Keyring, const UClass* LockKey)
+{
+	using namespace TrickyGameplayObjectsTrace;
+
+	const uint32 KeyringId = TraceObject(Keyring);
+	const uint32 LockKeyId = TraceObject(LockKey);
+
+	UE_TRACE_LOG(TrickyGameplayObjects, LockKeyUsed, TrickyGameplayObjectsChannel)
+		<< LockKeyUsed.Cycle(FPlatformTime::Cycles64())
+		<< LockKeyUsed.KeyringId(KeyringId)
+		<< LockKeyUsed.LockKeyId(LockKeyId);
+}
+
+void FTrickyGameplayObjectsTrace::OutputPickupActivated(const UObject* Pickup,
+                                                        const UObject* Activator,
+                                                        const bool bSucceeded,
+                                                        const uint64 StartCycle)
+{
+	using namespace TrickyGameplayObjectsTrace;
+
+	const uint64 EndCycle = FPlatformTime::Cycles64();
+	const uint32 PickupId = TraceObject(Pickup);
+	const uint32 ActivatorId = TraceObject(Activator);
+
+	UE_TRACE_LOG(TrickyGameplayObjects, PickupActivated, TrickyGameplayObjectsChannel)
+		<< PickupActivated.StartCycle(StartCycle)
+		<< PickupActivated.EndCycle(EndCycle)
+		<< PickupActivated.PickupId(PickupId)
+		<< PickupActivated.ActivatorId(ActivatorId)
+		<< PickupActivated.bSucceeded(bSucceeded);
+}
+#endif
@@ -0,0 +1,101 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+class UWorld;
+
+struct FTrickyGameplayObjectsBenchmarkResult
+{
+	FString Name;
+
+	int32 NumObjects = 0;
+
+	int32 NumOperations = 0;
+
+	double TotalSeconds = 0.0;
+
+	/** Malloc and Realloc calls made by the game thread during the measurement. */
+	uint64 NumAllocations = 0;
+
+	double GetNanosecondsPerOperation() const
+	{
+		return NumOperations > 0 ? TotalSeconds * 1000000000.0 / NumOperations : 0.0;
+	}
+
+	double GetOperationsPerSecond() const
+	{
+		return TotalSeconds > 0.0 ? NumOperations / TotalSeconds : 0.0;
+	}
+
+	double GetAllocationsPerOperation() const
+	{
+		return NumOperations > 0 ? static_cast<double>(NumAllocations) / NumOperations : 0.0;
+	}
+};
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnTrickyGameplayObjectsBenchmarkRunSignature,
+                                       UWorld*,
+                                       int32,
+                                       TArray<FTrickyGameplayObjectsBenchmarkResult>&);
+
+/**
+ * Spawns actors with every state controller type, keyrings and automatic pickups in the world and measures
+ * the throughput of transitions, reversals, keyring lookups, lock attempts, overlap-driven pickup activation and
+ * spawning and destroying the actors. All the spawned actors are destroyed at the end.
+ * Door state changes of the shared state machine core are also compared with the legacy per-component one,
+ * door state changes are measured with 0, 1 and 8 native or dynamic listeners, and door and keyring calls through
+ * the Execute_ thunks are compared with FNativeInterfaceDispatch.
+ * Spatial index queries are measured with 1k, 10k and 100k chests and snapshots with 50k doors regardless of
+ * the number of objects.
+ * The TrickyGameplayObjectsMass module appends demotions, requests, processing and promotions of 100k door entities.
+ */
+struct TRICKYGAMEPLAYOBJECTS_API FTrickyGameplayObjectsBenchmark
+{
+	/**
+	 * @param NumObjects Number of actors spawned for every controller type, keyrings and pickups.
+	 * @return False if the world isn't a game world.
+	 */
+	static bool Run(UWorld* World, const int32 NumObjects, TArray<FTrickyGameplayObjectsBenchmarkResult>& OutResults);
+
+	/**
+	 * Triggered at the end of Run, so other modules can append the results of their own workloads.
+	 */
+	static FOnTrickyGameplayObjectsBenchmarkRunSignature& OnRun();
+
+	/**
+	 * Calls the function once and appends its duration and number of allocations to the results.
+	 */
+	template <typename FuncType>
+	static FTrickyGameplayObjectsBenchmarkResult& Measure(TArray<FTrickyGameplayObjectsBenchmarkResult>& Results,
+	                                                      const FString& Name,
+	                                                      const int32 NumObjects,
+	                                                      const int32 NumOperations,
+	                                                      FuncType&& Func)
+	{
+		const uint64 StartNumAllocations = GetNumAllocations();
+		const double StartTime = FPlatformTime::Seconds();
+		Func();
+
+		FTrickyGameplayObjectsBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+		Result.TotalSeconds = FPlatformTime::Seconds() - StartTime;
+		Result.NumAllocations = GetNumAllocations() - StartNumAllocations;
+		Result.Name = Name;
+		Result.NumObjects = NumObjects;
+		Result.NumOperations = NumOperations;
+		return Result;
+	}
+
+	/**
+	 * Number of Malloc and Realloc calls made by the game thread so far. Only counted while Run is in progress,
+	 * which wraps GMalloc with a counting proxy.
+	 */
+	static uint64 GetNumAllocations();
+
+	static FString ToJson(TConstArrayView<FTrickyGameplayObjectsBenchmarkResult> Results);
+
+	static FString ToCsv(TConstArrayView<FTrickyGameplayObjectsBenchmarkResult> Results);
+};
+#endif
@@ -0,0 +1,41 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+struct FTrickyGameplayObjectsMemoryReportEntry
+{
+	const UClass* Class = nullptr;
+
+	int32 NumInstances = 0;
+
+	/** Sum of the class sizes of the instances. Actors include the sizes of their components. */
+	SIZE_T InlineBytes = 0;
+
+	/** Sum of the memory allocated by the instances, e.g. delegate invocation lists and container slack. */
+	SIZE_T AllocatedBytes = 0;
+
+	SIZE_T GetTotalBytes() const { return InlineBytes + AllocatedBytes; }
+
+	double GetBytesPerInstance() const
+	{
+		return NumInstances > 0 ? static_cast<double>(GetTotalBytes()) / NumInstances : 0.0;
+	}
+};
+
+/**
+ * Reports the memory used by the live state controllers, keyrings and pickups of a world grouped by class.
+ * The allocated memory is taken from GetResourceSizeEx, so Blueprint subclasses can add their own allocations.
+ */
+struct TRICKYGAMEPLAYOBJECTS_API FTrickyGameplayObjectsMemoryReport
+{
+	/**
+	 * Fills OutEntries with an entry per class sorted by the total bytes in descending order.
+	 */
+	static void Collect(const UWorld* World, TArray<FTrickyGameplayObjectsMemoryReportEntry>& OutEntries);
+
+	static void Print(TConstArrayView<FTrickyGameplayObjectsMemoryReportEntry> Entries, FOutputDevice& Ar);
+};
@@ -0,0 +1,64 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "TrickyGameplayObjectsPerfBudgets.generated.h"
+
+/**
+ * Per-operation budgets checked on a reference workload by TrickyGameplayObjects.CheckPerfBudgets.
+ * Configured in the [/Script/TrickyGameplayObjects.TrickyGameplayObjectsPerfBudgets] section of DefaultGame.ini.
+ * Budgets which are zero or less aren't checked.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTS_API UTrickyGameplayObjectsPerfBudgets : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Runs the benchmark with ReferenceNumObjects in the world and checks the results against the budgets.
+	 * Every exceeded budget is logged as an error. Always fails in Shipping builds.
+	 *
+	 * @return True if every budget is met.
+	 */
+	static bool CheckBudgets(UWorld* World, FOutputDevice& Ar);
+
+	/**
+	 * Number of objects of every type the reference workload spawns.
+	 */
+	UPROPERTY(Config)
+	int32 ReferenceNumObjects = 1000;
+
+	/**
+	 * Maximum nanoseconds per immediate state change of any controller type without listeners.
+	 */
+	UPROPERTY(Config)
+	float MaxNsPerChangeCurrentState = 2000.f;
+
+	/**
+	 * Maximum bytes of a door state controller instance including its allocations.
+	 */
+	UPROPERTY(Config)
+	int32 MaxBytesPerDoorComponent = 2048;
+
+	/**
+	 * Maximum game thread allocations per ActivatePickup call of an automatic pickup which isn't destroyed after
+	 * activation.
+	 */
+	UPROPERTY(Config)
+	float MaxAllocationsPerPickupActivation = 32.f;
+
+	/**
+	 * Maximum nanoseconds per operation of the benchmark results with the given names, e.g. "Lock Attempts".
+	 */
+	UPROPERTY(Config)
+	TMap<FString, float> MaxNsPerOperation;
+
+	/**
+	 * Maximum game thread allocations per operation of the benchmark results with the given names.
+	 */
+	UPROPERTY(Config)
+	TMap<FString, float> MaxAllocationsPerOperation;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "StateController/StateController.h"
 #include "ButtonInterface.generated.h"
 
 class UButtonStateControllerComponent;
@@ -22,6 +23,16 @@ enum class EButtonState : uint8
 	Transition
 };
 
+template <>
+struct TStateControllerTraits<EButtonState>
+{
+	static constexpr EButtonState TransitionState = EButtonState::Transition;
+
+	static constexpr EStateControllerType ControllerType = EStateControllerType::Button;
+};
+
+using FButtonStateController = TStateController<EButtonState>;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnButtonStateChangedDynamicSignature,
                                                UButtonStateControllerComponent*, Component,
                                                EButtonState, NewState,
@@ -39,6 +50,23 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnButtonStateTransitionReversedDyn
                                              UButtonStateControllerComponent*, Component,
                                              EButtonState, NewTargetState);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnButtonStateChangedSignature,
+                                       UButtonStateControllerComponent*,
+                                       EButtonState,
+                                       bool);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnButtonStateTransitionStartedSignature,
+                                     UButtonStateControllerComponent*,
+                                     EButtonState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnButtonStateTransitionFinishedSignature,
+                                     UButtonStateControllerComponent*,
+                                     EButtonState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnButtonStateTransitionReversedSignature,
+                                     UButtonStateControllerComponent*,
+                                     EButtonState);
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI, Blueprintable)
 class UButtonInterface : public UInterface
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "ButtonInterface.h"
+#include "StateController/StateControllerHistory.h"
+#include "StateController/StateControllerReplicatedStates.h"
 #include "ButtonStateControllerComponent.generated.h"
 
 
@@ -17,12 +19,20 @@ class TRICKYGAMEPLAYOBJECTS_API UButtonStateControllerComponent : public UActorC
 {
 	GENERATED_BODY()
 
+	friend struct TStateControllerComponentCore<UButtonStateControllerComponent>;
+
 public:
 	UButtonStateControllerComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
+	virtual void UninitializeComponent() override;
+
 public:
 	/**
 	 * Triggered when CurrentState was changed.
@@ -48,12 +58,67 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnButtonStateTransitionReversedDynamicSignature OnButtonStateTransitionReversed;
 
+	/**
+	 * Native counterpart of OnButtonStateChanged, broadcast before the dynamic delegate.
+	 */
+	FOnButtonStateChangedSignature OnButtonStateChangedNative;
+
+	/**
+	 * Native counterpart of OnButtonStateTransitionStarted, broadcast before the dynamic delegate.
+	 */
+	FOnButtonStateTransitionStartedSignature OnButtonStateTransitionStartedNative;
+
+	/**
+	 * Native counterpart of OnButtonStateTransitionFinished, broadcast before the dynamic delegate.
+	 */
+	FOnButtonStateTransitionFinishedSignature OnButtonStateTransitionFinishedNative;
+
+	/**
+	 * Native counterpart of OnButtonStateTransitionReversed, broadcast before the dynamic delegate.
+	 */
+	FOnButtonStateTransitionReversedSignature OnButtonStateTransitionReversedNative;
+
 	UFUNCTION(BlueprintGetter, Category=ButtonState)
 	FORCEINLINE EButtonState GetInitialState() const { return InitialState; }
 
 	UFUNCTION(BlueprintSetter, Category=ButtonState)
 	void SetInitialState(const EButtonState NewState);
 
+	UFUNCTION(BlueprintGetter, Category=ButtonState)
+	FORCEINLINE float GetTransitionDuration() const { return TransitionDuration; }
+
+	UFUNCTION(BlueprintSetter, Category=ButtonState)
+	void SetTransitionDuration(const float NewDuration);
+
+	/**
+	 * Sets InitialState without changing the current states and without triggering any events.
+	 * Used together with RestoreStates to restore states which were saved or mirrored elsewhere.
+	 */
+	void RestoreInitialState(const EButtonState NewState);
+
+	/**
+	 * Sets CurrentState, TargetState and LastState directly without validation.
+	 * Used to restore states which were saved or mirrored elsewhere.
+	 *
+	 * @param TransitionTimeLeft If non-negative and CurrentState is Transition, the transition finishes after this time.
+	 * @param bBroadcastStateChanged If true, OnButtonStateChanged is broadcast, otherwise no events are triggered.
+	 */
+	void RestoreStates(const EButtonState NewCurrentState,
+	                   const EButtonState NewTargetState,
+	                   const EButtonState NewLastState,
+	                   const float TransitionTimeLeft = -1.f,
+	                   const bool bBroadcastStateChanged = false);
+
+	/**
+	 * Applies the last replicated states again, discarding the changes made locally since they arrived.
+	 * Used on clients to roll back rejected predictions. Does nothing on the server.
+	 */
+	void RestoreReplicatedStates();
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	const TStateControllerHistory<EButtonState>& GetStateHistory() const { return StateHistory; }
+#endif
+
 	UFUNCTION(BlueprintGetter, Category=ButtonState)
 	FORCEINLINE EButtonState GetCurrentState() const { return CurrentState; }
 
@@ -89,6 +154,17 @@ private:
 		meta=(InvalidEnumValues="EButtonState::Transition"))
 	EButtonState InitialState = EButtonState::Released;
 
+	/**
+	 * If greater than zero, the button finishes transitions automatically after this time.
+	 * Otherwise FinishButtonStateTransition must be called manually.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetTransitionDuration,
+		BlueprintSetter=SetTransitionDuration,
+		Category=ButtonState,
+		meta=(ClampMin=0, Units="Seconds"))
+	float TransitionDuration = 0.f;
+
 	/**
 	 * Tracks the current operational state of the button.
 	 */
@@ -107,6 +183,30 @@ private:
 	UPROPERTY(VisibleInstanceOnly, BlueprintGetter=GetLastState, Category=ButtonState)
 	EButtonState LastState = EButtonState::Released;
 
+	/**
+	 * Handle of the controller in UStateControllerRegistry.
+	 */
+	FStateControllerHandle RegistryHandle;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	/**
+	 * The last state changes, printed by the TrickyGameplayObjects.DumpStateHistory console command.
+	 */
+	TStateControllerHistory<EButtonState> StateHistory;
+#endif
+
+	/**
+	 * States replicated to clients. Marked dirty only when the states change.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedStates)
+	FStateControllerReplicatedStates ReplicatedStates;
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedStates();
+
 	/**
 	 * Changes the current state of the button to the specified new state.
 	 * Handles the logic for both immediate and transitional state changes.
@@ -122,7 +222,5 @@ private:
 	void PrintWarning(const FString& Message) const;
 
 	void PrintLog(const FString& Message) const;
-
-	static void GetStateName(FString& StateName, const EButtonState State);
 #endif
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "StateController/StateController.h"
 #include "ChestInterface.generated.h"
 
 class UChestStateControllerComponent;
@@ -23,6 +24,16 @@ enum class EChestState: uint8
 	Transition
 };
 
+template <>
+struct TStateControllerTraits<EChestState>
+{
+	static constexpr EChestState TransitionState = EChestState::Transition;
+
+	static constexpr EStateControllerType ControllerType = EStateControllerType::Chest;
+};
+
+using FChestStateController = TStateController<EChestState>;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnChestStateChangedDynamicSignature,
                                                UChestStateControllerComponent*, Component,
                                                EChestState, NewState,
@@ -40,6 +51,23 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnChestStateTransitionReversedDyna
                                              UChestStateControllerComponent*, Component,
                                              EChestState, NewTargetState);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnChestStateChangedSignature,
+                                       UChestStateControllerComponent*,
+                                       EChestState,
+                                       bool);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChestStateTransitionStartedSignature,
+                                     UChestStateControllerComponent*,
+                                     EChestState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChestStateTransitionFinishedSignature,
+                                     UChestStateControllerComponent*,
+                                     EChestState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChestStateTransitionReversedSignature,
+                                     UChestStateControllerComponent*,
+                                     EChestState);
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI, Blueprintable)
 class UChestInterface : public UInterface
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "ChestInterface.h"
+#include "StateController/StateControllerHistory.h"
+#include "StateController/StateControllerReplicatedStates.h"
 #include "ChestStateControllerComponent.generated.h"
 
 
@@ -13,12 +15,20 @@ class TRICKYGAMEPLAYOBJECTS_API UChestStateControllerComponent : public UActorCo
 {
 	GENERATED_BODY()
 
+	friend struct TStateControllerComponentCore<UChestStateControllerComponent>;
+
 public:
 	UChestStateControllerComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
+	virtual void UninitializeComponent() override;
+
 public:
 	/**
 	 * Triggered when CurrentState of the chest was changed.
@@ -44,6 +54,26 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnChestStateTransitionReversedDynamicSignature OnChestTransitionReversed;
 
+	/**
+	 * Native counterpart of OnChestStateChanged, broadcast before the dynamic delegate.
+	 */
+	FOnChestStateChangedSignature OnChestStateChangedNative;
+
+	/**
+	 * Native counterpart of OnChestStateTransitionStarted, broadcast before the dynamic delegate.
+	 */
+	FOnChestStateTransitionStartedSignature OnChestStateTransitionStartedNative;
+
+	/**
+	 * Native counterpart of OnChestStateTransitionFinished, broadcast before the dynamic delegate.
+	 */
+	FOnChestStateTransitionFinishedSignature OnChestStateTransitionFinishedNative;
+
+	/**
+	 * Native counterpart of OnChestTransitionReversed, broadcast before the dynamic delegate.
+	 */
+	FOnChestStateTransitionReversedSignature OnChestTransitionReversedNative;
+
 	UFUNCTION(BlueprintGetter, Category=ChestState)
 	FORCEINLINE EChestState GetCurrentState() const { return CurrentState; }
 
@@ -59,6 +89,35 @@ public:
 	UFUNCTION(BlueprintSetter, Category=ChestState)
 	void SetInitialState(const EChestState NewState);
 
+	UFUNCTION(BlueprintGetter, Category=ChestState)
+	FORCEINLINE float GetTransitionDuration() const { return TransitionDuration; }
+
+	UFUNCTION(BlueprintSetter, Category=ChestState)
+	void SetTransitionDuration(const float NewDuration);
+
+	/**
+	 * Sets InitialState without changing the current states and without triggering any events.
+	 * Used together with RestoreStates to restore states which were saved or mirrored elsewhere.
+	 */
+	void RestoreInitialState(const EChestState NewState);
+
+	/**
+	 * Sets CurrentState, TargetState and LastState directly without validation.
+	 * Used to restore states which were saved or mirrored elsewhere.
+	 *
+	 * @param TransitionTimeLeft If non-negative and CurrentState is Transition, the transition finishes after this time.
+	 * @param bBroadcastStateChanged If true, OnChestStateChanged is broadcast, otherwise no events are triggered.
+	 */
+	void RestoreStates(const EChestState NewCurrentState,
+	                   const EChestState NewTargetState,
+	                   const EChestState NewLastState,
+	                   const float TransitionTimeLeft = -1.f,
+	                   const bool bBroadcastStateChanged = false);
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	const TStateControllerHistory<EChestState>& GetStateHistory() const { return StateHistory; }
+#endif
+
 	virtual bool OpenChest_Implementation(const bool bTransitImmediately) override;
 
 	virtual bool CloseChest_Implementation(const bool bTransitImmediately) override;
@@ -89,6 +148,17 @@ private:
 		meta=(InvalidEnumValues="EChestState::Transition"))
 	EChestState InitialState = EChestState::Closed;
 
+	/**
+	 * If greater than zero, the chest finishes transitions automatically after this time.
+	 * Otherwise FinishChestStateTransition must be called manually.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetTransitionDuration,
+		BlueprintSetter=SetTransitionDuration,
+		Category=ChestState,
+		meta=(ClampMin=0, Units="Seconds"))
+	float TransitionDuration = 0.f;
+
 	/**
 	 * Tracks the current operational state of the chest.
 	 */
@@ -107,6 +177,30 @@ private:
 	UPROPERTY(VisibleInstanceOnly, BlueprintGetter=GetLastState, Category=ChestState)
 	EChestState LastState = EChestState::Closed;
 
+	/**
+	 * Handle of the controller in UStateControllerRegistry.
+	 */
+	FStateControllerHandle RegistryHandle;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	/**
+	 * The last state changes, printed by the TrickyGameplayObjects.DumpStateHistory console command.
+	 */
+	TStateControllerHistory<EChestState> StateHistory;
+#endif
+
+	/**
+	 * States replicated to clients. Marked dirty only when the states change.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedStates)
+	FStateControllerReplicatedStates ReplicatedStates;
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedStates();
+
 	/**
 	 * Changes the current state of the chest to the specified new state.
 	 * Handles the logic for both immediate and transitional state changes.
@@ -122,7 +216,5 @@ private:
 	void PrintWarning(const FString& Message) const;
 
 	void PrintLog(const FString& Message) const;
-
-	static void GetStateName(FString& StateName, const EChestState State);
 #endif
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "StateController/StateController.h"
 #include "DoorInterface.generated.h"
 
 class UDoorStateControllerComponent;
@@ -23,6 +24,16 @@ enum class EDoorState: uint8
 	Transition
 };
 
+template <>
+struct TStateControllerTraits<EDoorState>
+{
+	static constexpr EDoorState TransitionState = EDoorState::Transition;
+
+	static constexpr EStateControllerType ControllerType = EStateControllerType::Door;
+};
+
+using FDoorStateController = TStateController<EDoorState>;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnDoorStateChangedDynamicSignature,
                                                UDoorStateControllerComponent*, Component,
                                                EDoorState, NewState,
@@ -40,6 +51,23 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnDoorStateTransitionReversedDynam
                                              UDoorStateControllerComponent*, Component,
                                              EDoorState, NewTargetState);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnDoorStateChangedSignature,
+                                       UDoorStateControllerComponent*,
+                                       EDoorState,
+                                       bool);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDoorStateTransitionStartedSignature,
+                                     UDoorStateControllerComponent*,
+                                     EDoorState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDoorStateTransitionFinishedSignature,
+                                     UDoorStateControllerComponent*,
+                                     EDoorState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDoorStateTransitionReversedSignature,
+                                     UDoorStateControllerComponent*,
+                                     EDoorState);
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI, Blueprintable)
 class UDoorInterface : public UInterface
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "DoorInterface.h"
+#include "StateController/StateControllerHistory.h"
+#include "StateController/StateControllerReplicatedStates.h"
 #include "Components/ActorComponent.h"
 #include "DoorStateControllerComponent.generated.h"
 
@@ -16,12 +18,20 @@ class TRICKYGAMEPLAYOBJECTS_API UDoorStateControllerComponent : public UActorCom
 {
 	GENERATED_BODY()
 
+	friend struct TStateControllerComponentCore<UDoorStateControllerComponent>;
+
 public:
 	UDoorStateControllerComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
+	virtual void UninitializeComponent() override;
+
 public:
 	/**
 	 * Triggered when CurrentState of the door was changed.
@@ -47,6 +57,26 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnDoorStateTransitionReversedDynamicSignature OnDoorTransitionReversed;
 
+	/**
+	 * Native counterpart of OnDoorStateChanged, broadcast before the dynamic delegate.
+	 */
+	FOnDoorStateChangedSignature OnDoorStateChangedNative;
+
+	/**
+	 * Native counterpart of OnDoorStateTransitionStarted, broadcast before the dynamic delegate.
+	 */
+	FOnDoorStateTransitionStartedSignature OnDoorStateTransitionStartedNative;
+
+	/**
+	 * Native counterpart of OnDoorStateTransitionFinished, broadcast before the dynamic delegate.
+	 */
+	FOnDoorStateTransitionFinishedSignature OnDoorStateTransitionFinishedNative;
+
+	/**
+	 * Native counterpart of OnDoorTransitionReversed, broadcast before the dynamic delegate.
+	 */
+	FOnDoorStateTransitionReversedSignature OnDoorTransitionReversedNative;
+
 	UFUNCTION(BlueprintGetter, Category=DoorState)
 	FORCEINLINE EDoorState GetCurrentState() const { return CurrentState; }
 
@@ -62,6 +92,41 @@ public:
 	UFUNCTION(BlueprintSetter, Category=DoorState)
 	void SetInitialState(const EDoorState NewState);
 
+	UFUNCTION(BlueprintGetter, Category=DoorState)
+	FORCEINLINE float GetTransitionDuration() const { return TransitionDuration; }
+
+	UFUNCTION(BlueprintSetter, Category=DoorState)
+	void SetTransitionDuration(const float NewDuration);
+
+	/**
+	 * Sets InitialState without changing the current states and without triggering any events.
+	 * Used together with RestoreStates to restore states which were saved or mirrored elsewhere.
+	 */
+	void RestoreInitialState(const EDoorState NewState);
+
+	/**
+	 * Sets CurrentState, TargetState and LastState directly without validation.
+	 * Used to restore states which were saved or mirrored elsewhere.
+	 *
+	 * @param TransitionTimeLeft If non-negative and CurrentState is Transition, the transition finishes after this time.
+	 * @param bBroadcastStateChanged If true, OnDoorStateChanged is broadcast, otherwise no events are triggered.
+	 */
+	void RestoreStates(const EDoorState NewCurrentState,
+	                   const EDoorState NewTargetState,
+	                   const EDoorState NewLastState,
+	                   const float TransitionTimeLeft = -1.f,
+	                   const bool bBroadcastStateChanged = false);
+
+	/**
+	 * Applies the last replicated states again, discarding the changes made locally since they arrived.
+	 * Used on clients to roll back rejected predictions. Does nothing on the server.
+	 */
+	void RestoreReplicatedStates();
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	const TStateControllerHistory<EDoorState>& GetStateHistory() const { return StateHistory; }
+#endif
+
 	virtual bool OpenDoor_Implementation(const bool bTransitImmediately) override;
 
 	virtual bool CloseDoor_Implementation(const bool bTransitImmediately) override;
@@ -92,6 +157,17 @@ private:
 		meta=(InvalidEnumValues="EDoorState::Transition"))
 	EDoorState InitialState = EDoorState::Closed;
 
+	/**
+	 * If greater than zero, the door finishes transitions automatically after this time.
+	 * Otherwise FinishDoorStateTransition must be called manually.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetTransitionDuration,
+		BlueprintSetter=SetTransitionDuration,
+		Category=DoorState,
+		meta=(ClampMin=0, Units="Seconds"))
+	float TransitionDuration = 0.f;
+
 	/**
 	 * Tracks the current operational state of the door.
 	 */
@@ -110,6 +186,30 @@ private:
 	UPROPERTY(VisibleInstanceOnly, BlueprintGetter=GetLastState, Category=DoorState)
 	EDoorState LastState = EDoorState::Closed;
 
+	/**
+	 * Handle of the controller in UStateControllerRegistry.
+	 */
+	FStateControllerHandle RegistryHandle;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	/**
+	 * The last state changes, printed by the TrickyGameplayObjects.DumpStateHistory console command.
+	 */
+	TStateControllerHistory<EDoorState> StateHistory;
+#endif
+
+	/**
+	 * States replicated to clients. Marked dirty only when the states change.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedStates)
+	FStateControllerReplicatedStates ReplicatedStates;
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedStates();
+
 	/**
 	 * Changes the current state of the door to the specified new state.
 	 * Handles the logic for both immediate and transitional state changes.
@@ -125,7 +225,5 @@ private:
 	void PrintWarning(const FString& Message) const;
 
 	void PrintLog(const FString& Message) const;
-
-	static void GetStateName(FString& StateName, const EDoorState State);
 #endif
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "StateController/StateController.h"
 #include "GameplayObjectInterface.generated.h"
 
 class UGameplayObjectStateControllerComponent;
@@ -22,6 +23,16 @@ enum class EGameplayObjectState : uint8
 	Transition
 };
 
+template <>
+struct TStateControllerTraits<EGameplayObjectState>
+{
+	static constexpr EGameplayObjectState TransitionState = EGameplayObjectState::Transition;
+
+	static constexpr EStateControllerType ControllerType = EStateControllerType::GameplayObject;
+};
+
+using FGameplayObjectStateController = TStateController<EGameplayObjectState>;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnGameplayObjectStateChangedDynamicSignature,
                                                UGameplayObjectStateControllerComponent*, Component,
                                                EGameplayObjectState, NewState,
@@ -39,6 +50,23 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGameplayObjectStateTransitionRev
                                              UGameplayObjectStateControllerComponent*, Component,
                                              EGameplayObjectState, NewTargetState);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnGameplayObjectStateChangedSignature,
+                                       UGameplayObjectStateControllerComponent*,
+                                       EGameplayObjectState,
+                                       bool);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnGameplayObjectStateTransitionStartedSignature,
+                                     UGameplayObjectStateControllerComponent*,
+                                     EGameplayObjectState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnGameplayObjectStateTransitionFinishedSignature,
+                                     UGameplayObjectStateControllerComponent*,
+                                     EGameplayObjectState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnGameplayObjectStateTransitionReversedSignature,
+                                     UGameplayObjectStateControllerComponent*,
+                                     EGameplayObjectState);
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI, Blueprintable)
 class UGameplayObjectInterface : public UInterface
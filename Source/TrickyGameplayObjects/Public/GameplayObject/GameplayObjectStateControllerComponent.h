@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "GameplayObjectInterface.h"
+#include "StateController/StateControllerHistory.h"
+#include "StateController/StateControllerReplicatedStates.h"
 #include "GameplayObjectStateControllerComponent.generated.h"
 
 
@@ -18,12 +20,20 @@ class TRICKYGAMEPLAYOBJECTS_API UGameplayObjectStateControllerComponent : public
 {
 	GENERATED_BODY()
 
+	friend struct TStateControllerComponentCore<UGameplayObjectStateControllerComponent>;
+
 public:
 	UGameplayObjectStateControllerComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
+	virtual void UninitializeComponent() override;
+
 public:
 	/**
 	 * Triggered when CurrentState was changed.
@@ -49,12 +59,61 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnGameplayObjectStateTransitionReversedDynamicSignature OnGameplayObjectStateTransitionReversed;
 
+	/**
+	 * Native counterpart of OnGameplayObjectStateChanged, broadcast before the dynamic delegate.
+	 */
+	FOnGameplayObjectStateChangedSignature OnGameplayObjectStateChangedNative;
+
+	/**
+	 * Native counterpart of OnGameplayObjectStateTransitionStarted, broadcast before the dynamic delegate.
+	 */
+	FOnGameplayObjectStateTransitionStartedSignature OnGameplayObjectStateTransitionStartedNative;
+
+	/**
+	 * Native counterpart of OnGameplayObjectStateTransitionFinished, broadcast before the dynamic delegate.
+	 */
+	FOnGameplayObjectStateTransitionFinishedSignature OnGameplayObjectStateTransitionFinishedNative;
+
+	/**
+	 * Native counterpart of OnGameplayObjectStateTransitionReversed, broadcast before the dynamic delegate.
+	 */
+	FOnGameplayObjectStateTransitionReversedSignature OnGameplayObjectStateTransitionReversedNative;
+
 	UFUNCTION(BlueprintGetter, Category=GameplayObjectState)
 	FORCEINLINE EGameplayObjectState GetInitialState() const { return InitialState; }
 
 	UFUNCTION(BlueprintSetter, Category=GameplayObjectState)
 	void SetInitialState(const EGameplayObjectState NewState);
 
+	UFUNCTION(BlueprintGetter, Category=GameplayObjectState)
+	FORCEINLINE float GetTransitionDuration() const { return TransitionDuration; }
+
+	UFUNCTION(BlueprintSetter, Category=GameplayObjectState)
+	void SetTransitionDuration(const float NewDuration);
+
+	/**
+	 * Sets InitialState without changing the current states and without triggering any events.
+	 * Used together with RestoreStates to restore states which were saved or mirrored elsewhere.
+	 */
+	void RestoreInitialState(const EGameplayObjectState NewState);
+
+	/**
+	 * Sets CurrentState, TargetState and LastState directly without validation.
+	 * Used to restore states which were saved or mirrored elsewhere.
+	 *
+	 * @param TransitionTimeLeft If non-negative and CurrentState is Transition, the transition finishes after this time.
+	 * @param bBroadcastStateChanged If true, OnGameplayObjectStateChanged is broadcast, otherwise no events are triggered.
+	 */
+	void RestoreStates(const EGameplayObjectState NewCurrentState,
+	                   const EGameplayObjectState NewTargetState,
+	                   const EGameplayObjectState NewLastState,
+	                   const float TransitionTimeLeft = -1.f,
+	                   const bool bBroadcastStateChanged = false);
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	const TStateControllerHistory<EGameplayObjectState>& GetStateHistory() const { return StateHistory; }
+#endif
+
 	UFUNCTION(BlueprintGetter, Category=GameplayObjectState)
 	FORCEINLINE EGameplayObjectState GetCurrentState() const { return CurrentState; }
 
@@ -91,6 +150,17 @@ private:
 		meta=(InvalidEnumValues="EGameplayObjectState::Transition"))
 	EGameplayObjectState InitialState = EGameplayObjectState::Active;
 
+	/**
+	 * If greater than zero, the gameplay object finishes transitions automatically after this time.
+	 * Otherwise FinishGameplayObjetStateTransition must be called manually.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetTransitionDuration,
+		BlueprintSetter=SetTransitionDuration,
+		Category=GameplayObjectState,
+		meta=(ClampMin=0, Units="Seconds"))
+	float TransitionDuration = 0.f;
+
 	/**
 	 * Tracks the current operational state of the gameplay objects.
 	 */
@@ -109,6 +179,30 @@ private:
 	UPROPERTY(VisibleInstanceOnly, BlueprintGetter=GetLastState, Category=GameplayObjectState)
 	EGameplayObjectState LastState = EGameplayObjectState::Active;
 
+	/**
+	 * Handle of the controller in UStateControllerRegistry.
+	 */
+	FStateControllerHandle RegistryHandle;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	/**
+	 * The last state changes, printed by the TrickyGameplayObjects.DumpStateHistory console command.
+	 */
+	TStateControllerHistory<EGameplayObjectState> StateHistory;
+#endif
+
+	/**
+	 * States replicated to clients. Marked dirty only when the states change.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedStates)
+	FStateControllerReplicatedStates ReplicatedStates;
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedStates();
+
 	/**
 	 * Changes the current state of the gameplay objects to the specified new state.
 	 * Handles the logic for both immediate and transitional state changes.
@@ -124,7 +218,5 @@ private:
 	void PrintWarning(const FString& Message) const;
 
 	void PrintLog(const FString& Message) const;
-
-	static void GetStateName(FString& StateName, const EGameplayObjectState State);
 #endif
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "StateController/StateController.h"
 #include "LockInterface.generated.h"
 
 class ULockStateControllerComponent;
@@ -23,6 +24,16 @@ enum class ELockState: uint8
 	Transition
 };
 
+template <>
+struct TStateControllerTraits<ELockState>
+{
+	static constexpr ELockState TransitionState = ELockState::Transition;
+
+	static constexpr EStateControllerType ControllerType = EStateControllerType::Lock;
+};
+
+using FLockStateController = TStateController<ELockState>;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnLockStateChangedDynamicSignature,
                                                ULockStateControllerComponent*, Component,
                                                ELockState, NewState,
@@ -40,6 +51,23 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLockStateTransitionReversedDynam
                                              ULockStateControllerComponent*, Component,
                                              ELockState, NewTargetState);
 
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnLockStateChangedSignature,
+                                       ULockStateControllerComponent*,
+                                       ELockState,
+                                       bool);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLockStateTransitionStartedSignature,
+                                     ULockStateControllerComponent*,
+                                     ELockState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLockStateTransitionFinishedSignature,
+                                     ULockStateControllerComponent*,
+                                     ELockState);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLockStateTransitionReversedSignature,
+                                     ULockStateControllerComponent*,
+                                     ELockState);
+
 // This class does not need to be modified.
 UINTERFACE()
 class ULockInterface : public UInterface
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "Lock/LockInterface.h"
+#include "StateController/StateControllerHistory.h"
+#include "StateController/StateControllerReplicatedStates.h"
 #include "LockStateControllerComponent.generated.h"
 
 
@@ -19,12 +21,20 @@ class TRICKYGAMEPLAYOBJECTS_API ULockStateControllerComponent : public UActorCom
 {
 	GENERATED_BODY()
 
+	friend struct TStateControllerComponentCore<ULockStateControllerComponent>;
+
 public:
 	ULockStateControllerComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
+	virtual void UninitializeComponent() override;
+
 public:
 	/**
 	 * Triggered when CurrentState of the lock was changed.
@@ -50,18 +60,79 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnLockStateTransitionReversedDynamicSignature OnLockTransitionReversed;
 
+	/**
+	 * Native counterpart of OnLockStateChanged, broadcast before the dynamic delegate.
+	 */
+	FOnLockStateChangedSignature OnLockStateChangedNative;
+
+	/**
+	 * Native counterpart of OnLockStateTransitionStarted, broadcast before the dynamic delegate.
+	 */
+	FOnLockStateTransitionStartedSignature OnLockStateTransitionStartedNative;
+
+	/**
+	 * Native counterpart of OnLockStateTransitionFinished, broadcast before the dynamic delegate.
+	 */
+	FOnLockStateTransitionFinishedSignature OnLockStateTransitionFinishedNative;
+
+	/**
+	 * Native counterpart of OnLockTransitionReversed, broadcast before the dynamic delegate.
+	 */
+	FOnLockStateTransitionReversedSignature OnLockTransitionReversedNative;
+
 	UFUNCTION(BlueprintGetter, Category=LockState)
 	FORCEINLINE TSubclassOf<ULockKeyType> GetRequiredKey() const { return RequiredKey; }
 
 	UFUNCTION(BlueprintSetter, Category=LockState)
 	void SetRequiredKey(const TSubclassOf<ULockKeyType>& NewKey);
 
+	UFUNCTION(BlueprintGetter, Category=LockState)
+	FORCEINLINE bool GetMatchKeyHierarchy() const { return bMatchKeyHierarchy; }
+
+	UFUNCTION(BlueprintSetter, Category=LockState)
+	void SetMatchKeyHierarchy(const bool bValue) { bMatchKeyHierarchy = bValue; }
+
+	/**
+	 * Checks if the actor has a keyring with a key which opens the lock without using it.
+	 */
+	UFUNCTION(BlueprintCallable, Category=LockState)
+	bool HasRequiredKey(const AActor* OtherActor) const;
+
 	UFUNCTION(BlueprintGetter, Category=LockState)
 	FORCEINLINE ELockState GetInitialState() const { return InitialState; }
 
 	UFUNCTION(BlueprintSetter, Category=LockState)
 	void SetInitialState(const ELockState NewState);
 
+	UFUNCTION(BlueprintGetter, Category=LockState)
+	FORCEINLINE float GetTransitionDuration() const { return TransitionDuration; }
+
+	UFUNCTION(BlueprintSetter, Category=LockState)
+	void SetTransitionDuration(const float NewDuration);
+
+	/**
+	 * Sets InitialState without changing the current states and without triggering any events.
+	 * Used together with RestoreStates to restore states which were saved or mirrored elsewhere.
+	 */
+	void RestoreInitialState(const ELockState NewState);
+
+	/**
+	 * Sets CurrentState, TargetState and LastState directly without validation.
+	 * Used to restore states which were saved or mirrored elsewhere.
+	 *
+	 * @param TransitionTimeLeft If non-negative and CurrentState is Transition, the transition finishes after this time.
+	 * @param bBroadcastStateChanged If true, OnLockStateChanged is broadcast, otherwise no events are triggered.
+	 */
+	void RestoreStates(const ELockState NewCurrentState,
+	                   const ELockState NewTargetState,
+	                   const ELockState NewLastState,
+	                   const float TransitionTimeLeft = -1.f,
+	                   const bool bBroadcastStateChanged = false);
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	const TStateControllerHistory<ELockState>& GetStateHistory() const { return StateHistory; }
+#endif
+
 	UFUNCTION(BlueprintGetter, Category=LockState)
 	FORCEINLINE ELockState GetCurrentState() const { return CurrentState; }
 
@@ -92,6 +163,15 @@ private:
 	UPROPERTY(EditInstanceOnly, BlueprintGetter=GetRequiredKey, BlueprintSetter=SetRequiredKey, Category=LockState)
 	TSubclassOf<ULockKeyType> RequiredKey = nullptr;
 
+	/**
+	 * Determines if subclasses of the required key and their master ancestor keys open the lock too.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetMatchKeyHierarchy,
+		BlueprintSetter=SetMatchKeyHierarchy,
+		Category=LockState)
+	bool bMatchKeyHierarchy = false;
+
 	/**
 	 * Defines the initial state of the lock during the component's initialization.
 	 * It cannot be set to Transition.
@@ -103,6 +183,17 @@ private:
 		meta=(InvalidEnumValues="ELockState::Transition"))
 	ELockState InitialState = ELockState::Locked;
 
+	/**
+	 * If greater than zero, the lock finishes transitions automatically after this time.
+	 * Otherwise FinishLockStateTransition must be called manually.
+	 */
+	UPROPERTY(EditAnywhere,
+		BlueprintGetter=GetTransitionDuration,
+		BlueprintSetter=SetTransitionDuration,
+		Category=LockState,
+		meta=(ClampMin=0, Units="Seconds"))
+	float TransitionDuration = 0.f;
+
 	/**
 	 * Tracks the current operational state of the lock.
 	 */
@@ -121,6 +212,30 @@ private:
 	UPROPERTY(VisibleInstanceOnly, BlueprintGetter=GetLastState, Category=LockState)
 	ELockState LastState = ELockState::Locked;
 
+	/**
+	 * Handle of the controller in UStateControllerRegistry.
+	 */
+	FStateControllerHandle RegistryHandle;
+
+#if WITH_STATE_CONTROLLER_HISTORY
+	/**
+	 * The last state changes, printed by the TrickyGameplayObjects.DumpStateHistory console command.
+	 */
+	TStateControllerHistory<ELockState> StateHistory;
+#endif
+
+	/**
+	 * States replicated to clients. Marked dirty only when the states change.
+	 */
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedStates)
+	FStateControllerReplicatedStates ReplicatedStates;
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	UFUNCTION()
+	void OnRep_ReplicatedStates();
+
 	/**
 	 * Changes the current state of the lock to the specified new state.
 	 * Handles the logic for both immediate and transitional state changes.
@@ -142,7 +257,5 @@ private:
 	void PrintWarning(const FString& Message) const;
 
 	void PrintLog(const FString& Message) const;
-
-	static void GetStateName(FString& StateName, const ELockState State);
 #endif
 };
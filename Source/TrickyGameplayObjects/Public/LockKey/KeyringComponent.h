@@ -5,8 +5,24 @@
 #include "CoreMinimal.h"
 #include "KeyringInterface.h"
 #include "Components/ActorComponent.h"
+#include "Containers/SortedMap.h"
 #include "KeyringComponent.generated.h"
 
+/**
+ * Defines how a keyring stores its acquired lock keys.
+ */
+UENUM(BlueprintType)
+enum class EKeyringStorageMode : uint8
+{
+	/** Keys are kept in the order they were added. Lookups scan all the keys. */
+	Array,
+	/**
+	 * Keys are stored as bits indexed by the LockKeyTypeRegistry ids with constant time lookups, additions and removals.
+	 * Acquired keys are returned in the order of their ids.
+	 */
+	Bitset
+};
+
 /**
  * This component provides functionality to add, remove and sue LockKeys.
  */
@@ -18,6 +34,8 @@ class TRICKYGAMEPLAYOBJECTS_API UKeyringComponent : public UActorComponent, publ
 public:
 	UKeyringComponent();
 
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void InitializeComponent() override;
 
@@ -58,13 +76,154 @@ public:
 
 	virtual bool HasLockKey_Implementation(const TSubclassOf<ULockKeyType> LockKey) const override;
 
+	/**
+	 * Returns the number of the keys of the given class in the keyring.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	int32 GetLockKeyCount(const TSubclassOf<ULockKeyType> LockKey) const;
+
+	/**
+	 * Checks if the keyring has every valid key of the array. Returns true if the array is empty.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	bool HasAllLockKeys(const TArray<TSubclassOf<ULockKeyType>>& LockKeys) const;
+
+	/**
+	 * Checks if the keyring has at least one key of the array.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	bool HasAnyLockKey(const TArray<TSubclassOf<ULockKeyType>>& LockKeys) const;
+
+	/**
+	 * Returns the number of the acquired keys of the given class or its subclasses.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	int32 GetNumLockKeysOfClass(const TSubclassOf<ULockKeyType> BaseClass) const;
+
+	/**
+	 * Checks if the keyring has a key which opens a lock requiring the given key type when the key hierarchy is matched:
+	 * the type itself, its subclass or its master ancestor.
+	 * In the Bitset storage mode the check is one intersection with the precomputed bits of the matching keys.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	bool HasMatchingLockKey(const TSubclassOf<ULockKeyType> RequiredKey) const;
+
+	/**
+	 * Returns the acquired key which opens a lock requiring the given key type when the key hierarchy is matched.
+	 * The required type itself is preferred, otherwise the matching key with the lowest id is returned.
+	 */
+	UFUNCTION(BlueprintCallable, Category=KeyRing)
+	TSubclassOf<ULockKeyType> FindMatchingLockKey(const TSubclassOf<ULockKeyType> RequiredKey) const;
+
+	/**
+	 * Checks if the keyring has every key of the bitset indexed by the LockKeyTypeRegistry ids.
+	 * In the Bitset storage mode the check is a word-wise intersection of the bitsets.
+	 */
+	bool HasAllLockKeyBits(const TBitArray<>& KeyBits) const;
+
+	bool HasAnyLockKeyBits(const TBitArray<>& KeyBits) const;
+
+	/**
+	 * Returns the acquired keys without copying them and without repeating stacked keys.
+	 * In the Bitset storage mode the keys are in the order of their ids, and the view is rebuilt from the bits after
+	 * they changed, so it must not be stored.
+	 */
+	TConstArrayView<TSubclassOf<ULockKeyType>> GetAcquiredLockKeysView() const;
+
+	/**
+	 * Returns the acquired keys indexed by the LockKeyTypeRegistry ids. Empty in the Array storage mode.
+	 */
+	const TBitArray<>& GetAcquiredLockKeyBits() const { return AcquiredKeyBits; }
+
+	/**
+	 * Replaces all the acquired keys without events. Used to restore saved keys.
+	 * Stacked keys are repeated in the array as many times as they were acquired.
+	 */
+	void RestoreLockKeys(TArray<TSubclassOf<ULockKeyType>> LockKeys);
+
+	UFUNCTION(BlueprintGetter, Category=KeyRing)
+	EKeyringStorageMode GetStorageMode() const { return StorageMode; }
+
+	/**
+	 * Changes the storage mode keeping the acquired keys without events.
+	 */
+	UFUNCTION(BlueprintSetter, Category=KeyRing)
+	void SetStorageMode(const EKeyringStorageMode Value);
+
+	/**
+	 * True while OnLockKeyRemoved is broadcast for a key consumed by UseLockKey.
+	 */
+	bool IsConsumingLockKey() const { return bIsConsumingLockKey; }
+
 private:
+	UPROPERTY(EditAnywhere, BlueprintGetter=GetStorageMode, BlueprintSetter=SetStorageMode, Category=KeyRing)
+	EKeyringStorageMode StorageMode = EKeyringStorageMode::Array;
+
 	/**
-	 * Stores lock keys that have been acquired.
+	 * Stores lock keys that have been acquired in the Array storage mode.
 	 */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category=KeyRing, meta=(AllowPrivateAccess))
 	TArray<TSubclassOf<ULockKeyType>> AcquiredKeys;
 
+	/**
+	 * Stores lock keys that have been acquired in the Bitset storage mode. Indexed by the LockKeyTypeRegistry ids.
+	 */
+	TBitArray<> AcquiredKeyBits;
+
+	/**
+	 * Acquired keys returned by GetAcquiredLockKeysView in the Bitset storage mode.
+	 */
+	mutable TArray<TSubclassOf<ULockKeyType>> AcquiredKeyBitsView;
+
+	/**
+	 * Counts of the stacked keys by their LockKeyTypeRegistry ids. Keys which aren't stacked have no entries.
+	 */
+	TSortedMap<int32, int32, TInlineAllocator<4>> StackedKeyCounts;
+
+	bool bIsConsumingLockKey = false;
+
+	mutable bool bIsAcquiredKeyBitsViewDirty = false;
+
+	bool IsStorageEmpty() const;
+
+	bool ContainsLockKey(const TSubclassOf<ULockKeyType>& LockKey) const;
+
+	/**
+	 * @return Index of the key in the array or its id in the bitset, INDEX_NONE if it wasn't added.
+	 */
+	int32 AddToStorage(const TSubclassOf<ULockKeyType>& LockKey);
+
+	bool RemoveFromStorage(const TSubclassOf<ULockKeyType>& LockKey);
+
+	void ClearStorage();
+
+	/**
+	 * Returns the number of the keys of the class which is already in the storage.
+	 */
+	int32 GetStackCount(const TSubclassOf<ULockKeyType>& LockKey) const;
+
+	/**
+	 * Adds one more key of the class which is already in the storage if it's below the MaxStackSize.
+	 * @return The new count or INDEX_NONE.
+	 */
+	int32 StackLockKey(const TSubclassOf<ULockKeyType>& LockKey);
+
+	/**
+	 * Removes one key of the class from the storage.
+	 */
+	bool RemoveOneFromStorage(const TSubclassOf<ULockKeyType>& LockKey);
+
+	/**
+	 * Fills the bits of the keys for HasAllLockKeyBits and HasAnyLockKeyBits. The returned bitset is reused by the
+	 * next call.
+	 */
+	static const TBitArray<>& MakeLockKeyBits(const TArray<TSubclassOf<ULockKeyType>>& LockKeys);
+
+	/**
+	 * Calls HasLockKey directly if it isn't overridden in Blueprint, otherwise uses Execute_HasLockKey.
+	 */
+	bool HasLockKeyDispatched(const TSubclassOf<ULockKeyType>& LockKey) const;
+
 #if WITH_EDITOR || !UE_BUILD_SHIPPING
 	void PrintLog(const FString& Message) const;
 #endif
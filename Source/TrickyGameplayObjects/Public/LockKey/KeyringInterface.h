@@ -43,7 +43,7 @@ class TRICKYGAMEPLAYOBJECTS_API IKeyringInterface
 
 public:
 	/**
-	 * Retrieves an array of acquired keys.
+	 * Retrieves an array of acquired keys. Stacked keys are repeated as many times as they were acquired.
 	 *
 	 * @param AcquiredLockKeys Array of acquired keys.
 	 */
@@ -54,7 +54,7 @@ public:
 
 	/**
 	 * Adds the specified lock key type to the key ring.
-	 * @warning It's impossible to add several keys of one class.
+	 * @warning It's impossible to add more keys of one class than the MaxStackSize of the key type.
 	 *
 	 * @param LockKeyType A lock key class to add.
 	 * @return True if the lock key was successfully added, false otherwise.
@@ -65,7 +65,7 @@ public:
 	virtual bool AddLockKey_Implementation(TSubclassOf<ULockKeyType> LockKeyType);
 
 	/**
-	 * Removes a specified lock key type from the key ring.
+	 * Removes one key of the specified lock key type from the key ring.
 	 *
 	 * @param LockKeyType A lock key class to remove.
 	 * @return True if the lock key was successfully added, false otherwise.
@@ -88,6 +88,7 @@ public:
 
 	/**
 	 * Attempts to use a specified lock key type from the key ring.
+	 * One key is removed after the use if the key type is consumed on use.
 	 *
 	 * @param LockKeyType A lock key class to use.
 	 * @return True if the key was successfully used, false otherwise.
@@ -14,4 +14,32 @@ class TRICKYGAMEPLAYOBJECTS_API ULockKeyType : public UObject
 {
 	GENERATED_BODY()
 
+public:
+	UFUNCTION(BlueprintGetter, Category=LockKey)
+	bool GetConsumedOnUse() const { return bConsumedOnUse; }
+
+	UFUNCTION(BlueprintGetter, Category=LockKey)
+	int32 GetMaxStackSize() const { return MaxStackSize; }
+
+	UFUNCTION(BlueprintGetter, Category=LockKey)
+	bool IsMasterKey() const { return bMasterKey; }
+
+private:
+	/**
+	 * Determines if one key of this type is removed from the keyring every time it's used.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintGetter=GetConsumedOnUse, Category=LockKey)
+	bool bConsumedOnUse = false;
+
+	/**
+	 * Maximum number of keys of this type a keyring can hold, e.g. 3 lockpicks.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintGetter=GetMaxStackSize, Category=LockKey, meta=(ClampMin=1))
+	int32 MaxStackSize = 1;
+
+	/**
+	 * Determines if keys of this type open the locks which match the key hierarchy and require any subclass of it.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintGetter=IsMasterKey, Category=LockKey)
+	bool bMasterKey = false;
 };
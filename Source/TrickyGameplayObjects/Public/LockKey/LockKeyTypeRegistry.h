@@ -0,0 +1,72 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+#include "UObject/TopLevelAssetPath.h"
+
+class ULockKeyType;
+
+/**
+ * Assigns every ULockKeyType subclass a dense integer id, so keyrings, locks and save data can store key types as
+ * small integers and bitsets instead of class pointers.
+ * Native classes and the Blueprint classes known by the asset registry are discovered after the engine initialization
+ * and numbered in the order of their path names, so the ids are the same between runs with the same content.
+ * Classes which appear later, e.g. new Blueprints in the editor, get the next free ids.
+ * Ids are never reused or changed while the module is loaded.
+ * @warning Must be used only from the game thread.
+ */
+struct TRICKYGAMEPLAYOBJECTS_API FLockKeyTypeRegistry
+{
+	/**
+	 * Discovers the key types after the engine initialization and once the asset registry finished loading assets.
+	 */
+	static void Initialize();
+
+	static void Shutdown();
+
+	/**
+	 * Registers the native and the Blueprint key classes which don't have ids yet.
+	 */
+	static void DiscoverKeyTypes();
+
+	/**
+	 * Returns the id of the key class, registering it if needed.
+	 *
+	 * @return INDEX_NONE if the class isn't a ULockKeyType.
+	 */
+	static int32 GetKeyId(const UClass* LockKey);
+
+	/**
+	 * Returns the id of the key class without registering it.
+	 *
+	 * @return INDEX_NONE if the class isn't registered.
+	 */
+	static int32 FindKeyId(const UClass* LockKey);
+
+	static int32 FindKeyIdByPath(const FTopLevelAssetPath& Path);
+
+	/**
+	 * Returns the key class with the given id if it's loaded, nullptr otherwise.
+	 */
+	static TSubclassOf<ULockKeyType> GetKeyClass(const int32 KeyId);
+
+	static FTopLevelAssetPath GetKeyPath(const int32 KeyId);
+
+	/**
+	 * Returns the bits of the key types which open a lock requiring the given key type when the key hierarchy is
+	 * matched: the type itself, its subclasses and its ancestors which are master keys.
+	 * Precomputed from the ancestors of the loaded key classes and updated when new classes are loaded, so the returned
+	 * reference must not be stored. The bitset can be shorter than the number of the key types.
+	 */
+	static const TBitArray<>& GetMatchingKeyBits(const int32 RequiredKeyId);
+
+	/**
+	 * Fills the bitset indexed by the key ids with the given key classes, registering them if needed.
+	 * Used to precompute key sets for UKeyringComponent::HasAllLockKeyBits and HasAnyLockKeyBits.
+	 */
+	static void MakeKeyBits(TConstArrayView<TSubclassOf<ULockKeyType>> LockKeys, TBitArray<>& OutKeyBits);
+
+	static int32 GetNumKeyTypes();
+};
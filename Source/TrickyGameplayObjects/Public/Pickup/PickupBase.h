@@ -25,6 +25,8 @@ class TRICKYGAMEPLAYOBJECTS_API APickupBase : public AActor
 public:
 	APickupBase();
 
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	virtual void BeginDestroy() override;
 
@@ -0,0 +1,55 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+
+/**
+ * Helper which allows calling BlueprintNativeEvent interface functions directly on C++ implementations.
+ * Execute_ thunks always go through FindFunction and ProcessEvent, even when the function isn't overridden in Blueprint.
+ * The check is cached per class and function.
+ *
+ * Usage:
+ * if (IKeyringInterface* Keyring = FNativeInterfaceDispatch::GetNativeInterface<IKeyringInterface>(
+ *     Object, GET_FUNCTION_NAME_CHECKED(IKeyringInterface, UseLockKey)))
+ * {
+ *     return Keyring->UseLockKey_Implementation(LockKey);
+ * }
+ * return IKeyringInterface::Execute_UseLockKey(Object, LockKey);
+ */
+struct TRICKYGAMEPLAYOBJECTS_API FNativeInterfaceDispatch
+{
+	/**
+	 * Checks if the given function of the class is implemented in C++ and isn't overridden in Blueprint.
+	 * @warning Must be called from the game thread.
+	 */
+	static bool IsNativeImplementation(const UClass* Class, const FName FunctionName);
+
+	/**
+	 * Returns the native interface pointer of the object if the function can be called directly, nullptr otherwise.
+	 */
+	template <typename InterfaceType>
+	static InterfaceType* GetNativeInterface(UObject* Object, const FName FunctionName)
+	{
+		if (!IsValid(Object))
+		{
+			return nullptr;
+		}
+
+		InterfaceType* Interface = Cast<InterfaceType>(Object);
+
+		if (!Interface || !IsNativeImplementation(Object->GetClass(), FunctionName))
+		{
+			return nullptr;
+		}
+
+		return Interface;
+	}
+
+	template <typename InterfaceType>
+	static const InterfaceType* GetNativeInterface(const UObject* Object, const FName FunctionName)
+	{
+		return GetNativeInterface<InterfaceType>(const_cast<UObject*>(Object), FunctionName);
+	}
+};
@@ -0,0 +1,144 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateControllerTypes.h"
+
+/**
+ * Describes a state enum which can be driven by TStateController.
+ * Must be specialized for every state enum and provide the TransitionState which can't be entered directly
+ * and the ControllerType of the component which uses the enum.
+ * All the states must be declared before TransitionState.
+ */
+template <typename EnumType>
+struct TStateControllerTraits;
+
+/**
+ * Constexpr table of the states which can be entered from every state.
+ */
+template <typename EnumType>
+struct TStateTransitionTable
+{
+	static constexpr uint8 TransitionIndex = static_cast<uint8>(TStateControllerTraits<EnumType>::TransitionState);
+	static constexpr uint8 NumStates = TransitionIndex + 1;
+	static_assert(NumStates <= 8, "TStateTransitionTable supports up to 8 states per enum.");
+
+	static constexpr uint8 AllStatesMask = static_cast<uint8>((1u << NumStates) - 1u);
+
+	constexpr TStateTransitionTable()
+	{
+		for (uint8 Index = 0; Index < NumStates; ++Index)
+		{
+			AllowedTargets[Index] = AllStatesMask & ~(1u << Index) & ~(1u << TransitionIndex);
+		}
+	}
+
+	uint8 AllowedTargets[NumStates] = {};
+};
+
+/**
+ * Shared state machine core used by all state controller components.
+ * Keeps CurrentState, TargetState and LastState of a controller consistent.
+ * Components own the state properties and handle events, this struct only validates and applies the changes.
+ */
+template <typename EnumType>
+struct TStateController
+{
+	using FTraits = TStateControllerTraits<EnumType>;
+
+	static constexpr EnumType TransitionState = FTraits::TransitionState;
+
+	static constexpr TStateTransitionTable<EnumType> TransitionTable{};
+
+	static constexpr uint8 ToMask(const EnumType State)
+	{
+		return static_cast<uint8>(1u << static_cast<uint8>(State));
+	}
+
+	static constexpr bool IsTransition(const EnumType State)
+	{
+		return State == TransitionState;
+	}
+
+	/**
+	 * Checks if the controller can change its CurrentState to NewState.
+	 * NewState must differ from CurrentState and can't be Transition.
+	 */
+	static constexpr bool CanChangeState(const EnumType CurrentState, const EnumType NewState)
+	{
+		return (TransitionTable.AllowedTargets[static_cast<uint8>(CurrentState)] & ToMask(NewState)) != 0;
+	}
+
+	/**
+	 * Changes CurrentState to NewState or to Transition if the change isn't immediate.
+	 *
+	 * @return True if the state was successfully changed, false otherwise.
+	 */
+	static FORCEINLINE bool ChangeState(EnumType& CurrentState,
+	                                    EnumType& TargetState,
+	                                    EnumType& LastState,
+	                                    const EnumType NewState,
+	                                    const bool bTransitImmediately)
+	{
+		if (!CanChangeState(CurrentState, NewState))
+		{
+			return false;
+		}
+
+		TargetState = NewState;
+		LastState = CurrentState;
+		CurrentState = bTransitImmediately ? NewState : TransitionState;
+		return true;
+	}
+
+	/**
+	 * Swaps TargetState with LastState.
+	 * @warning CurrentState should be Transition.
+	 *
+	 * @return True if the target state was successfully reversed, false otherwise.
+	 */
+	static FORCEINLINE bool ReverseTransition(const EnumType CurrentState, EnumType& TargetState, EnumType& LastState)
+	{
+		if (!IsTransition(CurrentState))
+		{
+			return false;
+		}
+
+		Swap(TargetState, LastState);
+		return true;
+	}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+	static FString GetStateName(const EnumType State)
+	{
+		return StaticEnum<EnumType>()->GetNameStringByValue(static_cast<int64>(State));
+	}
+
+	static FORCENOINLINE FString GetStateChangedMessage(const EnumType CurrentState)
+	{
+		return FString::Printf(TEXT("State changed to %s"), *GetStateName(CurrentState));
+	}
+
+	static FORCENOINLINE FString GetTransitionStartedMessage(const EnumType LastState, const EnumType TargetState)
+	{
+		return FString::Printf(TEXT("Start state transition from %s to %s"),
+		                       *GetStateName(LastState),
+		                       *GetStateName(TargetState));
+	}
+
+	static FORCENOINLINE FString GetTransitionReversedMessage(const EnumType LastState, const EnumType TargetState)
+	{
+		return FString::Printf(TEXT("TargetState reversed from %s to %s"),
+		                       *GetStateName(LastState),
+		                       *GetStateName(TargetState));
+	}
+#endif
+};
+
+/**
+ * Shared implementation of the state controller components, defined in StateControllerComponentCore.h.
+ * Components declare it as a friend.
+ */
+template <typename ComponentType>
+struct TStateControllerComponentCore;
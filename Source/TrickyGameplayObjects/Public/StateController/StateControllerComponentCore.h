@@ -0,0 +1,396 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateController.h"
+#include "StateControllerPersistenceSubsystem.h"
+#include "StateControllerRegistry.h"
+#include "StateControllerTransitionScheduler.h"
+#include "TrickyGameplayObjectsLog.h"
+#include "TrickyGameplayObjectsStats.h"
+#include "TrickyGameplayObjectsTrace.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+/**
+ * Binds a state controller component to TStateControllerComponentCore.
+ * Must be specialized in the source file of the component and provide:
+ * - EnumType, the state enum of the component;
+ * - StateChanged, TransitionStarted, TransitionFinished and TransitionReversed pointers to the dynamic events and
+ *   the same names with the Native suffix to their native counterparts;
+ * - static void CountTransition(), which increments the transition stat of the component.
+ */
+template <typename ComponentType>
+struct TStateControllerComponentBinding;
+
+/**
+ * Shared implementation of the state controller components.
+ * Components own the state properties, the events and the interface functions, and forward the registry,
+ * persistence, replication, scheduler, history, trace and log work here, so it's written once for every state enum.
+ * Must be a friend of the component, which should have CurrentState, TargetState, LastState, InitialState,
+ * TransitionDuration, RegistryHandle, ReplicatedStates and StateHistory members and PrintWarning and PrintLog
+ * functions.
+ */
+template <typename ComponentType>
+struct TStateControllerComponentCore
+{
+	using FBinding = TStateControllerComponentBinding<ComponentType>;
+
+	using EnumType = typename FBinding::EnumType;
+
+	using FController = TStateController<EnumType>;
+
+	static constexpr EStateControllerType ControllerType = TStateControllerTraits<EnumType>::ControllerType;
+
+	/**
+	 * Loads the states stored for the component and registers it. Called after CurrentState is set to InitialState.
+	 */
+	static void Register(ComponentType& Component)
+	{
+		UStateControllerPersistenceSubsystem::LoadStates(&Component,
+		                                                 Component.CurrentState,
+		                                                 Component.TargetState,
+		                                                 Component.LastState);
+
+		if (UStateControllerRegistry* Registry = UStateControllerRegistry::Get(&Component))
+		{
+			Component.RegistryHandle = Registry->RegisterController(&Component,
+			                                                        Component.CurrentState,
+			                                                        Component.TargetState,
+			                                                        Component.LastState);
+		}
+
+		Component.ReplicatedStates.Set(Component.CurrentState, Component.TargetState, Component.LastState);
+	}
+
+	static void Unregister(ComponentType& Component)
+	{
+		if (UStateControllerRegistry* Registry = UStateControllerRegistry::Get(&Component))
+		{
+			Registry->UnregisterController(Component.RegistryHandle);
+		}
+	}
+
+	/**
+	 * The states and the history are stored inline, only the invocation lists of the events are allocated.
+	 */
+	static SIZE_T GetEventsAllocatedSize(const ComponentType& Component)
+	{
+		return (Component.*FBinding::StateChanged).GetAllocatedSize()
+			+ (Component.*FBinding::StateChangedNative).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionStarted).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionStartedNative).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionFinished).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionFinishedNative).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionReversed).GetAllocatedSize()
+			+ (Component.*FBinding::TransitionReversedNative).GetAllocatedSize();
+	}
+
+	static void RestoreInitialState(ComponentType& Component, const EnumType NewState)
+	{
+		if (!FController::IsTransition(NewState))
+		{
+			Component.InitialState = NewState;
+		}
+	}
+
+	static void RestoreStates(ComponentType& Component,
+	                          const EnumType NewCurrentState,
+	                          const EnumType NewTargetState,
+	                          const EnumType NewLastState,
+	                          const float TransitionTimeLeft,
+	                          const bool bBroadcastStateChanged)
+	{
+		Component.CurrentState = NewCurrentState;
+		Component.TargetState = NewTargetState;
+		Component.LastState = NewLastState;
+		SyncStates(Component);
+
+		if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(&Component))
+		{
+			if (FController::IsTransition(Component.CurrentState) && Component.TransitionDuration > 0.f)
+			{
+				Scheduler->ScheduleTransition(&Component,
+				                              ControllerType,
+				                              Component.TransitionDuration,
+				                              TransitionTimeLeft);
+			}
+			else
+			{
+				Scheduler->CancelTransition(&Component);
+			}
+		}
+
+		if (bBroadcastStateChanged)
+		{
+			BroadcastStateChanged(Component, !FController::IsTransition(Component.CurrentState));
+		}
+	}
+
+	/**
+	 * Changes CurrentState to NewState or to Transition, schedules or cancels the automatic transition finish
+	 * and broadcasts the events.
+	 *
+	 * @return True if the state was successfully changed, false otherwise.
+	 */
+	static bool ChangeState(ComponentType& Component, const EnumType NewState, const bool bTransitImmediately)
+	{
+		TRICKY_GAMEPLAY_OBJECTS_SCOPE_CYCLE_COUNTER(ChangeCurrentState);
+
+		EnumType& CurrentState = Component.CurrentState;
+		EnumType& TargetState = Component.TargetState;
+		EnumType& LastState = Component.LastState;
+
+		if (!FController::ChangeState(CurrentState, TargetState, LastState, NewState, bTransitImmediately))
+		{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+			if (FController::IsTransition(NewState))
+			{
+				Component.PrintWarning("Can't change CurrentState to Transition");
+			}
+#endif
+			return false;
+		}
+
+		SyncStates(Component);
+		FBinding::CountTransition();
+
+		if (FController::IsTransition(CurrentState) && Component.TransitionDuration > 0.f)
+		{
+			if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(&Component))
+			{
+				Scheduler->ScheduleTransition(&Component, ControllerType, Component.TransitionDuration);
+			}
+		}
+		else if (FController::IsTransition(LastState))
+		{
+			if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(&Component))
+			{
+				Scheduler->CancelTransition(&Component);
+			}
+		}
+
+		TRACE_STATE_CONTROLLER_CHANGED_SCOPE(&Component, false, LastState, CurrentState, TargetState);
+
+		if (!bTransitImmediately)
+		{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+			if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+			{
+				Component.PrintLog(FController::GetTransitionStartedMessage(LastState, TargetState));
+			}
+#endif
+
+			BroadcastTransitionStarted(Component);
+		}
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+		if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+		{
+			Component.PrintLog(FController::GetStateChangedMessage(CurrentState));
+		}
+#endif
+
+		BroadcastStateChanged(Component, bTransitImmediately);
+		return true;
+	}
+
+	static bool FinishTransition(ComponentType& Component)
+	{
+		if (!FController::IsTransition(Component.CurrentState))
+		{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+			Component.PrintWarning("Can't finish transition, because CurrentState isn't Transition");
+#endif
+			return false;
+		}
+
+		if (!ChangeState(Component, Component.TargetState, true))
+		{
+			return false;
+		}
+
+		BroadcastTransitionFinished(Component);
+		return true;
+	}
+
+	static bool ReverseTransition(ComponentType& Component)
+	{
+		if (!FController::ReverseTransition(Component.CurrentState, Component.TargetState, Component.LastState))
+		{
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+			Component.PrintWarning("Can't reverse transition, because CurrentState isn't Transition");
+#endif
+			return false;
+		}
+
+		SyncStates(Component);
+
+		if (Component.TransitionDuration > 0.f)
+		{
+			if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(&Component))
+			{
+				Scheduler->ReverseTransition(&Component);
+			}
+		}
+
+		TRACE_STATE_CONTROLLER_CHANGED_SCOPE(&Component,
+		                                     true,
+		                                     Component.LastState,
+		                                     Component.CurrentState,
+		                                     Component.TargetState);
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+		if (FTrickyGameplayObjectsLog::IsVerboseLogEnabled())
+		{
+			Component.PrintLog(FController::GetTransitionReversedMessage(Component.LastState, Component.TargetState));
+		}
+#endif
+
+		BroadcastTransitionReversed(Component);
+		return true;
+	}
+
+	/**
+	 * Pushes the states to the registry, the history and replication after they were changed.
+	 */
+	static void SyncStates(ComponentType& Component)
+	{
+		UStateControllerRegistry::UpdateController(&Component,
+		                                           Component.RegistryHandle,
+		                                           Component.CurrentState,
+		                                           Component.TargetState,
+		                                           Component.LastState);
+
+#if WITH_STATE_CONTROLLER_HISTORY
+		Component.StateHistory.Record(&Component, Component.CurrentState, Component.TargetState, Component.LastState);
+#endif
+
+		if (Component.GetOwnerRole() != ROLE_Authority)
+		{
+			return;
+		}
+
+		Component.ReplicatedStates.Set(Component.CurrentState, Component.TargetState, Component.LastState);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ComponentType, ReplicatedStates, &Component);
+	}
+
+	/**
+	 * Applies the replicated states and broadcasts the same events as the local state changes.
+	 */
+	static void ApplyReplicatedStates(ComponentType& Component)
+	{
+		EnumType& CurrentState = Component.CurrentState;
+		EnumType& TargetState = Component.TargetState;
+		EnumType& LastState = Component.LastState;
+
+		const EnumType OldCurrentState = CurrentState;
+		const EnumType OldTargetState = TargetState;
+		const EnumType OldLastState = LastState;
+		Component.ReplicatedStates.Get(CurrentState, TargetState, LastState);
+		UStateControllerRegistry::UpdateController(&Component,
+		                                           Component.RegistryHandle,
+		                                           CurrentState,
+		                                           TargetState,
+		                                           LastState);
+
+#if WITH_STATE_CONTROLLER_HISTORY
+		Component.StateHistory.Record(&Component, CurrentState, TargetState, LastState);
+#endif
+
+		// The server finishes its transitions and replicates them. A finish scheduled locally, e.g. by a prediction,
+		// would be applied to these states instead and finish a newer transition early.
+		if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(&Component);
+			Scheduler && Scheduler->IsTransitionScheduled(&Component))
+		{
+			Scheduler->CancelTransition(&Component);
+		}
+
+		if (CurrentState == OldCurrentState)
+		{
+			if (!FController::IsTransition(CurrentState) || TargetState == OldTargetState)
+			{
+				return;
+			}
+
+			if (TargetState == OldLastState && LastState == OldTargetState)
+			{
+				BroadcastTransitionReversed(Component);
+				return;
+			}
+
+			// A new transition started after the previous one finished between updates.
+			BroadcastTransitionStarted(Component);
+			return;
+		}
+
+		const bool bTransitImmediately = !FController::IsTransition(CurrentState);
+
+		if (!bTransitImmediately)
+		{
+			BroadcastTransitionStarted(Component);
+		}
+
+		BroadcastStateChanged(Component, bTransitImmediately);
+
+		if (FController::IsTransition(OldCurrentState) && CurrentState == OldTargetState)
+		{
+			BroadcastTransitionFinished(Component);
+		}
+	}
+
+	/**
+	 * Applies the last replicated states again, discarding the local changes. Does nothing on the authority, where
+	 * the replicated states are the local ones.
+	 */
+	static void RestoreReplicatedStates(ComponentType& Component)
+	{
+		if (Component.GetOwnerRole() != ROLE_Authority)
+		{
+			ApplyReplicatedStates(Component);
+		}
+	}
+
+private:
+	static void BroadcastStateChanged(ComponentType& Component, const bool bTransitImmediately)
+	{
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::StateChangedNative),
+		                                  &Component,
+		                                  Component.CurrentState,
+		                                  bTransitImmediately);
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::StateChanged),
+		                                  &Component,
+		                                  Component.CurrentState,
+		                                  bTransitImmediately);
+	}
+
+	static void BroadcastTransitionStarted(ComponentType& Component)
+	{
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionStartedNative),
+		                                  &Component,
+		                                  Component.TargetState);
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionStarted),
+		                                  &Component,
+		                                  Component.TargetState);
+	}
+
+	static void BroadcastTransitionFinished(ComponentType& Component)
+	{
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionFinishedNative),
+		                                  &Component,
+		                                  Component.CurrentState);
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionFinished),
+		                                  &Component,
+		                                  Component.CurrentState);
+	}
+
+	static void BroadcastTransitionReversed(ComponentType& Component)
+	{
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionReversedNative),
+		                                  &Component,
+		                                  Component.TargetState);
+		TRICKY_GAMEPLAY_OBJECTS_BROADCAST((Component.*FBinding::TransitionReversed),
+		                                  &Component,
+		                                  Component.TargetState);
+	}
+};
@@ -0,0 +1,116 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "StateControllerTypes.h"
+#include "StateControllerDormancyManager.generated.h"
+
+class AActor;
+class UActorComponent;
+class UStateControllerRegistry;
+
+/**
+ * Puts replicated owners of state controllers into net dormancy on the server
+ * when none of their controllers changed for StableTime and none of them is in Transition.
+ * Owners are woken up as soon as any of their controllers changes its states.
+ * Owners with DORM_Never dormancy are ignored, and owners which replicate anything besides their state controllers,
+ * e.g. movement, their own properties or other replicated components, are never put into dormancy.
+ * Disabled by default, enable bManageNetDormancy to use it.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerDormancyManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerDormancyManager* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	int32 GetNumDormantOwners() const { return NumDormantOwners; }
+
+	int32 GetNumAwakeOwners() const { return Owners.Num() - NumDormantOwners; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/**
+	 * If false, the dormancy of the owners isn't changed.
+	 */
+	UPROPERTY(Config)
+	bool bManageNetDormancy = false;
+
+	/**
+	 * Time in seconds the states of all the controllers of an owner must stay unchanged before it goes dormant.
+	 */
+	UPROPERTY(Config)
+	float StableTime = 10.f;
+
+	struct FOwnerEntry
+	{
+		TWeakObjectPtr<AActor> Owner = nullptr;
+
+		TArray<FStateControllerHandle, TInlineAllocator<2>> Handles;
+
+		uint32 Serial = 0;
+
+		bool bIsDormant = false;
+	};
+
+	struct FPendingOwner
+	{
+		TObjectKey<AActor> Key;
+
+		double StableTime = 0.0;
+
+		uint32 Serial = 0;
+	};
+
+	TMap<TObjectKey<AActor>, FOwnerEntry> Owners;
+
+	/**
+	 * Owners in the order they become stable. All of them wait the same time, so the queue is always sorted.
+	 * Entries of owners which changed again are skipped lazily by serial mismatch.
+	 */
+	TArray<FPendingOwner> PendingOwners;
+
+	int32 PendingHead = 0;
+
+	int32 NumDormantOwners = 0;
+
+	UPROPERTY()
+	UStateControllerRegistry* Registry = nullptr;
+
+	bool IsServer() const;
+
+	double GetCurrentTime() const;
+
+	void AddController(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void RemoveController(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void HandleStatesChanged(const FStateControllerHandle& Handle);
+
+	void EnqueueOwner(AActor* Owner, FOwnerEntry& Entry);
+
+	void WakeOwner(FOwnerEntry& Entry);
+
+	/**
+	 * Checks if the owner replicates only its state controllers and the properties of AActor itself.
+	 */
+	bool ReplicatesOnlyStateControllers(AActor* Owner, const FOwnerEntry& Entry) const;
+
+	void UpdateStats() const;
+};
@@ -0,0 +1,128 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * State history is compiled out of Shipping builds unless the project defines WITH_STATE_CONTROLLER_HISTORY.
+ */
+#ifndef WITH_STATE_CONTROLLER_HISTORY
+#define WITH_STATE_CONTROLLER_HISTORY (WITH_EDITOR || !UE_BUILD_SHIPPING)
+#endif
+
+/**
+ * Number of entries kept by every controller. Must be a power of two.
+ */
+#ifndef STATE_CONTROLLER_HISTORY_SIZE
+#define STATE_CONTROLLER_HISTORY_SIZE 16
+#endif
+
+#if WITH_STATE_CONTROLLER_HISTORY
+
+/**
+ * Single state change of a controller.
+ */
+struct FStateControllerHistoryEntry
+{
+	uint32 FrameNumber = 0;
+
+	float Timestamp = 0.f;
+
+	/** Object which caused the change, if any was set with FStateControllerHistoryInstigatorScope. */
+	FObjectKey Instigator;
+
+	uint8 FromState = 0;
+
+	uint8 ToState = 0;
+
+	uint8 TargetState = 0;
+};
+
+/**
+ * Sets the instigator recorded by all the state changes made within the scope. Game thread only.
+ */
+struct TRICKYGAMEPLAYOBJECTS_API FStateControllerHistoryInstigatorScope
+{
+	explicit FStateControllerHistoryInstigatorScope(const UObject* Instigator);
+
+	~FStateControllerHistoryInstigatorScope();
+
+	static FObjectKey GetCurrentInstigator() { return CurrentInstigator; }
+
+private:
+	FObjectKey PreviousInstigator;
+
+	static FObjectKey CurrentInstigator;
+};
+
+struct TRICKYGAMEPLAYOBJECTS_API FStateControllerHistoryUtils
+{
+	/**
+	 * Fills the frame number, the world time and the current instigator.
+	 */
+	static void StampEntry(const UObject* Controller, FStateControllerHistoryEntry& Entry);
+
+	static void PrintEntry(FOutputDevice& Ar, const FStateControllerHistoryEntry& Entry, const UEnum* StateEnum);
+};
+
+/**
+ * Fixed-size ring buffer of the last state changes of a controller. Never allocates.
+ */
+template <typename EnumType, uint32 Capacity = STATE_CONTROLLER_HISTORY_SIZE>
+class TStateControllerHistory
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "History capacity must be a power of two.");
+
+public:
+	/**
+	 * Adds an entry if CurrentState or TargetState differs from the last entry.
+	 * The previous state is taken from the last entry, or from LastState for the first one.
+	 */
+	void Record(const UObject* Controller,
+	            const EnumType CurrentState,
+	            const EnumType TargetState,
+	            const EnumType LastState)
+	{
+		const FStateControllerHistoryEntry* PreviousEntry = NumRecorded > 0
+			                                                    ? &Entries[(NumRecorded - 1) & (Capacity - 1)]
+			                                                    : nullptr;
+
+		if (PreviousEntry
+			&& PreviousEntry->ToState == static_cast<uint8>(CurrentState)
+			&& PreviousEntry->TargetState == static_cast<uint8>(TargetState))
+		{
+			return;
+		}
+
+		FStateControllerHistoryEntry& Entry = Entries[NumRecorded & (Capacity - 1)];
+		Entry.FromState = PreviousEntry ? PreviousEntry->ToState : static_cast<uint8>(LastState);
+		Entry.ToState = static_cast<uint8>(CurrentState);
+		Entry.TargetState = static_cast<uint8>(TargetState);
+		FStateControllerHistoryUtils::StampEntry(Controller, Entry);
+		++NumRecorded;
+	}
+
+	/**
+	 * Prints the entries from the oldest to the newest.
+	 */
+	void Dump(FOutputDevice& Ar) const
+	{
+		const uint32 First = NumRecorded > Capacity ? NumRecorded - Capacity : 0;
+
+		for (uint32 Index = First; Index < NumRecorded; ++Index)
+		{
+			FStateControllerHistoryUtils::PrintEntry(Ar, Entries[Index & (Capacity - 1)], StaticEnum<EnumType>());
+		}
+	}
+
+	uint32 GetNumRecorded() const { return NumRecorded; }
+
+private:
+	FStateControllerHistoryEntry Entries[Capacity];
+
+	uint32 NumRecorded = 0;
+};
+
+#endif
@@ -0,0 +1,210 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StateController.h"
+#include "StateControllerTypes.h"
+#include "StateControllerPersistenceSubsystem.generated.h"
+
+class UActorComponent;
+class ULevel;
+class UStateControllerRegistry;
+
+/**
+ * Keeps the states of state controllers which were streamed out with their level, e.g. a World Partition cell,
+ * and applies them when the controllers are streamed back in.
+ * The states are stored in a flat open addressing table keyed by the stable id of the controller,
+ * which takes about 14 bytes per controller.
+ * Controllers which were in Transition are stored in their TargetState with the state the transition started from
+ * as LastState.
+ * The states of a level are collected while it's being removed and stored in bulk once it's removed. They're erased
+ * when the controllers load them and are saved with the full snapshots of UStateControllerSnapshotSubsystem.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerPersistenceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerPersistenceSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Replaces the states with the stored ones if the controller was streamed out before and erases them.
+	 * Called by the controllers in InitializeComponent before they register.
+	 */
+	template <typename EnumType>
+	static void LoadStates(const UActorComponent* Controller,
+	                       EnumType& OutCurrentState,
+	                       EnumType& OutTargetState,
+	                       EnumType& OutLastState)
+	{
+		UStateControllerPersistenceSubsystem* Persistence = Get(Controller);
+		uint16 PackedStates = 0;
+
+		if (!Persistence || !Persistence->TakeStates(Controller, PackedStates))
+		{
+			return;
+		}
+
+		const uint8 CurrentState = UnpackState(PackedStates, 0);
+		const uint8 TargetState = UnpackState(PackedStates, 1);
+		const uint8 LastState = UnpackState(PackedStates, 2);
+		constexpr uint8 TransitionIndex = TStateTransitionTable<EnumType>::TransitionIndex;
+
+		// LastState is Transition after a finished transition, but Current and Target states never are,
+		// so other values belong to another controller type.
+		if (CurrentState >= TransitionIndex || TargetState >= TransitionIndex || LastState > TransitionIndex)
+		{
+			return;
+		}
+
+		OutCurrentState = static_cast<EnumType>(CurrentState);
+		OutTargetState = static_cast<EnumType>(TargetState);
+		OutLastState = static_cast<EnumType>(LastState);
+	}
+
+	/**
+	 * Stores the states of a controller which isn't registered, e.g. a demoted Mass entity, streamed out with its
+	 * level. They're stored in bulk with the rest of the level once it's removed. The controller component loads them
+	 * with LoadStates when it's streamed back in.
+	 *
+	 * @param StableId Stable id of the controller component. See UStateControllerSnapshotSubsystem::GetStableId.
+	 */
+	template <typename EnumType>
+	void StoreStates(const uint64 StableId,
+	                 const EnumType CurrentState,
+	                 const EnumType TargetState,
+	                 const EnumType LastState)
+	{
+		if (!IsPersistingStreamedOutStates())
+		{
+			return;
+		}
+
+		// Same as for the registered controllers, LastState already holds the state the transition started from.
+		const bool bIsInTransition = TStateController<EnumType>::IsTransition(CurrentState);
+		AddPendingStates(MakeKey(StableId),
+		                 PackStates(static_cast<uint8>(bIsInTransition ? TargetState : CurrentState),
+		                            static_cast<uint8>(TargetState),
+		                            static_cast<uint8>(LastState)));
+	}
+
+	/**
+	 * Returns the number of the stored controllers including the ones of the levels which are being removed.
+	 */
+	int32 GetNumStoredControllers() const { return NumEntries + PendingKeys.Num(); }
+
+	bool IsPersistingStreamedOutStates() const { return bPersistStreamedOutStates && IsValid(Registry); }
+
+	/**
+	 * Returns the memory allocated by the table in bytes.
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Keys.GetAllocatedSize() + Values.GetAllocatedSize() + PendingKeys.GetAllocatedSize()
+			+ PendingValues.GetAllocatedSize();
+	}
+
+	/**
+	 * Removes all the stored states.
+	 */
+	void Reset();
+
+	/**
+	 * Copies the stored states with their keys, e.g. to save them with a snapshot.
+	 */
+	void GetStoredStates(TArray<uint64>& OutKeys, TArray<uint16>& OutPackedStates);
+
+	/**
+	 * Replaces the stored states with the ones copied by GetStoredStates.
+	 */
+	void RestoreStoredStates(TConstArrayView<uint64> InKeys, TConstArrayView<uint16> InPackedStates);
+
+	/**
+	 * Checks if the stored states changed since the last ClearDirty call, so deltas can skip saving them.
+	 */
+	bool IsDirty() const { return bIsDirty; }
+
+	void ClearDirty() { bIsDirty = false; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr uint32 BitsPerState = 3;
+
+	/**
+	 * Marks empty slots. Ids which are equal to it are remapped.
+	 */
+	static constexpr uint64 EmptyKey = 0;
+
+	/**
+	 * If false, the states of the streamed out controllers aren't stored.
+	 */
+	UPROPERTY(Config)
+	bool bPersistStreamedOutStates = true;
+
+	UPROPERTY()
+	UStateControllerRegistry* Registry = nullptr;
+
+	/** Open addressing table with linear probing. The number of slots is a power of two. */
+	TArray<uint64> Keys;
+
+	/** CurrentState, TargetState and LastState packed into 3 bits each. */
+	TArray<uint16> Values;
+
+	int32 NumEntries = 0;
+
+	/** States of the controllers unregistered while their level is being removed, stored once it's removed. */
+	TArray<uint64> PendingKeys;
+
+	TArray<uint16> PendingValues;
+
+	bool bIsDirty = false;
+
+	FDelegateHandle LevelRemovedHandle;
+
+	static uint8 UnpackState(const uint16 PackedStates, const uint32 StateIndex)
+	{
+		return static_cast<uint8>(PackedStates >> StateIndex * BitsPerState & ((1u << BitsPerState) - 1u));
+	}
+
+	static uint16 PackStates(const uint8 CurrentState, const uint8 TargetState, const uint8 LastState)
+	{
+		return static_cast<uint16>(CurrentState | TargetState << BitsPerState | LastState << BitsPerState * 2);
+	}
+
+	static uint64 MakeKey(const UObject* Object);
+
+	static uint64 MakeKey(const uint64 StableId);
+
+	bool TakeStates(const UActorComponent* Controller, uint16& OutPackedStates);
+
+	void StoreStates(const uint64 Key, const uint16 PackedStates);
+
+	void AddPendingStates(const uint64 Key, const uint16 PackedStates);
+
+	void FlushPendingStates();
+
+	/**
+	 * Grows the table once, so the given number of entries can be stored without rehashing.
+	 */
+	void Reserve(const int32 NumElements);
+
+	void Rehash(const int32 NumSlots);
+
+	/**
+	 * Removes the entry and shifts the following entries of its probe sequence back, so no tombstones are needed.
+	 */
+	void RemoveSlot(uint32 Slot);
+
+	void HandleControllerUnregistered(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void HandleLevelRemoved(ULevel* Level, UWorld* World);
+};
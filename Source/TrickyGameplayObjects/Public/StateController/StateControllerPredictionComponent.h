@@ -0,0 +1,132 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "StateControllerPredictionComponent.generated.h"
+
+class UButtonStateControllerComponent;
+class UDoorStateControllerComponent;
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnStateControllerPredictionResolvedSignature,
+                                       uint16 /*PredictionKey*/,
+                                       bool /*bAccepted*/,
+                                       float /*RoundTripTime*/);
+
+/**
+ * Predicts door and button state changes on the owning client.
+ * The change is applied locally right away and sent to the server with a prediction key.
+ * If the server rejects it or doesn't answer in PredictionTimeout, the controller is rolled back to its last
+ * replicated states, which are authoritative.
+ * Must be added to an actor owned by the player connection, e.g. a player controller or a pawn.
+ * The server accepts requests only for the controllers which are relevant for the player and within
+ * MaxInteractionDistance of its view target.
+ */
+UCLASS(ClassGroup=(TrickyGameplayObjects), meta=(BlueprintSpawnableComponent))
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerPredictionComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UStateControllerPredictionComponent();
+
+	/**
+	 * Triggered on the owning client when the server confirmed or rejected a prediction.
+	 */
+	FOnStateControllerPredictionResolvedSignature OnPredictionResolved;
+
+	/**
+	 * Opens the door locally and asks the server to open it. Calls OpenDoor directly on the server.
+	 *
+	 * @return True if the door was opened locally.
+	 */
+	UFUNCTION(BlueprintCallable, Category=StateControllerPrediction)
+	bool PredictOpenDoor(UDoorStateControllerComponent* Door, const bool bTransitImmediately);
+
+	/**
+	 * Presses the button locally and asks the server to press it. Calls PressButton directly on the server.
+	 *
+	 * @return True if the button was pressed locally.
+	 */
+	UFUNCTION(BlueprintCallable, Category=StateControllerPrediction)
+	bool PredictPressButton(UButtonStateControllerComponent* Button, const bool bTransitImmediately);
+
+	/**
+	 * Checks if the owner is an autonomous proxy whose requests reach the server.
+	 * Server RPCs of other clients' actors are dropped, so nothing would confirm or reject their predictions.
+	 */
+	bool CanPredict() const;
+
+	int32 GetNumPendingPredictions() const { return PendingPredictions.Num(); }
+
+	uint16 GetLastPredictionKey() const { return LastPredictionKey; }
+
+private:
+	/**
+	 * Pending predictions are rejected and rolled back if the server doesn't answer in this time.
+	 * Zero disables the timeout.
+	 */
+	UPROPERTY(EditAnywhere, Category=StateControllerPrediction, meta=(ClampMin=0, Units="Seconds"))
+	float PredictionTimeout = 5.f;
+
+	/**
+	 * Maximum distance between the view target of the player and the owner of a controller the server lets the player
+	 * change. Zero disables the check.
+	 */
+	UPROPERTY(EditAnywhere, Category=StateControllerPrediction, meta=(ClampMin=0, Units="Centimeters"))
+	float MaxInteractionDistance = 1000.f;
+
+	struct FPendingPrediction
+	{
+		uint16 Key = 0;
+
+		TWeakObjectPtr<UActorComponent> Controller = nullptr;
+
+		double SendTime = 0.0;
+	};
+
+	/**
+	 * Sorted by SendTime.
+	 */
+	TArray<FPendingPrediction> PendingPredictions;
+
+	uint16 LastPredictionKey = 0;
+
+	FTimerHandle TimeoutTimerHandle;
+
+	UFUNCTION(Server, Reliable)
+	void ServerOpenDoor(UDoorStateControllerComponent* Door,
+	                    const bool bTransitImmediately,
+	                    const uint16 PredictionKey);
+
+	UFUNCTION(Server, Reliable)
+	void ServerPressButton(UButtonStateControllerComponent* Button,
+	                       const bool bTransitImmediately,
+	                       const uint16 PredictionKey);
+
+	UFUNCTION(Client, Reliable)
+	void ClientResolvePrediction(const uint16 PredictionKey, const bool bAccepted);
+
+	uint16 AddPendingPrediction(UActorComponent* Controller);
+
+	/**
+	 * Removes the prediction and rolls its controller back to the last replicated states if it was rejected.
+	 */
+	void ResolvePrediction(const int32 Index, const bool bAccepted);
+
+	/**
+	 * Rejects the predictions which weren't answered in PredictionTimeout.
+	 */
+	void ExpirePredictions();
+
+	void ScheduleTimeout();
+
+	/**
+	 * Checks on the server if the player owning this component may change the controller.
+	 */
+	bool CanInteractWith(const UActorComponent* Controller) const;
+
+	double GetCurrentTime() const;
+};
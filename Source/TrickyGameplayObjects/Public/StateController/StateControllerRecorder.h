@@ -0,0 +1,130 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StateControllerTypes.h"
+#include "StateControllerRecorder.generated.h"
+
+class AActor;
+class UKeyringComponent;
+class ULockKeyType;
+class UStateControllerRegistry;
+
+/**
+ * Throughput and correctness numbers of a replayed recording.
+ */
+struct FStateControllerReplayResult
+{
+	int32 NumEvents = 0;
+
+	/** Events which objects weren't found in the world. */
+	int32 NumSkippedEvents = 0;
+
+	/** Events after which the states differed from the recorded ones. */
+	int32 NumMismatchedEvents = 0;
+
+	/** Controllers and keyrings which final states differ from the recorded ones. */
+	int32 NumMismatchedFinalStates = 0;
+
+	double TotalSeconds = 0.0;
+
+	double MaxEventSeconds = 0.0;
+
+	double GetEventsPerSecond() const { return TotalSeconds > 0.0 ? NumEvents / TotalSeconds : 0.0; }
+
+	double GetAverageEventSeconds() const { return NumEvents > 0 ? TotalSeconds / NumEvents : 0.0; }
+};
+
+/**
+ * Records every state change of the state controllers and every keyring operation in the world
+ * into an append-only binary stream, and replays such streams against the same level as fast as possible.
+ * The stream starts and ends with the states of all the controllers and keyrings,
+ * so the replay starts from the recorded states and checks the final ones.
+ * Recording and replay are also available via the TrickyGameplayObjects.StartRecording, StopRecording and Replay
+ * console commands, which can be used in headless runs with -ExecCmds.
+ */
+UCLASS()
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerRecorder : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerRecorder* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Starts a new recording. Does nothing if recording is already in progress.
+	 */
+	void StartRecording();
+
+	/**
+	 * Finishes the recording and moves the stream into OutStream.
+	 *
+	 * @return False if there was no recording in progress.
+	 */
+	bool StopRecording(TArray<uint8>& OutStream);
+
+	bool IsRecording() const { return bIsRecording; }
+
+	/**
+	 * Restores the initial states from the stream, applies all its events through the controller and keyring
+	 * interfaces and compares the final states.
+	 *
+	 * @return False if the data isn't a valid recording.
+	 */
+	bool Replay(const TArray<uint8>& Stream, FStateControllerReplayResult& OutResult);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr uint32 RecordingMagic = 0x53435243;
+
+	static constexpr uint8 RecordingVersion = 1;
+
+	UPROPERTY()
+	UStateControllerRegistry* Registry = nullptr;
+
+	bool bIsRecording = false;
+
+	TArray<uint8> Stream;
+
+	/** Stable ids of the recorded controllers, so the path names aren't built on every change. */
+	TMap<FStateControllerHandle, uint64> ControllerIds;
+
+	/** Indices of the key classes which were already defined in the stream. */
+	TMap<const UClass*, uint16> KeyIndices;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	void HandleStatesChanged(const FStateControllerHandle& Handle);
+
+	void HandleActorSpawned(AActor* Actor);
+
+	void BindKeyring(UKeyringComponent* Keyring);
+
+	void UnbindKeyrings();
+
+	UFUNCTION()
+	void HandleLockKeyAdded(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey);
+
+	UFUNCTION()
+	void HandleLockKeyRemoved(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey);
+
+	UFUNCTION()
+	void HandleAllLockKeysRemoved(UKeyringComponent* Component);
+
+	UFUNCTION()
+	void HandleLockKeyUsed(UKeyringComponent* Component, TSubclassOf<ULockKeyType> LockKey);
+
+	void WriteKeyEvent(const uint8 EventType, const UKeyringComponent* Keyring, const UClass* LockKey);
+
+	uint16 GetKeyIndex(FArchive& Ar, const UClass* LockKey);
+
+	void WriteWorldStates(const uint8 EventType);
+};
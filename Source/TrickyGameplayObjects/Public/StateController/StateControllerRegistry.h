@@ -0,0 +1,355 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StateController.h"
+#include "StateControllerTypes.h"
+#include "StateControllerRegistry.generated.h"
+
+class UActorComponent;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStateControllerRegistrationChangedSignature,
+                                     const FStateControllerHandle&,
+                                     UActorComponent*);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnStateControllerStatesChangedSignature, const FStateControllerHandle&);
+
+/**
+ * World-level registry of all state controllers.
+ * Controllers register themselves on initialization and keep their states in sync on every change.
+ * States are stored per controller type in dense arrays, so queries and iteration never touch the components.
+ */
+UCLASS()
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerRegistry* Get(const UObject* WorldContextObject);
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Triggered after a controller was added to the registry.
+	 */
+	FOnStateControllerRegistrationChangedSignature OnControllerRegistered;
+
+	/**
+	 * Triggered before a controller is removed from the registry.
+	 */
+	FOnStateControllerRegistrationChangedSignature OnControllerUnregistered;
+
+	/**
+	 * Triggered after the stored states of a controller were updated.
+	 */
+	FOnStateControllerStatesChangedSignature OnControllerStatesChanged;
+
+	/**
+	 * Adds the controller to the registry.
+	 *
+	 * @return Stable handle of the controller which is valid until it's unregistered.
+	 */
+	template <typename EnumType>
+	FStateControllerHandle RegisterController(UActorComponent* Controller,
+	                                          const EnumType CurrentState,
+	                                          const EnumType TargetState,
+	                                          const EnumType LastState)
+	{
+		return RegisterControllerInternal(Controller,
+		                                  TStateControllerTraits<EnumType>::ControllerType,
+		                                  static_cast<uint8>(CurrentState),
+		                                  static_cast<uint8>(TargetState),
+		                                  static_cast<uint8>(LastState),
+		                                  static_cast<uint8>(TStateControllerTraits<EnumType>::TransitionState));
+	}
+
+	/**
+	 * Removes the controller from the registry and resets its handle.
+	 */
+	void UnregisterController(FStateControllerHandle& Handle);
+
+	/**
+	 * Updates the stored states of the controller. Does nothing if the handle isn't valid.
+	 */
+	template <typename EnumType>
+	void UpdateController(const FStateControllerHandle& Handle,
+	                      const EnumType CurrentState,
+	                      const EnumType TargetState,
+	                      const EnumType LastState)
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+
+		if (DenseIndex == INDEX_NONE)
+		{
+			return;
+		}
+
+		FControllerStorage& Storage = GetStorage(Handle.Type);
+		Storage.CurrentStates[DenseIndex] = static_cast<uint8>(CurrentState);
+		Storage.TargetStates[DenseIndex] = static_cast<uint8>(TargetState);
+		Storage.LastStates[DenseIndex] = static_cast<uint8>(LastState);
+		OnControllerStatesChanged.Broadcast(Handle);
+	}
+
+	/**
+	 * Updates the stored states of the controller in the registry of the controller's world.
+	 */
+	template <typename EnumType>
+	static void UpdateController(const UObject* WorldContextObject,
+	                             const FStateControllerHandle& Handle,
+	                             const EnumType CurrentState,
+	                             const EnumType TargetState,
+	                             const EnumType LastState)
+	{
+		if (!Handle.IsSet())
+		{
+			return;
+		}
+
+		if (UStateControllerRegistry* Registry = Get(WorldContextObject))
+		{
+			Registry->UpdateController(Handle, CurrentState, TargetState, LastState);
+		}
+	}
+
+	bool IsValidHandle(const FStateControllerHandle& Handle) const
+	{
+		return GetDenseIndex(Handle) != INDEX_NONE;
+	}
+
+	/**
+	 * Returns the registered component. The only accessor which touches UObjects.
+	 */
+	UActorComponent* ResolveController(const FStateControllerHandle& Handle) const;
+
+	template <typename ComponentType>
+	ComponentType* ResolveController(const FStateControllerHandle& Handle) const
+	{
+		return Cast<ComponentType>(ResolveController(Handle));
+	}
+
+	/**
+	 * Returns the raw CurrentState value of the controller or INDEX_NONE if the handle isn't valid.
+	 */
+	int32 GetRawCurrentState(const FStateControllerHandle& Handle) const
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+		return DenseIndex == INDEX_NONE ? INDEX_NONE : GetStorage(Handle.Type).CurrentStates[DenseIndex];
+	}
+
+	/**
+	 * Checks if CurrentState of the controller is Transition. Returns false if the handle isn't valid.
+	 */
+	bool IsInTransition(const FStateControllerHandle& Handle) const
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+
+		if (DenseIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const FControllerStorage& Storage = GetStorage(Handle.Type);
+		return Storage.CurrentStates[DenseIndex] == Storage.TransitionState;
+	}
+
+	/**
+	 * Returns the raw states of the controller of any type. Returns false if the handle isn't valid.
+	 */
+	bool GetRawStates(const FStateControllerHandle& Handle,
+	                  uint8& OutCurrentState,
+	                  uint8& OutTargetState,
+	                  uint8& OutLastState) const
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+
+		if (DenseIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const FControllerStorage& Storage = GetStorage(Handle.Type);
+		OutCurrentState = Storage.CurrentStates[DenseIndex];
+		OutTargetState = Storage.TargetStates[DenseIndex];
+		OutLastState = Storage.LastStates[DenseIndex];
+		return true;
+	}
+
+	template <typename EnumType>
+	bool GetStates(const FStateControllerHandle& Handle,
+	               EnumType& OutCurrentState,
+	               EnumType& OutTargetState,
+	               EnumType& OutLastState) const
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+
+		if (DenseIndex == INDEX_NONE || Handle.Type != TStateControllerTraits<EnumType>::ControllerType)
+		{
+			return false;
+		}
+
+		const FControllerStorage& Storage = GetStorage(Handle.Type);
+		OutCurrentState = static_cast<EnumType>(Storage.CurrentStates[DenseIndex]);
+		OutTargetState = static_cast<EnumType>(Storage.TargetStates[DenseIndex]);
+		OutLastState = static_cast<EnumType>(Storage.LastStates[DenseIndex]);
+		return true;
+	}
+
+	int32 GetNumControllers(const EStateControllerType Type) const
+	{
+		return GetStorage(Type).Handles.Num();
+	}
+
+	/**
+	 * Dense arrays of the given controller type. All of them are indexed the same way.
+	 * The order isn't stable and changes when controllers are unregistered.
+	 */
+	template <typename EnumType>
+	TConstArrayView<EnumType> GetCurrentStates() const
+	{
+		return MakeStateView<EnumType>(GetStorage(TStateControllerTraits<EnumType>::ControllerType).CurrentStates);
+	}
+
+	template <typename EnumType>
+	TConstArrayView<EnumType> GetTargetStates() const
+	{
+		return MakeStateView<EnumType>(GetStorage(TStateControllerTraits<EnumType>::ControllerType).TargetStates);
+	}
+
+	template <typename EnumType>
+	TConstArrayView<EnumType> GetLastStates() const
+	{
+		return MakeStateView<EnumType>(GetStorage(TStateControllerTraits<EnumType>::ControllerType).LastStates);
+	}
+
+	TConstArrayView<FStateControllerHandle> GetHandles(const EStateControllerType Type) const
+	{
+		return GetStorage(Type).Handles;
+	}
+
+	/**
+	 * Counts the controllers which CurrentState equals the given state.
+	 */
+	template <typename EnumType>
+	int32 CountControllersInState(const EnumType State) const
+	{
+		const uint8 RawState = static_cast<uint8>(State);
+		int32 Count = 0;
+
+		for (const uint8 CurrentState : GetStorage(TStateControllerTraits<EnumType>::ControllerType).CurrentStates)
+		{
+			Count += CurrentState == RawState;
+		}
+
+		return Count;
+	}
+
+	/**
+	 * Appends the handles of the controllers which CurrentState equals the given state.
+	 */
+	template <typename EnumType>
+	void GetControllersInState(const EnumType State, TArray<FStateControllerHandle>& OutHandles) const
+	{
+		const FControllerStorage& Storage = GetStorage(TStateControllerTraits<EnumType>::ControllerType);
+		const uint8 RawState = static_cast<uint8>(State);
+
+		for (int32 Index = 0; Index < Storage.CurrentStates.Num(); ++Index)
+		{
+			if (Storage.CurrentStates[Index] == RawState)
+			{
+				OutHandles.Add(Storage.Handles[Index]);
+			}
+		}
+	}
+
+	/**
+	 * Calls Func(Handle, CurrentState, TargetState, LastState) for every registered controller of the given type.
+	 * @warning Controllers must not be registered or unregistered inside Func.
+	 */
+	template <typename EnumType, typename FuncType>
+	void ForEachController(FuncType&& Func) const
+	{
+		const FControllerStorage& Storage = GetStorage(TStateControllerTraits<EnumType>::ControllerType);
+
+		for (int32 Index = 0; Index < Storage.Handles.Num(); ++Index)
+		{
+			Func(Storage.Handles[Index],
+			     static_cast<EnumType>(Storage.CurrentStates[Index]),
+			     static_cast<EnumType>(Storage.TargetStates[Index]),
+			     static_cast<EnumType>(Storage.LastStates[Index]));
+		}
+	}
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FControllerStorage
+	{
+		/** Dense arrays, indexed by dense index. */
+		TArray<uint8> CurrentStates;
+
+		TArray<uint8> TargetStates;
+
+		TArray<uint8> LastStates;
+
+		TArray<FStateControllerHandle> Handles;
+
+		TArray<TWeakObjectPtr<UActorComponent>> Controllers;
+
+		/** Sparse arrays, indexed by handle index. */
+		TArray<int32> DenseIndices;
+
+		TArray<uint32> Serials;
+
+		TArray<uint32> FreeIndices;
+
+		/** Raw value of the Transition state of the controller type. */
+		uint8 TransitionState = 0;
+	};
+
+	FControllerStorage Storages[static_cast<uint8>(EStateControllerType::Num)];
+
+	FControllerStorage& GetStorage(const EStateControllerType Type)
+	{
+		return Storages[static_cast<uint8>(Type)];
+	}
+
+	const FControllerStorage& GetStorage(const EStateControllerType Type) const
+	{
+		return Storages[static_cast<uint8>(Type)];
+	}
+
+	int32 GetDenseIndex(const FStateControllerHandle& Handle) const
+	{
+		if (!Handle.IsSet() || Handle.Type >= EStateControllerType::Num)
+		{
+			return INDEX_NONE;
+		}
+
+		const FControllerStorage& Storage = GetStorage(Handle.Type);
+
+		if (!Storage.Serials.IsValidIndex(Handle.Index) || Storage.Serials[Handle.Index] != Handle.Serial)
+		{
+			return INDEX_NONE;
+		}
+
+		return Storage.DenseIndices[Handle.Index];
+	}
+
+	template <typename EnumType>
+	static TConstArrayView<EnumType> MakeStateView(const TArray<uint8>& States)
+	{
+		static_assert(sizeof(EnumType) == sizeof(uint8), "State enums must be uint8.");
+		return TConstArrayView<EnumType>(reinterpret_cast<const EnumType*>(States.GetData()), States.Num());
+	}
+
+	FStateControllerHandle RegisterControllerInternal(UActorComponent* Controller,
+	                                                  const EStateControllerType Type,
+	                                                  const uint8 CurrentState,
+	                                                  const uint8 TargetState,
+	                                                  const uint8 LastState,
+	                                                  const uint8 TransitionState);
+};
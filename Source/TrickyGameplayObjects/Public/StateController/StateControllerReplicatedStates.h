@@ -0,0 +1,70 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateControllerReplicatedStates.generated.h"
+
+/**
+ * CurrentState, TargetState and LastState of a state controller packed for replication.
+ * Every state is serialized with 3 bits, which is enough for any state enum supported by TStateController.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTS_API FStateControllerReplicatedStates
+{
+	GENERATED_BODY()
+
+	static constexpr uint32 BitsPerState = 3;
+
+	static constexpr uint32 StateMask = (1u << BitsPerState) - 1u;
+
+	UPROPERTY()
+	uint8 CurrentState = 0;
+
+	UPROPERTY()
+	uint8 TargetState = 0;
+
+	UPROPERTY()
+	uint8 LastState = 0;
+
+	template <typename EnumType>
+	void Set(const EnumType NewCurrentState, const EnumType NewTargetState, const EnumType NewLastState)
+	{
+		CurrentState = static_cast<uint8>(NewCurrentState);
+		TargetState = static_cast<uint8>(NewTargetState);
+		LastState = static_cast<uint8>(NewLastState);
+	}
+
+	template <typename EnumType>
+	void Get(EnumType& OutCurrentState, EnumType& OutTargetState, EnumType& OutLastState) const
+	{
+		OutCurrentState = static_cast<EnumType>(CurrentState);
+		OutTargetState = static_cast<EnumType>(TargetState);
+		OutLastState = static_cast<EnumType>(LastState);
+	}
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FStateControllerReplicatedStates& Other) const
+	{
+		return CurrentState == Other.CurrentState
+			&& TargetState == Other.TargetState
+			&& LastState == Other.LastState;
+	}
+
+	bool operator!=(const FStateControllerReplicatedStates& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+template <>
+struct TStructOpsTypeTraits<FStateControllerReplicatedStates> : public TStructOpsTypeTraitsBase2<
+		FStateControllerReplicatedStates>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
@@ -0,0 +1,174 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StateControllerTypes.h"
+#include "StateControllerSnapshotSubsystem.generated.h"
+
+class UActorComponent;
+class UStateControllerRegistry;
+
+/**
+ * States of a controller as they're written to a snapshot.
+ */
+struct FStateControllerSnapshotRecord
+{
+	/** Stable id of the controller component. */
+	uint64 Id = 0;
+
+	EStateControllerType Type = EStateControllerType::Door;
+
+	uint8 InitialState = 0;
+
+	uint8 CurrentState = 0;
+
+	uint8 TargetState = 0;
+
+	uint8 LastState = 0;
+
+	/** Negative if the remaining time is unknown. Only meaningful if CurrentState is Transition. */
+	float TransitionTimeLeft = -1.f;
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStateControllerSnapshotSavingSignature,
+                                     bool /*bOnlyDirty*/,
+                                     TArray<FStateControllerSnapshotRecord>& /*OutRecords*/);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnStateControllerSnapshotRestoringSignature,
+                                    TConstArrayView<FStateControllerSnapshotRecord> /*Records*/);
+
+/**
+ * Saves and restores the states of all registered state controllers and the contents of all keyrings
+ * in the world as a single compact binary blob.
+ * Objects are identified by stable ids built from their path names, so the snapshot can be restored after reloading
+ * the same map.
+ * Controllers which changed their states since the last save are tracked, so autosaves can write only a delta.
+ * Changed controllers which are unregistered before the next save, e.g. streamed out, are written with their final
+ * states.
+ * Controllers which live outside of the registry, e.g. demoted to Mass entities, are saved and restored through
+ * OnSavingControllers and OnRestoringControllers.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerSnapshotSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerSnapshotSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Triggered while saving, so the states of controllers which aren't registered can be added to the records.
+	 * If bOnlyDirty is true, only the ones which changed since the last save should be added.
+	 * Listeners should clear their dirty controllers afterwards, the same as the subsystem does.
+	 */
+	FOnStateControllerSnapshotSavingSignature OnSavingControllers;
+
+	/**
+	 * Triggered while restoring with the records which didn't match any registered controller, possibly none.
+	 * The restored states are already saved, so listeners should clear their dirty controllers here.
+	 */
+	FOnStateControllerSnapshotRestoringSignature OnRestoringControllers;
+
+	/**
+	 * Writes InitialState, CurrentState, TargetState, LastState and the remaining transition time of every
+	 * registered controller, the acquired keys of every keyring and the states of the streamed out controllers stored
+	 * by UStateControllerPersistenceSubsystem into OutData. Clears the dirty controllers.
+	 */
+	void SaveSnapshot(TArray<uint8>& OutData);
+
+	/**
+	 * Writes only the controllers which changed their states since the last save and the acquired keys of every
+	 * keyring into OutData. The stored states of the streamed out controllers are written only if they changed.
+	 * Clears the dirty controllers.
+	 */
+	void SaveDelta(TArray<uint8>& OutData);
+
+	/**
+	 * Applies the snapshot or the delta to the matching objects. Objects which aren't found are skipped.
+	 * Deltas must be applied in the order they were saved after the snapshot they're based on.
+	 *
+	 * @param bBroadcastEvents If false, the states and keys are restored without any events and logs.
+	 * @return False if the data isn't a valid snapshot.
+	 */
+	bool RestoreSnapshot(const TArray<uint8>& Data, const bool bBroadcastEvents = false);
+
+	/**
+	 * Merges a full snapshot and the deltas saved after it into a single full snapshot. Doesn't need the world,
+	 * so it can be called on any thread.
+	 *
+	 * @param Snapshots The full snapshot followed by the deltas in the order they were saved.
+	 * @return False if any of the data isn't valid or the first one isn't a full snapshot.
+	 */
+	static bool CompactSnapshots(TConstArrayView<TArray<uint8>> Snapshots, TArray<uint8>& OutSnapshot);
+
+	/**
+	 * Checks if MaxDeltasPerSnapshot deltas were saved since the last full snapshot.
+	 */
+	bool ShouldSaveSnapshot() const { return NumDeltasSinceSnapshot >= MaxDeltasPerSnapshot; }
+
+	int32 GetNumDirtyControllers() const { return DirtyHandles.Num() + RemovedRecords.Num(); }
+
+	int32 GetNumDeltasSinceSnapshot() const { return NumDeltasSinceSnapshot; }
+
+	/**
+	 * Returns the id of the object which stays the same between sessions for objects loaded from a map.
+	 */
+	static uint64 GetStableId(const UObject* Object);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr uint32 SnapshotMagic = 0x534F4754;
+
+	static constexpr uint8 SnapshotVersion = 3;
+
+	/**
+	 * Number of deltas after which ShouldSaveSnapshot returns true.
+	 */
+	UPROPERTY(Config)
+	int32 MaxDeltasPerSnapshot = 10;
+
+	UPROPERTY()
+	UStateControllerRegistry* Registry = nullptr;
+
+	/** Dirty flags indexed by the handle index of every controller type. */
+	TBitArray<> DirtyFlags[static_cast<uint8>(EStateControllerType::Num)];
+
+	/** Handles of the dirty controllers, so saving a delta doesn't iterate all the controllers. */
+	TArray<FStateControllerHandle> DirtyHandles;
+
+	/**
+	 * Final states of the dirty controllers which were unregistered before the next save, by their stable ids.
+	 * They're written by the next save before the registered controllers, so a controller registered again wins.
+	 */
+	TMap<uint64, FStateControllerSnapshotRecord> RemovedRecords;
+
+	int32 NumDeltasSinceSnapshot = 0;
+
+	void MarkControllerDirty(const FStateControllerHandle& Handle);
+
+	void RemoveController(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void ClearDirtyControllers();
+
+	static void WriteHeader(FArchive& Ar, const bool bIsDelta);
+
+	void SaveControllers(FArchive& Ar, const bool bOnlyDirty) const;
+
+	void SaveKeyrings(FArchive& Ar) const;
+
+	void RestoreControllers(FArchive& Ar, const bool bBroadcastEvents) const;
+
+	void RestoreKeyrings(FArchive& Ar, const bool bBroadcastEvents) const;
+
+	void SaveStoredStates(FArchive& Ar, const bool bOnlyDirty) const;
+
+	void RestoreStoredStates(FArchive& Ar) const;
+};
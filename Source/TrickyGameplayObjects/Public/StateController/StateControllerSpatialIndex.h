@@ -0,0 +1,156 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StateController.h"
+#include "StateControllerTypes.h"
+#include "StateControllerSpatialIndex.generated.h"
+
+class UActorComponent;
+class UStateControllerRegistry;
+
+/**
+ * Spatial hash of the owners of all registered state controllers.
+ * Answers radius, box and k-nearest queries filtered by controller type and CurrentState.
+ * Owners with movable root components are updated incrementally when they move.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerSpatialIndex : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Matches any CurrentState in queries.
+	 */
+	static constexpr uint8 AnyStateMask = 0xFF;
+
+	static UStateControllerSpatialIndex* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Appends the handles of the controllers which owners are inside the sphere.
+	 */
+	void QueryRadius(const FVector& Center,
+	                 const float Radius,
+	                 const EStateControllerType Type,
+	                 const uint8 StateMask,
+	                 TArray<FStateControllerHandle>& OutHandles) const;
+
+	/**
+	 * Appends the handles of the controllers which owners are inside the box.
+	 */
+	void QueryBox(const FBox& Box,
+	              const EStateControllerType Type,
+	              const uint8 StateMask,
+	              TArray<FStateControllerHandle>& OutHandles) const;
+
+	/**
+	 * Finds up to Count controllers nearest to the location within MaxRadius, sorted by distance.
+	 */
+	void QueryNearest(const FVector& Location,
+	                  const int32 Count,
+	                  const float MaxRadius,
+	                  const EStateControllerType Type,
+	                  const uint8 StateMask,
+	                  TArray<FStateControllerHandle>& OutHandles) const;
+
+	template <typename EnumType>
+	void QueryRadius(const FVector& Center,
+	                 const float Radius,
+	                 const EnumType State,
+	                 TArray<FStateControllerHandle>& OutHandles) const
+	{
+		QueryRadius(Center,
+		            Radius,
+		            TStateControllerTraits<EnumType>::ControllerType,
+		            TStateController<EnumType>::ToMask(State),
+		            OutHandles);
+	}
+
+	template <typename EnumType>
+	void QueryBox(const FBox& Box, const EnumType State, TArray<FStateControllerHandle>& OutHandles) const
+	{
+		QueryBox(Box, TStateControllerTraits<EnumType>::ControllerType, TStateController<EnumType>::ToMask(State),
+		         OutHandles);
+	}
+
+	template <typename EnumType>
+	void QueryNearest(const FVector& Location,
+	                  const int32 Count,
+	                  const float MaxRadius,
+	                  const EnumType State,
+	                  TArray<FStateControllerHandle>& OutHandles) const
+	{
+		QueryNearest(Location,
+		             Count,
+		             MaxRadius,
+		             TStateControllerTraits<EnumType>::ControllerType,
+		             TStateController<EnumType>::ToMask(State),
+		             OutHandles);
+	}
+
+	int32 GetNumEntries() const { return Entries.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/**
+	 * Size of a spatial hash cell in cm.
+	 */
+	UPROPERTY(Config)
+	float CellSize = 2000.f;
+
+	struct FCellEntry
+	{
+		FStateControllerHandle Handle;
+
+		FVector Location = FVector::ZeroVector;
+	};
+
+	struct FEntry
+	{
+		FIntVector Cell = FIntVector::ZeroValue;
+
+		TWeakObjectPtr<USceneComponent> RootComponent = nullptr;
+
+		FDelegateHandle TransformUpdatedHandle;
+	};
+
+	TMap<FIntVector, TArray<FCellEntry>> Cells;
+
+	TMap<FStateControllerHandle, FEntry> Entries;
+
+	UPROPERTY()
+	UStateControllerRegistry* Registry = nullptr;
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	bool MatchesFilter(const FStateControllerHandle& Handle,
+	                   const EStateControllerType Type,
+	                   const uint8 StateMask) const;
+
+	/**
+	 * Calls Func for every entry in the cells between MinCell and MaxCell inclusive.
+	 */
+	template <typename FuncType>
+	void ForEachCellEntry(const FIntVector& MinCell, const FIntVector& MaxCell, FuncType&& Func) const;
+
+	void AddEntry(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void RemoveEntry(const FStateControllerHandle& Handle, UActorComponent* Controller);
+
+	void MoveEntry(const FStateControllerHandle& Handle, const FVector& NewLocation);
+
+	void HandleTransformUpdated(USceneComponent* UpdatedComponent,
+	                            EUpdateTransformFlags UpdateTransformFlags,
+	                            ETeleportType Teleport,
+	                            FStateControllerHandle Handle);
+};
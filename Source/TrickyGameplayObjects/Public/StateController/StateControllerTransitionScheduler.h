@@ -0,0 +1,120 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "StateControllerTypes.h"
+#include "StateControllerTransitionScheduler.generated.h"
+
+class UActorComponent;
+
+/**
+ * Finishes state controller transitions automatically after their TransitionDuration.
+ * All pending transitions are kept in a min-heap keyed by finish time and completed in a single pass per frame.
+ */
+UCLASS()
+class TRICKYGAMEPLAYOBJECTS_API UStateControllerTransitionScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerTransitionScheduler* Get(const UObject* WorldContextObject);
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Schedules finishing the transition of the given controller after Duration.
+	 * Reschedules the transition if it was already scheduled.
+	 *
+	 * @param RemainingTime If non-negative, the transition finishes after this time instead of Duration.
+	 * Used to resume a transition which was already in progress.
+	 */
+	void ScheduleTransition(UActorComponent* Controller,
+	                        const EStateControllerType Type,
+	                        const float Duration,
+	                        const float RemainingTime = -1.f);
+
+	/**
+	 * Re-keys the scheduled transition so it finishes after the time already spent in it.
+	 */
+	void ReverseTransition(UActorComponent* Controller);
+
+	/**
+	 * Removes the scheduled transition of the given controller if any.
+	 */
+	void CancelTransition(const UActorComponent* Controller);
+
+	bool IsTransitionScheduled(const UActorComponent* Controller) const;
+
+	/**
+	 * Returns the time left until the transition of the controller finishes or -1 if it isn't scheduled.
+	 */
+	float GetRemainingTime(const UActorComponent* Controller) const;
+
+	int32 GetNumScheduledTransitions() const { return ScheduledTransitions.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FScheduledTransition
+	{
+		double FinishTime = 0.0;
+
+		float Duration = 0.f;
+
+		uint32 Serial = 0;
+
+		EStateControllerType Type = EStateControllerType::Door;
+	};
+
+	struct FHeapEntry
+	{
+		double FinishTime = 0.0;
+
+		uint32 Serial = 0;
+
+		TObjectKey<UActorComponent> Key;
+
+		TWeakObjectPtr<UActorComponent> Controller = nullptr;
+	};
+
+	struct FHeapEntryPredicate
+	{
+		bool operator()(const FHeapEntry& A, const FHeapEntry& B) const
+		{
+			return A.FinishTime < B.FinishTime;
+		}
+	};
+
+	/**
+	 * Min-heap of pending completions. Rescheduled and cancelled entries are skipped lazily by serial mismatch
+	 * and compacted once they outnumber the scheduled transitions.
+	 */
+	TArray<FHeapEntry> Heap;
+
+	TMap<TObjectKey<UActorComponent>, FScheduledTransition> ScheduledTransitions;
+
+	uint32 NextSerial = 0;
+
+	double GetCurrentTime() const;
+
+	void PushEntry(UActorComponent* Controller, const FScheduledTransition& Transition);
+
+	bool IsStaleEntry(const FHeapEntry& Entry) const;
+
+	/**
+	 * Removes the stale entries from the heap if there are more of them than the scheduled transitions.
+	 */
+	void CompactHeap();
+
+	static void FinishTransition(UActorComponent* Controller, const EStateControllerType Type);
+};
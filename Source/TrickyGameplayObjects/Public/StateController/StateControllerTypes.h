@@ -0,0 +1,59 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Identifies the kind of a state controller component in the shared systems.
+ */
+enum class EStateControllerType : uint8
+{
+	Door,
+	Chest,
+	Lock,
+	Button,
+	GameplayObject,
+	Num
+};
+
+/**
+ * Stable handle of a state controller registered in UStateControllerRegistry.
+ */
+struct FStateControllerHandle
+{
+	FStateControllerHandle() = default;
+
+	FStateControllerHandle(const uint32 InIndex, const uint32 InSerial, const EStateControllerType InType)
+		: Index(InIndex), Serial(InSerial), Type(InType)
+	{
+	}
+
+	uint32 Index = 0;
+
+	/**
+	 * Zero means the handle was never registered.
+	 */
+	uint32 Serial = 0;
+
+	EStateControllerType Type = EStateControllerType::Door;
+
+	FORCEINLINE bool IsSet() const { return Serial != 0; }
+
+	FORCEINLINE void Reset() { *this = FStateControllerHandle(); }
+
+	FORCEINLINE bool operator==(const FStateControllerHandle& Other) const
+	{
+		return Index == Other.Index && Serial == Other.Serial && Type == Other.Type;
+	}
+
+	FORCEINLINE bool operator!=(const FStateControllerHandle& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend FORCEINLINE uint32 GetTypeHash(const FStateControllerHandle& Handle)
+	{
+		return HashCombine(HashCombine(Handle.Index, Handle.Serial), static_cast<uint32>(Handle.Type));
+	}
+};
@@ -0,0 +1,17 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+struct TRICKYGAMEPLAYOBJECTS_API FTrickyGameplayObjectsLog
+{
+	/**
+	 * Checks the TrickyGameplayObjects.VerboseLog console variable.
+	 * Messages about state changes, keys and pickups are formatted and logged only if it's enabled.
+	 * Warnings and errors are always logged.
+	 */
+	static bool IsVerboseLogEnabled();
+};
+#endif
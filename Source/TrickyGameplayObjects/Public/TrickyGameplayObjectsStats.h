@@ -0,0 +1,124 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "UObject/ScriptDelegates.h"
+
+DECLARE_STATS_GROUP(TEXT("TrickyGameplayObjects"), STATGROUP_TrickyGameplayObjects, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Door Transitions"),
+                                  STAT_DoorTransitions,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chest Transitions"),
+                                  STAT_ChestTransitions,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock Transitions"),
+                                  STAT_LockTransitions,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Button Transitions"),
+                                  STAT_ButtonTransitions,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Gameplay Object Transitions"),
+                                  STAT_GameplayObjectTransitions,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Delegate Broadcasts"),
+                                  STAT_DelegateBroadcasts,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Listener Invocations"),
+                                  STAT_ListenerInvocations,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pickup Activations"),
+                                  STAT_PickupActivations,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Failed Lock Attempts"),
+                                  STAT_FailedLockAttempts,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Keyring Lookups"),
+                                  STAT_KeyringLookups,
+                                  STATGROUP_TrickyGameplayObjects,
+                                  TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Change Current State"),
+                          STAT_ChangeCurrentState,
+                          STATGROUP_TrickyGameplayObjects,
+                          TRICKYGAMEPLAYOBJECTS_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Activate Pickup"),
+                          STAT_ActivatePickup,
+                          STATGROUP_TrickyGameplayObjects,
+                          TRICKYGAMEPLAYOBJECTS_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(TRICKYGAMEPLAYOBJECTS_API, TrickyGameplayObjects);
+
+/**
+ * Increments the STAT_<Name> counter and accumulates the <Name> stat of the TrickyGameplayObjects CSV category.
+ */
+#define TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_##Name, Amount); \
+	CSV_CUSTOM_STAT(TrickyGameplayObjects, Name, static_cast<int32>(Amount), ECsvCustomStatOp::Accumulate)
+
+/**
+ * Measures the scope with the STAT_<Name> cycle counter and the <Name> timing stat of the CSV category.
+ */
+#define TRICKY_GAMEPLAY_OBJECTS_SCOPE_CYCLE_COUNTER(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_##Name); \
+	CSV_SCOPED_TIMING_STAT(TrickyGameplayObjects, Name)
+
+struct TRICKYGAMEPLAYOBJECTS_API FTrickyGameplayObjectsStats
+{
+	/**
+	 * Checks if stats or a CSV capture are being collected, so the counters which aren't free can be skipped.
+	 */
+	static bool IsCollecting();
+
+	/**
+	 * Counts the broadcast and the listeners it's going to invoke.
+	 * Native multicast delegates don't expose their invocation lists, so only dynamic listeners are counted.
+	 */
+	template <typename DelegateType>
+	static void CountBroadcast(const DelegateType& Delegate)
+	{
+#if STATS || CSV_PROFILER
+		if (!Delegate.IsBound())
+		{
+			return;
+		}
+
+		TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(DelegateBroadcasts, 1);
+
+		if constexpr (std::is_base_of_v<FMulticastScriptDelegate, DelegateType>)
+		{
+			if (IsCollecting())
+			{
+				TRICKY_GAMEPLAY_OBJECTS_INC_COUNTER(ListenerInvocations, Delegate.GetAllObjects().Num());
+			}
+		}
+#endif
+	}
+};
+
+/**
+ * Broadcasts the delegate and counts it in the stats.
+ */
+#define TRICKY_GAMEPLAY_OBJECTS_BROADCAST(Delegate, ...) \
+	(FTrickyGameplayObjectsStats::CountBroadcast(Delegate), Delegate.Broadcast(__VA_ARGS__))
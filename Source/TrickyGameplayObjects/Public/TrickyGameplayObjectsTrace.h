@@ -0,0 +1,168 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Config.h"
+#include "StateController/StateController.h"
+
+/**
+ * Insights tracing is compiled out of Shipping builds unless the project defines TRICKY_GAMEPLAY_OBJECTS_TRACE_ENABLED.
+ * The events are emitted only while the TrickyGameplayObjects channel is enabled, e.g. with -trace=TrickyGameplayObjects.
+ */
+#ifndef TRICKY_GAMEPLAY_OBJECTS_TRACE_ENABLED
+#define TRICKY_GAMEPLAY_OBJECTS_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+#endif
+
+#if TRICKY_GAMEPLAY_OBJECTS_TRACE_ENABLED
+
+struct TRICKYGAMEPLAYOBJECTS_API FTrickyGameplayObjectsTrace
+{
+	static bool IsEnabled();
+
+	static void OutputStateChanged(const UObject* Controller,
+	                               const EStateControllerType ControllerType,
+	                               const UEnum* StateEnum,
+	                               const bool bReversed,
+	                               const uint8 LastState,
+	                               const uint8 CurrentState,
+	                               const uint8 TargetState,
+	                               const uint64 StartCycle);
+
+	static void OutputLockAttempt(const UObject* Lock, const UObject* Instigator, const bool bSucceeded);
+
+	static void OutputLockKeyUsed(const UObject* Keyring, const UClass* LockKey);
+
+	static void OutputPickupActivated(const UObject* Pickup,
+	                                  const UObject* Activator,
+	                                  const bool bSucceeded,
+	                                  const uint64 StartCycle);
+};
+
+/**
+ * Emits a state change event with the time spent broadcasting it when the scope ends.
+ * The states are read at the end of the scope.
+ */
+template <typename EnumType>
+struct TStateChangedTraceScope
+{
+	TStateChangedTraceScope(const UObject* InController,
+	                        const bool bInReversed,
+	                        const EnumType& InLastState,
+	                        const EnumType& InCurrentState,
+	                        const EnumType& InTargetState)
+		: Controller(InController),
+		  LastState(InLastState),
+		  CurrentState(InCurrentState),
+		  TargetState(InTargetState),
+		  bReversed(bInReversed),
+		  bEnabled(FTrickyGameplayObjectsTrace::IsEnabled())
+	{
+		StartCycle = bEnabled ? FPlatformTime::Cycles64() : 0;
+	}
+
+	~TStateChangedTraceScope()
+	{
+		if (!bEnabled)
+		{
+			return;
+		}
+
+		FTrickyGameplayObjectsTrace::OutputStateChanged(Controller,
+		                                                TStateControllerTraits<EnumType>::ControllerType,
+		                                                StaticEnum<EnumType>(),
+		                                                bReversed,
+		                                                static_cast<uint8>(LastState),
+		                                                static_cast<uint8>(CurrentState),
+		                                                static_cast<uint8>(TargetState),
+		                                                StartCycle);
+	}
+
+private:
+	const UObject* Controller = nullptr;
+
+	const EnumType& LastState;
+
+	const EnumType& CurrentState;
+
+	const EnumType& TargetState;
+
+	uint64 StartCycle = 0;
+
+	bool bReversed = false;
+
+	bool bEnabled = false;
+};
+
+/**
+ * Emits a pickup activation event with the time spent activating it when the scope ends.
+ */
+struct FPickupActivationTraceScope
+{
+	FPickupActivationTraceScope(const UObject* InPickup, const UObject* InActivator)
+		: Pickup(InPickup),
+		  Activator(InActivator),
+		  bEnabled(FTrickyGameplayObjectsTrace::IsEnabled())
+	{
+		StartCycle = bEnabled ? FPlatformTime::Cycles64() : 0;
+	}
+
+	~FPickupActivationTraceScope()
+	{
+		if (bEnabled)
+		{
+			FTrickyGameplayObjectsTrace::OutputPickupActivated(Pickup, Activator, bSucceeded, StartCycle);
+		}
+	}
+
+	bool bSucceeded = false;
+
+private:
+	const UObject* Pickup = nullptr;
+
+	const UObject* Activator = nullptr;
+
+	uint64 StartCycle = 0;
+
+	bool bEnabled = false;
+};
+
+#define TRACE_STATE_CONTROLLER_CHANGED_SCOPE(Controller, bReversed, LastState, CurrentState, TargetState) \
+	TStateChangedTraceScope<std::decay_t<decltype(CurrentState)>> StateChangedTraceScope( \
+		Controller, bReversed, LastState, CurrentState, TargetState)
+
+#define TRACE_LOCK_ATTEMPT(Lock, Instigator, bSucceeded) \
+	do \
+	{ \
+		if (FTrickyGameplayObjectsTrace::IsEnabled()) \
+		{ \
+			FTrickyGameplayObjectsTrace::OutputLockAttempt(Lock, Instigator, bSucceeded); \
+		} \
+	} \
+	while (0)
+
+#define TRACE_LOCK_KEY_USED(Keyring, LockKey) \
+	do \
+	{ \
+		if (FTrickyGameplayObjectsTrace::IsEnabled()) \
+		{ \
+			FTrickyGameplayObjectsTrace::OutputLockKeyUsed(Keyring, LockKey); \
+		} \
+	} \
+	while (0)
+
+#define TRACE_PICKUP_ACTIVATION_SCOPE(Pickup, Activator) \
+	FPickupActivationTraceScope PickupActivationTraceScope(Pickup, Activator)
+
+#define TRACE_PICKUP_ACTIVATION_SUCCEEDED() \
+	PickupActivationTraceScope.bSucceeded = true
+
+#else
+
+#define TRACE_STATE_CONTROLLER_CHANGED_SCOPE(Controller, bReversed, LastState, CurrentState, TargetState)
+#define TRACE_LOCK_ATTEMPT(Lock, Instigator, bSucceeded)
+#define TRACE_LOCK_KEY_USED(Keyring, LockKey)
+#define TRACE_PICKUP_ACTIVATION_SCOPE(Pickup, Activator)
+#define TRACE_PICKUP_ACTIVATION_SUCCEEDED()
+
+#endif
@@ -34,8 +34,13 @@ public class TrickyGameplayObjects : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
+				"AssetRegistry",
 				"CoreUObject",
 				"Engine",
+				"Json",
+				"NetCore",
+				"Projects",
+				"TraceLog",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
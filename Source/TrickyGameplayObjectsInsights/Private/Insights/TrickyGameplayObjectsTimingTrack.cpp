@@ -0,0 +1,291 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Insights/TrickyGameplayObjectsTimingTrack.h"
+
+#include "Insights/TrickyGameplayObjectsTraceProvider.h"
+#include "Insights/ViewModels/ITimingViewSession.h"
+#include "Insights/ViewModels/TimingEvent.h"
+#include "Insights/ViewModels/TimingEventSearch.h"
+#include "Insights/ViewModels/TimingTrackViewport.h"
+#include "Insights/ViewModels/TooltipDrawState.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+namespace TrickyGameplayObjectsTimingTrack
+{
+	constexpr uint32 StateChangedColor = 0xFF4A90D9;
+
+	constexpr uint32 ReversedColor = 0xFF9A6AD9;
+
+	constexpr uint32 SucceededColor = 0xFF4AB86A;
+
+	constexpr uint32 FailedColor = 0xFFD94A4A;
+
+	constexpr uint32 LockKeyUsedColor = 0xFFD9B84A;
+
+	constexpr int32 NumLanes = static_cast<int32>(ETrickyGameplayObjectsTraceEventKind::Num);
+
+	uint32 GetEventColor(const FTrickyGameplayObjectsTraceEvent& Event)
+	{
+		switch (Event.Kind)
+		{
+		case ETrickyGameplayObjectsTraceEventKind::StateChanged:
+			return Event.bFlag ? ReversedColor : StateChangedColor;
+
+		case ETrickyGameplayObjectsTraceEventKind::LockKeyUsed:
+			return LockKeyUsedColor;
+
+		default:
+			return Event.bFlag ? SucceededColor : FailedColor;
+		}
+	}
+
+	FString MakeEventLabel(const FTrickyGameplayObjectsTraceProvider& Provider,
+	                       const FTrickyGameplayObjectsTraceEvent& Event)
+	{
+		const TCHAR* ObjectName = Provider.GetObjectName(Event.ObjectId);
+		const TCHAR* OtherObjectName = Provider.GetObjectName(Event.OtherObjectId);
+
+		switch (Event.Kind)
+		{
+		case ETrickyGameplayObjectsTraceEventKind::StateChanged:
+			return FString::Printf(TEXT("%s%s: %s -> %s (Target: %s, Instigator: %s)"),
+			                       Event.bFlag ? TEXT("Reversed ") : TEXT(""),
+			                       ObjectName,
+			                       Provider.GetStateName(Event.ControllerType, Event.LastState),
+			                       Provider.GetStateName(Event.ControllerType, Event.CurrentState),
+			                       Provider.GetStateName(Event.ControllerType, Event.TargetState),
+			                       OtherObjectName);
+
+		case ETrickyGameplayObjectsTraceEventKind::LockAttempt:
+			return FString::Printf(TEXT("Lock attempt %s: %s by %s"),
+			                       Event.bFlag ? TEXT("succeeded") : TEXT("failed"),
+			                       ObjectName,
+			                       OtherObjectName);
+
+		case ETrickyGameplayObjectsTraceEventKind::LockKeyUsed:
+			return FString::Printf(TEXT("Lock key used: %s from %s"), OtherObjectName, ObjectName);
+
+		case ETrickyGameplayObjectsTraceEventKind::PickupActivated:
+			return FString::Printf(TEXT("Pickup activation %s: %s by %s"),
+			                       Event.bFlag ? TEXT("succeeded") : TEXT("failed"),
+			                       ObjectName,
+			                       OtherObjectName);
+
+		default:
+			return FString();
+		}
+	}
+
+	/**
+	 * Lanes are stacked in the order of the event kinds, every lane taking as many depths as it has nested events.
+	 */
+	void GetLaneFirstDepths(const FTrickyGameplayObjectsTraceProvider& Provider, uint32 (&OutFirstDepths)[NumLanes])
+	{
+		uint32 FirstDepth = 0;
+
+		for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+		{
+			OutFirstDepths[Lane] = FirstDepth;
+			FirstDepth += Provider.GetLaneNumDepths(static_cast<ETrickyGameplayObjectsTraceEventKind>(Lane));
+		}
+	}
+
+	/** The timing event type keeps the lane and the index of the event to find it again for the tooltip. */
+	uint64 MakeEventType(const int32 Lane, const int32 Index)
+	{
+		return static_cast<uint64>(Lane) << 32 | static_cast<uint32>(Index);
+	}
+}
+
+FTrickyGameplayObjectsTimingTrack::FTrickyGameplayObjectsTimingTrack(const TraceServices::IAnalysisSession& InSession)
+	: FTimingEventsTrack(TEXT("Tricky Gameplay Objects")),
+	  Session(InSession)
+{
+}
+
+void FTrickyGameplayObjectsTimingTrack::BuildDrawState(ITimingEventsTrackDrawStateBuilder& Builder,
+                                                       const ITimingTrackUpdateContext& Context)
+{
+	using namespace TrickyGameplayObjectsTimingTrack;
+
+	TraceServices::FAnalysisSessionReadScope ReadScope(Session);
+
+	const FTrickyGameplayObjectsTraceProvider* Provider = Session.ReadProvider<FTrickyGameplayObjectsTraceProvider>(
+		FTrickyGameplayObjectsTraceProvider::GetProviderName());
+
+	if (!Provider)
+	{
+		return;
+	}
+
+	const FTimingTrackViewport& Viewport = Context.GetViewport();
+	const double StartTime = Viewport.GetStartTime();
+	const double EndTime = Viewport.GetEndTime();
+	uint32 FirstDepths[NumLanes];
+	GetLaneFirstDepths(*Provider, FirstDepths);
+
+	for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+	{
+		const ETrickyGameplayObjectsTraceEventKind Kind = static_cast<ETrickyGameplayObjectsTraceEventKind>(Lane);
+
+		for (const FTrickyGameplayObjectsTraceEvent& Event : Provider->GetLaneEvents(Kind, StartTime, EndTime))
+		{
+			if (Event.EndTime < StartTime)
+			{
+				continue;
+			}
+
+			Builder.AddEvent(Event.StartTime,
+			                 Event.EndTime,
+			                 FirstDepths[Lane] + Event.Depth,
+			                 GetEventColor(Event),
+			                 [Provider, &Event](float) -> const FString
+			                 {
+				                 return MakeEventLabel(*Provider, Event);
+			                 });
+		}
+	}
+}
+
+const TSharedPtr<const ITimingEvent> FTrickyGameplayObjectsTimingTrack::SearchEvent(
+	const FTimingEventSearchParameters& InSearchParameters) const
+{
+	using namespace TrickyGameplayObjectsTimingTrack;
+
+	TraceServices::FAnalysisSessionReadScope ReadScope(Session);
+
+	const FTrickyGameplayObjectsTraceProvider* Provider = Session.ReadProvider<FTrickyGameplayObjectsTraceProvider>(
+		FTrickyGameplayObjectsTraceProvider::GetProviderName());
+
+	if (!Provider)
+	{
+		return nullptr;
+	}
+
+	uint32 FirstDepths[NumLanes];
+	GetLaneFirstDepths(*Provider, FirstDepths);
+
+	for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+	{
+		const ETrickyGameplayObjectsTraceEventKind Kind = static_cast<ETrickyGameplayObjectsTraceEventKind>(Lane);
+		const TConstArrayView<FTrickyGameplayObjectsTraceEvent> LaneEvents = Provider->GetLaneEvents(Kind);
+
+		for (const FTrickyGameplayObjectsTraceEvent& Event : Provider->GetLaneEvents(Kind,
+		                                                                             InSearchParameters.StartTime,
+		                                                                             InSearchParameters.EndTime))
+		{
+			const uint32 Depth = FirstDepths[Lane] + Event.Depth;
+
+			if (Event.EndTime < InSearchParameters.StartTime
+				|| (InSearchParameters.EventFilter
+					&& !InSearchParameters.EventFilter(Event.StartTime, Event.EndTime, Depth)))
+			{
+				continue;
+			}
+
+			const int32 Index = UE_PTRDIFF_TO_INT32(&Event - LaneEvents.GetData());
+			return MakeShared<FTimingEvent>(SharedThis(this),
+			                                Event.StartTime,
+			                                Event.EndTime,
+			                                Depth,
+			                                MakeEventType(Lane, Index));
+		}
+	}
+
+	return nullptr;
+}
+
+void FTrickyGameplayObjectsTimingTrack::InitTooltip(FTooltipDrawState& InOutTooltip,
+                                                    const ITimingEvent& InTooltipEvent) const
+{
+	if (!InTooltipEvent.CheckTrack(this) || !InTooltipEvent.Is<FTimingEvent>())
+	{
+		return;
+	}
+
+	TraceServices::FAnalysisSessionReadScope ReadScope(Session);
+
+	const FTrickyGameplayObjectsTraceProvider* Provider = Session.ReadProvider<FTrickyGameplayObjectsTraceProvider>(
+		FTrickyGameplayObjectsTraceProvider::GetProviderName());
+
+	if (!Provider)
+	{
+		return;
+	}
+
+	const uint64 Type = InTooltipEvent.As<FTimingEvent>().GetType();
+	const int32 Lane = static_cast<int32>(Type >> 32);
+	const int32 Index = static_cast<int32>(static_cast<uint32>(Type));
+
+	if (Lane >= TrickyGameplayObjectsTimingTrack::NumLanes)
+	{
+		return;
+	}
+
+	const TConstArrayView<FTrickyGameplayObjectsTraceEvent> LaneEvents = Provider->GetLaneEvents(
+		static_cast<ETrickyGameplayObjectsTraceEventKind>(Lane));
+
+	if (!LaneEvents.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	const FTrickyGameplayObjectsTraceEvent& Event = LaneEvents[Index];
+	InOutTooltip.ResetContent();
+	InOutTooltip.AddTitle(TrickyGameplayObjectsTimingTrack::MakeEventLabel(*Provider, Event));
+	InOutTooltip.AddNameValueTextLine(TEXT("Duration:"),
+	                                  FString::Printf(TEXT("%.3f ms"), (Event.EndTime - Event.StartTime) * 1000.0));
+	InOutTooltip.UpdateLayout();
+}
+
+void FTrickyGameplayObjectsTimingTrack::UpdateNumEvents()
+{
+	TraceServices::FAnalysisSessionReadScope ReadScope(Session);
+
+	const FTrickyGameplayObjectsTraceProvider* Provider = Session.ReadProvider<FTrickyGameplayObjectsTraceProvider>(
+		FTrickyGameplayObjectsTraceProvider::GetProviderName());
+	const int32 NewNumEvents = Provider ? Provider->GetNumEvents() : 0;
+
+	if (NewNumEvents != NumEvents)
+	{
+		NumEvents = NewNumEvents;
+		SetDirtyFlag();
+	}
+}
+
+void FTrickyGameplayObjectsTimingViewExtender::OnBeginSession(Insights::ITimingViewSession& InSession)
+{
+	Tracks.Remove(&InSession);
+}
+
+void FTrickyGameplayObjectsTimingViewExtender::OnEndSession(Insights::ITimingViewSession& InSession)
+{
+	Tracks.Remove(&InSession);
+}
+
+void FTrickyGameplayObjectsTimingViewExtender::Tick(Insights::ITimingViewSession& InSession,
+                                                    const TraceServices::IAnalysisSession& InAnalysisSession)
+{
+	TSharedPtr<FTrickyGameplayObjectsTimingTrack>& Track = Tracks.FindOrAdd(&InSession);
+
+	if (!Track.IsValid())
+	{
+		{
+			TraceServices::FAnalysisSessionReadScope ReadScope(InAnalysisSession);
+			const FTrickyGameplayObjectsTraceProvider* Provider = InAnalysisSession.ReadProvider<
+				FTrickyGameplayObjectsTraceProvider>(FTrickyGameplayObjectsTraceProvider::GetProviderName());
+
+			// Sessions without the channel enabled don't get an empty track.
+			if (!Provider || Provider->GetNumEvents() == 0)
+			{
+				return;
+			}
+		}
+
+		Track = MakeShared<FTrickyGameplayObjectsTimingTrack>(InAnalysisSession);
+		InSession.AddScrollableTrack(Track);
+	}
+
+	Track->UpdateNumEvents();
+}
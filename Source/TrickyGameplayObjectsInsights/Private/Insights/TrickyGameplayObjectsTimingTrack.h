@@ -0,0 +1,59 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Insights/ITimingViewExtender.h"
+#include "Insights/ViewModels/TimingEventsTrack.h"
+
+namespace TraceServices
+{
+	class IAnalysisSession;
+}
+
+/**
+ * Timing track which shows the TrickyGameplayObjects events.
+ * Every event kind has its own lane: state changes, lock attempts, lock key uses and pickup activations.
+ * Overlapping events of a lane are nested at the following depths. Labels are built only for the events wide enough
+ * to show them and for the tooltip.
+ */
+class FTrickyGameplayObjectsTimingTrack : public FTimingEventsTrack
+{
+public:
+	explicit FTrickyGameplayObjectsTimingTrack(const TraceServices::IAnalysisSession& InSession);
+
+	virtual void BuildDrawState(ITimingEventsTrackDrawStateBuilder& Builder,
+	                            const ITimingTrackUpdateContext& Context) override;
+
+	virtual const TSharedPtr<const ITimingEvent> SearchEvent(
+		const FTimingEventSearchParameters& InSearchParameters) const override;
+
+	virtual void InitTooltip(FTooltipDrawState& InOutTooltip, const ITimingEvent& InTooltipEvent) const override;
+
+	/**
+	 * Marks the track dirty if new events were analyzed since the last call.
+	 */
+	void UpdateNumEvents();
+
+private:
+	const TraceServices::IAnalysisSession& Session;
+
+	int32 NumEvents = 0;
+};
+
+/**
+ * Adds the TrickyGameplayObjects track to the timing view of every session which has the events.
+ */
+class FTrickyGameplayObjectsTimingViewExtender : public Insights::ITimingViewExtender
+{
+public:
+	virtual void OnBeginSession(Insights::ITimingViewSession& InSession) override;
+
+	virtual void OnEndSession(Insights::ITimingViewSession& InSession) override;
+
+	virtual void Tick(Insights::ITimingViewSession& InSession,
+	                  const TraceServices::IAnalysisSession& InAnalysisSession) override;
+
+private:
+	TMap<Insights::ITimingViewSession*, TSharedPtr<FTrickyGameplayObjectsTimingTrack>> Tracks;
+};
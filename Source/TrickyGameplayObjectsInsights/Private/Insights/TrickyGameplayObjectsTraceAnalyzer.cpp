@@ -0,0 +1,102 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Insights/TrickyGameplayObjectsTraceAnalyzer.h"
+
+#include "Insights/TrickyGameplayObjectsTraceProvider.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+FTrickyGameplayObjectsTraceAnalyzer::FTrickyGameplayObjectsTraceAnalyzer(
+	TraceServices::IAnalysisSession& InSession,
+	FTrickyGameplayObjectsTraceProvider& InProvider)
+	: Session(InSession),
+	  Provider(InProvider)
+{
+}
+
+void FTrickyGameplayObjectsTraceAnalyzer::OnAnalysisBegin(const FOnAnalysisContext& Context)
+{
+	FInterfaceBuilder& Builder = Context.InterfaceBuilder;
+	Builder.RouteEvent(RouteId_ObjectName, "TrickyGameplayObjects", "ObjectName");
+	Builder.RouteEvent(RouteId_StateName, "TrickyGameplayObjects", "StateName");
+	Builder.RouteEvent(RouteId_StateChanged, "TrickyGameplayObjects", "StateChanged");
+	Builder.RouteEvent(RouteId_LockAttempt, "TrickyGameplayObjects", "LockAttempt");
+	Builder.RouteEvent(RouteId_LockKeyUsed, "TrickyGameplayObjects", "LockKeyUsed");
+	Builder.RouteEvent(RouteId_PickupActivated, "TrickyGameplayObjects", "PickupActivated");
+}
+
+bool FTrickyGameplayObjectsTraceAnalyzer::OnEvent(const uint16 RouteId,
+                                                  EStyle Style,
+                                                  const FOnEventContext& Context)
+{
+	TraceServices::FAnalysisSessionEditScope EditScope(Session);
+
+	const FEventData& EventData = Context.EventData;
+	FTrickyGameplayObjectsTraceEvent Event;
+
+	switch (RouteId)
+	{
+	case RouteId_ObjectName:
+		{
+			FString Name;
+			EventData.GetString("Name", Name);
+			Provider.AddObjectName(EventData.GetValue<uint32>("Id"), MoveTemp(Name));
+			return true;
+		}
+
+	case RouteId_StateName:
+		{
+			FString Name;
+			EventData.GetString("Name", Name);
+			Provider.AddStateName(EventData.GetValue<uint8>("ControllerType"),
+			                      EventData.GetValue<uint8>("State"),
+			                      MoveTemp(Name));
+			return true;
+		}
+
+	case RouteId_StateChanged:
+		Event.Kind = ETrickyGameplayObjectsTraceEventKind::StateChanged;
+		Event.StartTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("StartCycle"));
+		Event.EndTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("EndCycle"));
+		Event.ObjectId = EventData.GetValue<uint32>("ControllerId");
+		Event.OtherObjectId = EventData.GetValue<uint32>("InstigatorId");
+		Event.ControllerType = EventData.GetValue<uint8>("ControllerType");
+		Event.LastState = EventData.GetValue<uint8>("LastState");
+		Event.CurrentState = EventData.GetValue<uint8>("CurrentState");
+		Event.TargetState = EventData.GetValue<uint8>("TargetState");
+		Event.bFlag = EventData.GetValue<bool>("bReversed");
+		break;
+
+	case RouteId_LockAttempt:
+		Event.Kind = ETrickyGameplayObjectsTraceEventKind::LockAttempt;
+		Event.StartTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("Cycle"));
+		Event.EndTime = Event.StartTime;
+		Event.ObjectId = EventData.GetValue<uint32>("LockId");
+		Event.OtherObjectId = EventData.GetValue<uint32>("InstigatorId");
+		Event.bFlag = EventData.GetValue<bool>("bSucceeded");
+		break;
+
+	case RouteId_LockKeyUsed:
+		Event.Kind = ETrickyGameplayObjectsTraceEventKind::LockKeyUsed;
+		Event.StartTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("Cycle"));
+		Event.EndTime = Event.StartTime;
+		Event.ObjectId = EventData.GetValue<uint32>("KeyringId");
+		Event.OtherObjectId = EventData.GetValue<uint32>("LockKeyId");
+		break;
+
+	case RouteId_PickupActivated:
+		Event.Kind = ETrickyGameplayObjectsTraceEventKind::PickupActivated;
+		Event.StartTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("StartCycle"));
+		Event.EndTime = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("EndCycle"));
+		Event.ObjectId = EventData.GetValue<uint32>("PickupId");
+		Event.OtherObjectId = EventData.GetValue<uint32>("ActivatorId");
+		Event.bFlag = EventData.GetValue<bool>("bSucceeded");
+		break;
+
+	default:
+		return true;
+	}
+
+	Provider.AddEvent(Event);
+	return true;
+}
@@ -0,0 +1,42 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Analyzer.h"
+
+class FTrickyGameplayObjectsTraceProvider;
+
+namespace TraceServices
+{
+	class IAnalysisSession;
+}
+
+/**
+ * Routes the events of the TrickyGameplayObjects trace channel into the provider.
+ */
+class FTrickyGameplayObjectsTraceAnalyzer : public UE::Trace::IAnalyzer
+{
+public:
+	FTrickyGameplayObjectsTraceAnalyzer(TraceServices::IAnalysisSession& InSession,
+	                                    FTrickyGameplayObjectsTraceProvider& InProvider);
+
+	virtual void OnAnalysisBegin(const FOnAnalysisContext& Context) override;
+
+	virtual bool OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context) override;
+
+private:
+	enum : uint16
+	{
+		RouteId_ObjectName,
+		RouteId_StateName,
+		RouteId_StateChanged,
+		RouteId_LockAttempt,
+		RouteId_LockKeyUsed,
+		RouteId_PickupActivated
+	};
+
+	TraceServices::IAnalysisSession& Session;
+
+	FTrickyGameplayObjectsTraceProvider& Provider;
+};
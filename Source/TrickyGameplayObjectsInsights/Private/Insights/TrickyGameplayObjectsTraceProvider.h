@@ -0,0 +1,197 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+/**
+ * Kinds of the events emitted to the TrickyGameplayObjects trace channel.
+ * Used as the lane of the event in the timing track.
+ */
+enum class ETrickyGameplayObjectsTraceEventKind : uint8
+{
+	StateChanged,
+	LockAttempt,
+	LockKeyUsed,
+	PickupActivated,
+	Num
+};
+
+struct FTrickyGameplayObjectsTraceEvent
+{
+	double StartTime = 0.0;
+
+	double EndTime = 0.0;
+
+	/** Controller, lock, keyring or pickup. */
+	uint32 ObjectId = 0;
+
+	/** Instigator, activator or lock key. */
+	uint32 OtherObjectId = 0;
+
+	ETrickyGameplayObjectsTraceEventKind Kind = ETrickyGameplayObjectsTraceEventKind::StateChanged;
+
+	uint8 ControllerType = 0;
+
+	uint8 LastState = 0;
+
+	uint8 CurrentState = 0;
+
+	uint8 TargetState = 0;
+
+	/** Reversed for state changes, succeeded for lock attempts and pickup activations. */
+	bool bFlag = false;
+
+	/** Depth inside the lane of the event, so overlapping events of different objects don't cover each other. */
+	uint16 Depth = 0;
+};
+
+/**
+ * Stores the analyzed TrickyGameplayObjects events of a trace session.
+ * Must be accessed inside an edit or read scope of the session.
+ */
+class FTrickyGameplayObjectsTraceProvider : public TraceServices::IProvider
+{
+public:
+	static FName GetProviderName()
+	{
+		static const FName ProviderName(TEXT("TrickyGameplayObjectsProvider"));
+		return ProviderName;
+	}
+
+	explicit FTrickyGameplayObjectsTraceProvider(TraceServices::IAnalysisSession& InSession)
+		: Session(InSession)
+	{
+	}
+
+	void AddObjectName(const uint32 Id, FString&& Name)
+	{
+		Session.WriteAccessCheck();
+		ObjectNames.Add(Id, MoveTemp(Name));
+	}
+
+	void AddStateName(const uint8 ControllerType, const uint8 State, FString&& Name)
+	{
+		Session.WriteAccessCheck();
+		StateNames.Add(MakeStateKey(ControllerType, State), MoveTemp(Name));
+	}
+
+	void AddEvent(FTrickyGameplayObjectsTraceEvent Event)
+	{
+		Session.WriteAccessCheck();
+		FLane& Lane = Lanes[static_cast<int32>(Event.Kind)];
+		Event.Depth = Lane.AllocateDepth(Event.StartTime, Event.EndTime);
+		Lane.MaxDuration = FMath::Max(Lane.MaxDuration, Event.EndTime - Event.StartTime);
+
+		// Events are analyzed in order per thread, so they are almost always appended.
+		const int32 Index = Algo::UpperBoundBy(Lane.Events,
+		                                       Event.StartTime,
+		                                       &FTrickyGameplayObjectsTraceEvent::StartTime);
+		Lane.Events.Insert(Event, Index);
+		++NumEvents;
+		Session.UpdateDurationSeconds(Event.EndTime);
+	}
+
+	/**
+	 * Events of the lane sorted by the start time.
+	 */
+	TConstArrayView<FTrickyGameplayObjectsTraceEvent> GetLaneEvents(
+		const ETrickyGameplayObjectsTraceEventKind Kind) const
+	{
+		Session.ReadAccessCheck();
+		return Lanes[static_cast<int32>(Kind)].Events;
+	}
+
+	/**
+	 * Returns the range of the lane events which can overlap the time interval.
+	 * Events inside the range which end before the interval still must be skipped.
+	 */
+	TConstArrayView<FTrickyGameplayObjectsTraceEvent> GetLaneEvents(const ETrickyGameplayObjectsTraceEventKind Kind,
+	                                                                 const double StartTime,
+	                                                                 const double EndTime) const
+	{
+		Session.ReadAccessCheck();
+		const FLane& Lane = Lanes[static_cast<int32>(Kind)];
+		const int32 FirstIndex = Algo::LowerBoundBy(Lane.Events,
+		                                            StartTime - Lane.MaxDuration,
+		                                            &FTrickyGameplayObjectsTraceEvent::StartTime);
+		const int32 LastIndex = Algo::UpperBoundBy(Lane.Events, EndTime, &FTrickyGameplayObjectsTraceEvent::StartTime);
+		return TConstArrayView<FTrickyGameplayObjectsTraceEvent>(Lane.Events).Slice(FirstIndex, LastIndex - FirstIndex);
+	}
+
+	int32 GetLaneNumDepths(const ETrickyGameplayObjectsTraceEventKind Kind) const
+	{
+		Session.ReadAccessCheck();
+		return Lanes[static_cast<int32>(Kind)].DepthEndTimes.Num();
+	}
+
+	int32 GetNumEvents() const
+	{
+		Session.ReadAccessCheck();
+		return NumEvents;
+	}
+
+	const TCHAR* GetObjectName(const uint32 Id) const
+	{
+		const FString* Name = ObjectNames.Find(Id);
+		return Name ? **Name : TEXT("None");
+	}
+
+	const TCHAR* GetStateName(const uint8 ControllerType, const uint8 State) const
+	{
+		const FString* Name = StateNames.Find(MakeStateKey(ControllerType, State));
+		return Name ? **Name : TEXT("Unknown");
+	}
+
+private:
+	struct FLane
+	{
+		TArray<FTrickyGameplayObjectsTraceEvent> Events;
+
+		/** End time of the last event at every depth. */
+		TArray<double> DepthEndTimes;
+
+		/** Bounds the binary search of the events which started before a time interval but can still overlap it. */
+		double MaxDuration = 0.0;
+
+		/**
+		 * Returns the first depth whose events all end before the start time. Events analyzed out of order get a new
+		 * depth more often than needed, but never overlap.
+		 */
+		uint16 AllocateDepth(const double StartTime, const double EndTime)
+		{
+			int32 Depth = DepthEndTimes.IndexOfByPredicate([StartTime](const double DepthEndTime)
+			{
+				return DepthEndTime < StartTime;
+			});
+
+			if (Depth == INDEX_NONE)
+			{
+				Depth = DepthEndTimes.Add(EndTime);
+			}
+			else
+			{
+				DepthEndTimes[Depth] = EndTime;
+			}
+
+			return static_cast<uint16>(Depth);
+		}
+	};
+
+	TraceServices::IAnalysisSession& Session;
+
+	FLane Lanes[static_cast<int32>(ETrickyGameplayObjectsTraceEventKind::Num)];
+
+	int32 NumEvents = 0;
+
+	TMap<uint32, FString> ObjectNames;
+
+	TMap<uint16, FString> StateNames;
+
+	static uint16 MakeStateKey(const uint8 ControllerType, const uint8 State)
+	{
+		return static_cast<uint16>(ControllerType) << 8 | State;
+	}
+};
@@ -0,0 +1,58 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#include "Features/IModularFeatures.h"
+#include "Insights/TrickyGameplayObjectsTimingTrack.h"
+#include "Insights/TrickyGameplayObjectsTraceAnalyzer.h"
+#include "Insights/TrickyGameplayObjectsTraceProvider.h"
+#include "Modules/ModuleManager.h"
+#include "TraceServices/ModuleService.h"
+
+/**
+ * Registers the analyzer and the provider of the TrickyGameplayObjects trace channel in every analysis session.
+ */
+class FTrickyGameplayObjectsTraceModule : public TraceServices::IModule
+{
+public:
+	virtual void GetModuleInfo(TraceServices::FModuleInfo& OutModuleInfo) override
+	{
+		static const FName ModuleName(TEXT("TrickyGameplayObjects"));
+		OutModuleInfo.Name = ModuleName;
+		OutModuleInfo.DisplayName = TEXT("Tricky Gameplay Objects");
+	}
+
+	virtual void OnAnalysisBegin(TraceServices::IAnalysisSession& Session) override
+	{
+		const TSharedPtr<FTrickyGameplayObjectsTraceProvider> Provider =
+			MakeShared<FTrickyGameplayObjectsTraceProvider>(Session);
+		Session.AddProvider(FTrickyGameplayObjectsTraceProvider::GetProviderName(), Provider);
+		Session.AddAnalyzer(new FTrickyGameplayObjectsTraceAnalyzer(Session, *Provider));
+	}
+
+	virtual void GetLoggers(TArray<const TCHAR*>& OutLoggers) override
+	{
+		OutLoggers.Add(TEXT("TrickyGameplayObjects"));
+	}
+};
+
+class FTrickyGameplayObjectsInsightsModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		IModularFeatures::Get().RegisterModularFeature(TraceServices::ModuleFeatureName, &TraceModule);
+		IModularFeatures::Get().RegisterModularFeature(Insights::TimingViewExtenderFeatureName, &TimingViewExtender);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		IModularFeatures::Get().UnregisterModularFeature(TraceServices::ModuleFeatureName, &TraceModule);
+		IModularFeatures::Get().UnregisterModularFeature(Insights::TimingViewExtenderFeatureName, &TimingViewExtender);
+	}
+
+private:
+	FTrickyGameplayObjectsTraceModule TraceModule;
+
+	FTrickyGameplayObjectsTimingViewExtender TimingViewExtender;
+};
+
+IMPLEMENT_MODULE(FTrickyGameplayObjectsInsightsModule, TrickyGameplayObjectsInsights)
@@ -0,0 +1,30 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+using UnrealBuildTool;
+
+public class TrickyGameplayObjectsInsights : ModuleRules
+{
+	public TrickyGameplayObjectsInsights(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core"
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"CoreUObject",
+				"Slate",
+				"SlateCore",
+				"TraceAnalysis",
+				"TraceInsights",
+				"TraceServices"
+			}
+			);
+	}
+}
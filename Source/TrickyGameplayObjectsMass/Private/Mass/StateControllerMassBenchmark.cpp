@@ -0,0 +1,120 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Benchmark/TrickyGameplayObjectsBenchmark.h"
+
+#if WITH_EDITOR || !UE_BUILD_SHIPPING
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "Mass/StateControllerMassBridge.h"
+#include "Mass/StateControllerMassProcessors.h"
+
+namespace StateControllerMassBenchmark
+{
+	constexpr int32 NumEntities = 100000;
+
+	/** Differs from the defaults of the door, so the promoted doors copy it from their entities. */
+	constexpr EDoorState InitialState = EDoorState::Opened;
+
+	constexpr float TransitionDuration = 2.5f;
+
+	/**
+	 * Demotes 100k doors to entities, changes their states with the door processor and promotes them back.
+	 */
+	void RunMassBenchmark(UWorld* World, const int32 NumObjects, TArray<FTrickyGameplayObjectsBenchmarkResult>& Results)
+	{
+		UStateControllerMassBridge* Bridge = UStateControllerMassBridge::Get(World);
+		UMassEntitySubsystem* EntitySubsystem = World->GetSubsystem<UMassEntitySubsystem>();
+
+		if (!Bridge || !EntitySubsystem)
+		{
+			return;
+		}
+
+		TArray<AActor*> Actors;
+		TArray<UActorComponent*> Doors;
+		Actors.Reserve(NumEntities);
+		Doors.Reserve(NumEntities);
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+
+		for (int32 Index = 0; Index < NumEntities; ++Index)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+			Actors.Add(Actor);
+
+			UDoorStateControllerComponent* Door = NewObject<UDoorStateControllerComponent>(Actor);
+			Door->SetInitialState(InitialState);
+			Door->SetTransitionDuration(TransitionDuration);
+			Actor->AddInstanceComponent(Door);
+			Door->RegisterComponent();
+			Doors.Add(Door);
+		}
+
+		const auto Measure = [&Results](const TCHAR* Name, auto&& Func)
+		{
+			FTrickyGameplayObjectsBenchmark::Measure(Results, Name, NumEntities, NumEntities, Func);
+		};
+
+		TArray<FMassEntityHandle> Entities;
+		Entities.Reserve(NumEntities);
+
+		Measure(TEXT("Mass Demotions"), [Bridge, &Doors, &Entities]
+		{
+			for (UActorComponent* Door : Doors)
+			{
+				Entities.Add(Bridge->DemoteController(Door));
+			}
+		});
+
+		const FStateControllerMassRequestFragment Request = FStateControllerMassRequestFragment::MakeChange(
+			InitialState, EDoorState::Closed, false);
+
+		Measure(TEXT("Mass Requests"), [Bridge, &Entities, &Request]
+		{
+			for (const FMassEntityHandle& Entity : Entities)
+			{
+				Bridge->SetEntityRequest(Entity, Request);
+			}
+		});
+
+		// The processor is run directly, so the requests are applied without waiting for the next frame.
+		UDoorStateMassProcessor* Processor = NewObject<UDoorStateMassProcessor>(GetTransientPackage());
+		Processor->CallInitialize(*World);
+		FMassProcessingContext ProcessingContext(EntitySubsystem->GetMutableEntityManager(), 0.f);
+
+		Measure(TEXT("Mass Door Processing"), [Processor, &ProcessingContext]
+		{
+			UE::Mass::Executor::Run(*Processor, ProcessingContext);
+		});
+
+		Measure(TEXT("Mass Promotions"), [Bridge, &Entities]
+		{
+			for (const FMassEntityHandle& Entity : Entities)
+			{
+				Bridge->PromoteEntity(Entity);
+			}
+		});
+
+		for (AActor* Actor : Actors)
+		{
+			Actor->Destroy();
+		}
+	}
+
+	struct FRegisterMassBenchmark
+	{
+		FRegisterMassBenchmark()
+		{
+			FTrickyGameplayObjectsBenchmark::OnRun().AddStatic(&RunMassBenchmark);
+		}
+	};
+
+	static FRegisterMassBenchmark RegisterMassBenchmark;
+}
+#endif
@@ -0,0 +1,698 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Mass/StateControllerMassBridge.h"
+
+#include "MassEntitySubsystem.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Button/ButtonStateControllerComponent.h"
+#include "Chest/ChestStateControllerComponent.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "GameplayObject/GameplayObjectStateControllerComponent.h"
+#include "StateController/StateControllerPersistenceSubsystem.h"
+#include "StateController/StateControllerTransitionScheduler.h"
+
+namespace StateControllerMassBridge
+{
+	template <typename FragmentType, typename FunctionType>
+	bool VisitFragment(FMassEntityManager& EntityManager, const FMassEntityHandle Entity, FunctionType& Function)
+	{
+		FragmentType* Fragment = EntityManager.GetFragmentDataPtr<FragmentType>(Entity);
+
+		if (!Fragment)
+		{
+			return false;
+		}
+
+		Function(*Fragment);
+		return true;
+	}
+
+	/**
+	 * Calls Function with the state fragment of the entity matching the type.
+	 *
+	 * @return False if the entity has no state fragment of the type.
+	 */
+	template <typename FunctionType>
+	bool VisitEntityStates(FMassEntityManager& EntityManager,
+	                       const FMassEntityHandle Entity,
+	                       const EStateControllerType Type,
+	                       FunctionType&& Function)
+	{
+		switch (Type)
+		{
+		case EStateControllerType::Door:
+			return VisitFragment<FDoorStateFragment>(EntityManager, Entity, Function);
+
+		case EStateControllerType::Chest:
+			return VisitFragment<FChestStateFragment>(EntityManager, Entity, Function);
+
+		case EStateControllerType::Button:
+			return VisitFragment<FButtonStateFragment>(EntityManager, Entity, Function);
+
+		case EStateControllerType::GameplayObject:
+			return VisitFragment<FGameplayObjectStateFragment>(EntityManager, Entity, Function);
+
+		default:
+			return false;
+		}
+	}
+
+	bool MakeSnapshotRecord(FMassEntityManager& EntityManager,
+	                        const FMassEntityHandle Entity,
+	                        const EStateControllerType Type,
+	                        const uint64 StableId,
+	                        FStateControllerSnapshotRecord& OutSnapshotRecord)
+	{
+		OutSnapshotRecord.Id = StableId;
+		OutSnapshotRecord.Type = Type;
+
+		return VisitEntityStates(EntityManager, Entity, Type, [&OutSnapshotRecord](const auto& State)
+		{
+			using EnumType = typename TDecay<decltype(State)>::Type::EnumType;
+
+			OutSnapshotRecord.InitialState = static_cast<uint8>(State.InitialState);
+			OutSnapshotRecord.CurrentState = static_cast<uint8>(State.CurrentState);
+			OutSnapshotRecord.TargetState = static_cast<uint8>(State.TargetState);
+			OutSnapshotRecord.LastState = static_cast<uint8>(State.LastState);
+
+			// Transitions without TransitionDuration aren't timed, same as for the components.
+			const bool bIsTimed = TStateController<EnumType>::IsTransition(State.CurrentState)
+				&& State.TransitionDuration > 0.f;
+			OutSnapshotRecord.TransitionTimeLeft = bIsTimed ? State.TransitionTimeLeft : -1.f;
+		});
+	}
+
+	bool ApplySnapshotRecord(FMassEntityManager& EntityManager,
+	                         const FMassEntityHandle Entity,
+	                         const FStateControllerSnapshotRecord& SnapshotRecord)
+	{
+		// A request made before restoring would be applied to the restored states.
+		if (FStateControllerMassRequestFragment* Request = EntityManager.GetFragmentDataPtr<
+			FStateControllerMassRequestFragment>(Entity))
+		{
+			*Request = FStateControllerMassRequestFragment();
+		}
+
+		return VisitEntityStates(EntityManager, Entity, SnapshotRecord.Type, [&SnapshotRecord](auto& State)
+		{
+			using EnumType = typename TDecay<decltype(State)>::Type::EnumType;
+
+			State.InitialState = static_cast<EnumType>(SnapshotRecord.InitialState);
+			State.CurrentState = static_cast<EnumType>(SnapshotRecord.CurrentState);
+			State.TargetState = static_cast<EnumType>(SnapshotRecord.TargetState);
+			State.LastState = static_cast<EnumType>(SnapshotRecord.LastState);
+			const bool bIsTimed = SnapshotRecord.TransitionTimeLeft >= 0.f;
+			State.TransitionTimeLeft = bIsTimed ? SnapshotRecord.TransitionTimeLeft : State.TransitionDuration;
+		});
+	}
+}
+
+UStateControllerMassBridge* UStateControllerMassBridge::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStateControllerMassBridge>() : nullptr;
+}
+
+void UStateControllerMassBridge::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UMassEntitySubsystem>();
+
+	if (UStateControllerSnapshotSubsystem* Snapshot = Collection.InitializeDependency<
+		UStateControllerSnapshotSubsystem>())
+	{
+		Snapshot->OnSavingControllers.AddUObject(this, &UStateControllerMassBridge::SaveEntities);
+		Snapshot->OnRestoringControllers.AddUObject(this, &UStateControllerMassBridge::RestoreEntities);
+	}
+
+	LevelRemovedHandle = FWorldDelegates::PreLevelRemovedFromWorld.AddUObject(
+		this, &UStateControllerMassBridge::HandleLevelRemoved);
+}
+
+void UStateControllerMassBridge::Deinitialize()
+{
+	if (UStateControllerSnapshotSubsystem* Snapshot = UStateControllerSnapshotSubsystem::Get(this))
+	{
+		Snapshot->OnSavingControllers.RemoveAll(this);
+		Snapshot->OnRestoringControllers.RemoveAll(this);
+	}
+
+	FWorldDelegates::PreLevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	LevelRemovedHandle.Reset();
+
+	Entities.Empty();
+	EntitiesByOwner.Empty();
+	DemotedEntities.Empty();
+	PromotedControllers.Empty();
+	DirtyEntities.Empty();
+	RemovedDirtyRecords.Empty();
+	OnControllerPromoted.Clear();
+	OnControllerDemoted.Clear();
+
+	Super::Deinitialize();
+}
+
+void UStateControllerMassBridge::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TArray<FVector> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
+
+	if (PlayerLocations.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FMassEntityHandle> EntitiesToPromote;
+	const int32 NumDemotedChecks = FMath::Min(MaxDistanceChecksPerFrame, DemotedEntities.Num());
+
+	for (int32 Check = 0; Check < NumDemotedChecks; ++Check)
+	{
+		DemotedCheckIndex = DemotedCheckIndex < DemotedEntities.Num() ? DemotedCheckIndex : 0;
+		const FMassEntityHandle Entity = DemotedEntities[DemotedCheckIndex++];
+		const FEntityRecord* Record = Entities.Find(Entity);
+
+		if (Record && IsNear(Record->Location, PlayerLocations, PromoteDistance))
+		{
+			EntitiesToPromote.Add(Entity);
+		}
+	}
+
+	TArray<UActorComponent*> ControllersToDemote;
+	const int32 NumPromotedChecks = FMath::Min(MaxDistanceChecksPerFrame, PromotedControllers.Num());
+
+	for (int32 Check = 0; Check < NumPromotedChecks; ++Check)
+	{
+		PromotedCheckIndex = PromotedCheckIndex < PromotedControllers.Num() ? PromotedCheckIndex : 0;
+		UActorComponent* Controller = PromotedControllers[PromotedCheckIndex].Get();
+		const AActor* Owner = IsValid(Controller) ? Controller->GetOwner() : nullptr;
+
+		if (!Owner)
+		{
+			PromotedControllers.RemoveAtSwap(PromotedCheckIndex);
+			continue;
+		}
+
+		++PromotedCheckIndex;
+
+		if (!IsNear(Owner->GetActorLocation(), PlayerLocations, DemoteDistance))
+		{
+			ControllersToDemote.Add(Controller);
+		}
+	}
+
+	for (UActorComponent* Controller : ControllersToDemote)
+	{
+		DemoteController(Controller);
+	}
+
+	for (const FMassEntityHandle& Entity : EntitiesToPromote)
+	{
+		if (UActorComponent* Controller = PromoteEntity(Entity))
+		{
+			PromotedControllers.Add(Controller);
+		}
+	}
+}
+
+bool UStateControllerMassBridge::IsTickable() const
+{
+	return bManageByPlayerDistance && (!DemotedEntities.IsEmpty() || !PromotedControllers.IsEmpty());
+}
+
+TStatId UStateControllerMassBridge::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStateControllerMassBridge, STATGROUP_Tickables);
+}
+
+FMassEntityHandle UStateControllerMassBridge::DemoteController(UActorComponent* Controller)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+
+	if (!EntityManager || !IsValid(Controller) || !Controller->GetOwner())
+	{
+		return FMassEntityHandle();
+	}
+
+	if (UDoorStateControllerComponent* Door = Cast<UDoorStateControllerComponent>(Controller))
+	{
+		return DemoteTypedController<UDoorStateControllerComponent, FDoorStateFragment>(
+			*EntityManager, Door, EStateControllerType::Door);
+	}
+
+	if (UChestStateControllerComponent* Chest = Cast<UChestStateControllerComponent>(Controller))
+	{
+		return DemoteTypedController<UChestStateControllerComponent, FChestStateFragment>(
+			*EntityManager, Chest, EStateControllerType::Chest);
+	}
+
+	if (UButtonStateControllerComponent* Button = Cast<UButtonStateControllerComponent>(Controller))
+	{
+		return DemoteTypedController<UButtonStateControllerComponent, FButtonStateFragment>(
+			*EntityManager, Button, EStateControllerType::Button);
+	}
+
+	if (UGameplayObjectStateControllerComponent* GameplayObject = Cast<UGameplayObjectStateControllerComponent>(
+		Controller))
+	{
+		return DemoteTypedController<UGameplayObjectStateControllerComponent, FGameplayObjectStateFragment>(
+			*EntityManager, GameplayObject, EStateControllerType::GameplayObject);
+	}
+
+	return FMassEntityHandle();
+}
+
+UActorComponent* UStateControllerMassBridge::PromoteEntity(const FMassEntityHandle Entity)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	const FEntityRecord* FoundRecord = Entities.Find(Entity);
+
+	if (!EntityManager || !FoundRecord)
+	{
+		return nullptr;
+	}
+
+	const FEntityRecord Record = *FoundRecord;
+	UActorComponent* Controller = nullptr;
+
+	if (EntityManager->IsEntityValid(Entity) && Record.Owner.IsValid())
+	{
+		switch (Record.Type)
+		{
+		case EStateControllerType::Door:
+			Controller = PromoteTypedEntity<UDoorStateControllerComponent, FDoorStateFragment>(
+				*EntityManager, Entity, Record);
+			break;
+
+		case EStateControllerType::Chest:
+			Controller = PromoteTypedEntity<UChestStateControllerComponent, FChestStateFragment>(
+				*EntityManager, Entity, Record);
+			break;
+
+		case EStateControllerType::Button:
+			Controller = PromoteTypedEntity<UButtonStateControllerComponent, FButtonStateFragment>(
+				*EntityManager, Entity, Record);
+			break;
+
+		case EStateControllerType::GameplayObject:
+			Controller = PromoteTypedEntity<UGameplayObjectStateControllerComponent, FGameplayObjectStateFragment>(
+				*EntityManager, Entity, Record);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	RemoveRecord(Entity);
+
+	if (EntityManager->IsEntityValid(Entity))
+	{
+		EntityManager->DestroyEntity(Entity);
+	}
+
+	if (Controller)
+	{
+		OnControllerPromoted.Broadcast(Record.Owner.Get(), Controller);
+	}
+
+	return Controller;
+}
+
+bool UStateControllerMassBridge::SetEntityRequest(const FMassEntityHandle Entity,
+                                                  const FStateControllerMassRequestFragment& Request)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+
+	if (!EntityManager || !EntityManager->IsEntityValid(Entity))
+	{
+		return false;
+	}
+
+	FStateControllerMassRequestFragment* PendingRequest = EntityManager->GetFragmentDataPtr<
+		FStateControllerMassRequestFragment>(Entity);
+
+	if (!PendingRequest)
+	{
+		return false;
+	}
+
+	*PendingRequest = Request;
+	MarkEntityDirty(Entity);
+	return true;
+}
+
+void UStateControllerMassBridge::GetEntitiesOfActor(const AActor* Owner, TArray<FMassEntityHandle>& OutEntities) const
+{
+	EntitiesByOwner.MultiFind(Owner, OutEntities);
+}
+
+bool UStateControllerMassBridge::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FMassEntityManager* UStateControllerMassBridge::GetEntityManager() const
+{
+	const UWorld* World = GetWorld();
+	UMassEntitySubsystem* EntitySubsystem = World ? World->GetSubsystem<UMassEntitySubsystem>() : nullptr;
+	return EntitySubsystem ? &EntitySubsystem->GetMutableEntityManager() : nullptr;
+}
+
+const FMassArchetypeHandle& UStateControllerMassBridge::GetArchetype(FMassEntityManager& EntityManager,
+                                                                     const EStateControllerType Type)
+{
+	FMassArchetypeHandle& Archetype = Archetypes[static_cast<uint8>(Type)];
+
+	if (Archetype.IsValid())
+	{
+		return Archetype;
+	}
+
+	const UScriptStruct* StateFragment = nullptr;
+
+	switch (Type)
+	{
+	case EStateControllerType::Door:
+		StateFragment = FDoorStateFragment::StaticStruct();
+		break;
+
+	case EStateControllerType::Chest:
+		StateFragment = FChestStateFragment::StaticStruct();
+		break;
+
+	case EStateControllerType::Button:
+		StateFragment = FButtonStateFragment::StaticStruct();
+		break;
+
+	case EStateControllerType::GameplayObject:
+		StateFragment = FGameplayObjectStateFragment::StaticStruct();
+		break;
+
+	default:
+		return Archetype;
+	}
+
+	const UScriptStruct* Fragments[] = {StateFragment, FStateControllerMassRequestFragment::StaticStruct()};
+	Archetype = EntityManager.CreateArchetype(Fragments);
+	return Archetype;
+}
+
+template <typename ComponentType, typename FragmentType>
+FMassEntityHandle UStateControllerMassBridge::DemoteTypedController(FMassEntityManager& EntityManager,
+                                                                    ComponentType* Controller,
+                                                                    const EStateControllerType Type)
+{
+	const FMassArchetypeHandle& Archetype = GetArchetype(EntityManager, Type);
+
+	if (!Archetype.IsValid())
+	{
+		return FMassEntityHandle();
+	}
+
+	AActor* Owner = Controller->GetOwner();
+	const FMassEntityHandle Entity = EntityManager.CreateEntity(Archetype);
+
+	FragmentType& Fragment = EntityManager.GetFragmentDataChecked<FragmentType>(Entity);
+	Fragment.InitialState = Controller->GetInitialState();
+	Fragment.CurrentState = Controller->GetCurrentState();
+	Fragment.TargetState = Controller->GetTargetState();
+	Fragment.LastState = Controller->GetLastState();
+	Fragment.TransitionDuration = Controller->GetTransitionDuration();
+
+	if (UStateControllerTransitionScheduler* Scheduler = UStateControllerTransitionScheduler::Get(Controller))
+	{
+		Fragment.TransitionTimeLeft = FMath::Max(Scheduler->GetRemainingTime(Controller), 0.f);
+		Scheduler->CancelTransition(Controller);
+	}
+
+	FEntityRecord& Record = Entities.Add(Entity);
+	Record.Owner = Owner;
+	Record.OwnerKey = Owner;
+	Record.Template = Cast<UActorComponent>(Controller->GetArchetype());
+	Record.ComponentClass = Controller->GetClass();
+	Record.ComponentName = Controller->GetFName();
+	Record.Type = Type;
+	Record.Location = Owner->GetActorLocation();
+	Record.StableId = UStateControllerSnapshotSubsystem::GetStableId(Controller);
+	Record.DemotedIndex = DemotedEntities.Add(Entity);
+
+	EntitiesByOwner.Add(Owner, Entity);
+	PromotedControllers.RemoveSwap(Controller);
+
+	Controller->DestroyComponent();
+
+	OnControllerDemoted.Broadcast(Owner, Entity);
+	return Entity;
+}
+
+template <typename ComponentType, typename FragmentType>
+ComponentType* UStateControllerMassBridge::PromoteTypedEntity(FMassEntityManager& EntityManager,
+                                                              const FMassEntityHandle Entity,
+                                                              const FEntityRecord& Record)
+{
+	const FragmentType* Fragment = EntityManager.GetFragmentDataPtr<FragmentType>(Entity);
+	AActor* Owner = Record.Owner.Get();
+	UClass* ComponentClass = Record.ComponentClass.Get();
+
+	if (!Fragment || !ComponentClass)
+	{
+		return nullptr;
+	}
+
+	// The destroyed component may still hold the original name until it's garbage collected.
+	const FName ComponentName = MakeUniqueObjectName(Owner, ComponentClass, Record.ComponentName);
+	UActorComponent* Template = Record.Template.Get();
+	Template = Template && Template->IsA(ComponentClass) ? Template : nullptr;
+	ComponentType* Controller = NewObject<ComponentType>(Owner, ComponentClass, ComponentName, RF_NoFlags, Template);
+	Controller->RestoreInitialState(Fragment->InitialState);
+	Controller->SetTransitionDuration(Fragment->TransitionDuration);
+	Owner->AddInstanceComponent(Controller);
+	Controller->RegisterComponent();
+	Controller->RestoreStates(Fragment->CurrentState,
+	                          Fragment->TargetState,
+	                          Fragment->LastState,
+	                          Fragment->TransitionTimeLeft);
+	return Controller;
+}
+
+void UStateControllerMassBridge::MarkEntityDirty(const FMassEntityHandle Entity)
+{
+	FEntityRecord* Record = Entities.Find(Entity);
+
+	if (!Record || Record->bIsDirty)
+	{
+		return;
+	}
+
+	Record->bIsDirty = true;
+	DirtyEntities.Add(Entity);
+}
+
+void UStateControllerMassBridge::ClearDirtyEntities()
+{
+	for (const FMassEntityHandle& Entity : DirtyEntities)
+	{
+		if (FEntityRecord* Record = Entities.Find(Entity))
+		{
+			Record->bIsDirty = false;
+		}
+	}
+
+	DirtyEntities.Reset();
+}
+
+void UStateControllerMassBridge::RemoveRecord(const FMassEntityHandle Entity)
+{
+	FEntityRecord Record;
+
+	if (!Entities.RemoveAndCopyValue(Entity, Record))
+	{
+		return;
+	}
+
+	if (Record.bIsDirty)
+	{
+		DirtyEntities.RemoveSingleSwap(Entity);
+
+		FMassEntityManager* EntityManager = GetEntityManager();
+		FStateControllerSnapshotRecord SnapshotRecord;
+
+		if (EntityManager && EntityManager->IsEntityValid(Entity)
+			&& StateControllerMassBridge::MakeSnapshotRecord(*EntityManager,
+			                                                 Entity,
+			                                                 Record.Type,
+			                                                 Record.StableId,
+			                                                 SnapshotRecord))
+		{
+			RemovedDirtyRecords.Add(SnapshotRecord);
+		}
+	}
+
+	EntitiesByOwner.RemoveSingle(Record.OwnerKey, Entity);
+
+	const int32 LastIndex = DemotedEntities.Num() - 1;
+
+	if (Record.DemotedIndex != LastIndex)
+	{
+		const FMassEntityHandle MovedEntity = DemotedEntities[LastIndex];
+		DemotedEntities[Record.DemotedIndex] = MovedEntity;
+		Entities.FindChecked(MovedEntity).DemotedIndex = Record.DemotedIndex;
+	}
+
+	DemotedEntities.Pop();
+}
+
+void UStateControllerMassBridge::SaveEntities(const bool bOnlyDirty, TArray<FStateControllerSnapshotRecord>& OutRecords)
+{
+	OutRecords.Append(RemovedDirtyRecords);
+	RemovedDirtyRecords.Reset();
+
+	if (FMassEntityManager* EntityManager = GetEntityManager())
+	{
+		const TArray<FMassEntityHandle>& EntitiesToSave = bOnlyDirty ? DirtyEntities : DemotedEntities;
+		OutRecords.Reserve(OutRecords.Num() + EntitiesToSave.Num());
+
+		for (const FMassEntityHandle& Entity : EntitiesToSave)
+		{
+			const FEntityRecord* Record = Entities.Find(Entity);
+			FStateControllerSnapshotRecord SnapshotRecord;
+
+			if (Record && EntityManager->IsEntityValid(Entity)
+				&& StateControllerMassBridge::MakeSnapshotRecord(*EntityManager,
+				                                                 Entity,
+				                                                 Record->Type,
+				                                                 Record->StableId,
+				                                                 SnapshotRecord))
+			{
+				OutRecords.Add(SnapshotRecord);
+			}
+		}
+	}
+
+	ClearDirtyEntities();
+}
+
+void UStateControllerMassBridge::RestoreEntities(TConstArrayView<FStateControllerSnapshotRecord> Records)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+
+	if (EntityManager && !Records.IsEmpty() && !Entities.IsEmpty())
+	{
+		TMap<uint64, FMassEntityHandle> EntitiesById;
+		EntitiesById.Reserve(Entities.Num());
+
+		for (const TPair<FMassEntityHandle, FEntityRecord>& Pair : Entities)
+		{
+			EntitiesById.Add(Pair.Value.StableId, Pair.Key);
+		}
+
+		for (const FStateControllerSnapshotRecord& SnapshotRecord : Records)
+		{
+			const FMassEntityHandle* Entity = EntitiesById.Find(SnapshotRecord.Id);
+
+			if (Entity && Entities.FindChecked(*Entity).Type == SnapshotRecord.Type
+				&& EntityManager->IsEntityValid(*Entity))
+			{
+				StateControllerMassBridge::ApplySnapshotRecord(*EntityManager, *Entity, SnapshotRecord);
+			}
+		}
+	}
+
+	// The restored states are already saved, the same as for the registered controllers.
+	ClearDirtyEntities();
+	RemovedDirtyRecords.Reset();
+}
+
+void UStateControllerMassBridge::HandleLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != GetWorld() || Entities.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FMassEntityHandle> StreamedOutEntities;
+
+	for (const TPair<FMassEntityHandle, FEntityRecord>& Pair : Entities)
+	{
+		const AActor* Owner = Pair.Value.Owner.Get();
+
+		if (Owner && Owner->GetLevel() == Level)
+		{
+			StreamedOutEntities.Add(Pair.Key);
+		}
+	}
+
+	FMassEntityManager* EntityManager = GetEntityManager();
+	UStateControllerPersistenceSubsystem* Persistence = UStateControllerPersistenceSubsystem::Get(this);
+
+	for (const FMassEntityHandle& Entity : StreamedOutEntities)
+	{
+		const bool bIsEntityValid = EntityManager && EntityManager->IsEntityValid(Entity);
+		const FEntityRecord& Record = Entities.FindChecked(Entity);
+		const uint64 StableId = Record.StableId;
+
+		auto StoreStates = [Persistence, StableId](const auto& State)
+		{
+			Persistence->StoreStates(StableId, State.CurrentState, State.TargetState, State.LastState);
+		};
+
+		// The owner is streamed in with the original component, which loads the stored states.
+		if (bIsEntityValid && Persistence)
+		{
+			StateControllerMassBridge::VisitEntityStates(*EntityManager, Entity, Record.Type, StoreStates);
+		}
+
+		RemoveRecord(Entity);
+
+		if (bIsEntityValid)
+		{
+			EntityManager->DestroyEntity(Entity);
+		}
+	}
+}
+
+void UStateControllerMassBridge::GetPlayerLocations(TArray<FVector>& OutLocations) const
+{
+	const UWorld* World = GetWorld();
+
+	if (!World)
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn)
+		{
+			OutLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+}
+
+bool UStateControllerMassBridge::IsNear(const FVector& Location,
+                                        const TArray<FVector>& PlayerLocations,
+                                        const float Distance)
+{
+	const float DistanceSquared = FMath::Square(Distance);
+
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		if (FVector::DistSquared(Location, PlayerLocation) <= DistanceSquared)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
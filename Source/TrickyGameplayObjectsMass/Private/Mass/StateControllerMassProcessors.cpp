@@ -0,0 +1,169 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Mass/StateControllerMassProcessors.h"
+
+#include "MassExecutionContext.h"
+#include "Mass/StateControllerMassFragments.h"
+
+namespace StateControllerMass
+{
+	template <typename FragmentType>
+	bool ChangeState(FragmentType& State,
+	                 const typename FragmentType::EnumType NewState,
+	                 const bool bTransitImmediately)
+	{
+		using FController = TStateController<typename FragmentType::EnumType>;
+
+		if (!FController::ChangeState(State.CurrentState,
+		                              State.TargetState,
+		                              State.LastState,
+		                              NewState,
+		                              bTransitImmediately))
+		{
+			return false;
+		}
+
+		State.TransitionTimeLeft = FController::IsTransition(State.CurrentState) ? State.TransitionDuration : 0.f;
+		return true;
+	}
+
+	template <typename FragmentType>
+	void ApplyRequest(FragmentType& State, const FStateControllerMassRequestFragment& Request)
+	{
+		using EnumType = typename FragmentType::EnumType;
+		using FController = TStateController<EnumType>;
+
+		switch (Request.Type)
+		{
+		case EStateControllerMassRequestType::ChangeState:
+			if (FController::ToMask(State.CurrentState) & Request.RequiredStateMask)
+			{
+				ChangeState(State, static_cast<EnumType>(Request.NewState), Request.bTransitImmediately);
+			}
+			break;
+
+		case EStateControllerMassRequestType::RestoreLastState:
+			if (FController::ToMask(State.CurrentState) & Request.RequiredStateMask)
+			{
+				ChangeState(State, State.LastState, Request.bTransitImmediately);
+			}
+			break;
+
+		case EStateControllerMassRequestType::FinishTransition:
+			if (FController::IsTransition(State.CurrentState))
+			{
+				ChangeState(State, State.TargetState, true);
+			}
+			break;
+
+		case EStateControllerMassRequestType::ReverseTransition:
+			if (FController::ReverseTransition(State.CurrentState, State.TargetState, State.LastState))
+			{
+				// Same as the scheduler, the reversed transition takes the time already spent in it.
+				State.TransitionTimeLeft = FMath::Max(State.TransitionDuration - State.TransitionTimeLeft, 0.f);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	template <typename FragmentType>
+	void ProcessChunk(FMassExecutionContext& Context)
+	{
+		using FController = TStateController<typename FragmentType::EnumType>;
+
+		const int32 NumEntities = Context.GetNumEntities();
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+		const TArrayView<FragmentType> States = Context.GetMutableFragmentView<FragmentType>();
+		const TArrayView<FStateControllerMassRequestFragment> Requests = Context.GetMutableFragmentView<
+			FStateControllerMassRequestFragment>();
+
+		for (int32 Index = 0; Index < NumEntities; ++Index)
+		{
+			FragmentType& State = States[Index];
+
+			// Timers are advanced before the requests, so transitions started this frame last the full duration.
+			if (FController::IsTransition(State.CurrentState) && State.TransitionDuration > 0.f)
+			{
+				State.TransitionTimeLeft -= DeltaTime;
+
+				if (State.TransitionTimeLeft <= 0.f)
+				{
+					ChangeState(State, State.TargetState, true);
+				}
+			}
+
+			FStateControllerMassRequestFragment& Request = Requests[Index];
+
+			if (Request.IsSet())
+			{
+				ApplyRequest(State, Request);
+				Request = FStateControllerMassRequestFragment();
+			}
+		}
+	}
+
+	template <typename FragmentType>
+	void ConfigureQuery(FMassEntityQuery& EntityQuery)
+	{
+		EntityQuery.AddRequirement<FragmentType>(EMassFragmentAccess::ReadWrite);
+		EntityQuery.AddRequirement<FStateControllerMassRequestFragment>(EMassFragmentAccess::ReadWrite);
+	}
+
+	template <typename FragmentType>
+	void Execute(FMassEntityQuery& EntityQuery, FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+	{
+		EntityQuery.ForEachEntityChunk(EntityManager, Context, &ProcessChunk<FragmentType>);
+	}
+}
+
+UStateControllerMassProcessorBase::UStateControllerMassProcessorBase()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+	bAutoRegisterWithProcessingPhases = true;
+}
+
+void UDoorStateMassProcessor::ConfigureQueries()
+{
+	StateControllerMass::ConfigureQuery<FDoorStateFragment>(EntityQuery);
+}
+
+void UDoorStateMassProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	StateControllerMass::Execute<FDoorStateFragment>(EntityQuery, EntityManager, Context);
+}
+
+void UChestStateMassProcessor::ConfigureQueries()
+{
+	StateControllerMass::ConfigureQuery<FChestStateFragment>(EntityQuery);
+}
+
+void UChestStateMassProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	StateControllerMass::Execute<FChestStateFragment>(EntityQuery, EntityManager, Context);
+}
+
+void UButtonStateMassProcessor::ConfigureQueries()
+{
+	StateControllerMass::ConfigureQuery<FButtonStateFragment>(EntityQuery);
+}
+
+void UButtonStateMassProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	StateControllerMass::Execute<FButtonStateFragment>(EntityQuery, EntityManager, Context);
+}
+
+void UGameplayObjectStateMassProcessor::ConfigureQueries()
+{
+	StateControllerMass::ConfigureQuery<FGameplayObjectStateFragment>(EntityQuery);
+}
+
+void UGameplayObjectStateMassProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	StateControllerMass::Execute<FGameplayObjectStateFragment>(EntityQuery, EntityManager, Context);
+}
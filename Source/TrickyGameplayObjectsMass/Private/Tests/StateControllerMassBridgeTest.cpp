@@ -0,0 +1,82 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+
+#include "Mass/StateControllerMassBridge.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+#include "Door/DoorStateControllerComponent.h"
+#include "Tests/TrickyGameplayObjectsTestWorld.h"
+
+namespace StateControllerMassBridgeTest
+{
+	constexpr int32 NumDoors = 16;
+
+	/** Differs from the defaults of the door, so the round trip notices if they're lost. */
+	constexpr EDoorState InitialState = EDoorState::Opened;
+
+	constexpr float TransitionDuration = 2.5f;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateControllerMassPromotionTest,
+                                 "TrickyGameplayObjects.Mass.PromotionRoundTrip",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Demotes doors to entities, promotes them back and checks that they kept their InitialState and TransitionDuration.
+ */
+bool FStateControllerMassPromotionTest::RunTest(const FString& Parameters)
+{
+	using namespace StateControllerMassBridgeTest;
+	using namespace TrickyGameplayObjectsTestWorld;
+
+	UWorld* World = CreateGameWorld();
+	UStateControllerMassBridge* Bridge = UStateControllerMassBridge::Get(World);
+
+	if (!TestNotNull(TEXT("Mass bridge"), Bridge))
+	{
+		DestroyGameWorld(World);
+		return false;
+	}
+
+	TArray<AActor*> Actors;
+	TArray<FMassEntityHandle> Entities;
+
+	for (int32 Index = 0; Index < NumDoors; ++Index)
+	{
+		AActor* Actor = World->SpawnActor<AActor>();
+		Actors.Add(Actor);
+
+		UDoorStateControllerComponent* Door = NewObject<UDoorStateControllerComponent>(Actor);
+		Door->SetInitialState(InitialState);
+		Door->SetTransitionDuration(TransitionDuration);
+		Actor->AddInstanceComponent(Door);
+		Door->RegisterComponent();
+		Entities.Add(Bridge->DemoteController(Door));
+	}
+
+	TestEqual(TEXT("Demoted controllers"), Bridge->GetNumDemotedControllers(), NumDoors);
+
+	for (const FMassEntityHandle& Entity : Entities)
+	{
+		const UDoorStateControllerComponent* Door = Cast<UDoorStateControllerComponent>(Bridge->PromoteEntity(Entity));
+
+		if (TestNotNull(TEXT("Promoted door"), Door))
+		{
+			TestTrue(TEXT("The promoted door keeps its InitialState and TransitionDuration"),
+			         Door->GetInitialState() == InitialState && Door->GetTransitionDuration() == TransitionDuration);
+		}
+	}
+
+	TestEqual(TEXT("Demoted controllers after the promotions"), Bridge->GetNumDemotedControllers(), 0);
+
+	for (AActor* Actor : Actors)
+	{
+		Actor->Destroy();
+	}
+
+	DestroyGameWorld(World);
+	return true;
+}
+#endif
@@ -0,0 +1,233 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityManager.h"
+#include "MassEntityTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "StateController/StateControllerSnapshotSubsystem.h"
+#include "StateController/StateControllerTypes.h"
+#include "Mass/StateControllerMassFragments.h"
+#include "StateControllerMassBridge.generated.h"
+
+class AActor;
+class UActorComponent;
+class ULevel;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStateControllerPromotedSignature, AActor*, UActorComponent*);
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStateControllerDemotedSignature, AActor*, FMassEntityHandle);
+
+/**
+ * Moves door, chest, button and gameplay object state controllers between components and Mass entities.
+ * A demoted controller is destroyed and its states live in a lightweight entity updated by the state processors.
+ * A promoted entity is turned back into a component on the same owner with the same states.
+ * The component is created from the archetype of the demoted one, so it has the same class defaults and template
+ * properties, and InitialState and TransitionDuration are restored from the entity.
+ * If bManageByPlayerDistance is true, demoted controllers are promoted when a player pawn gets close
+ * and demoted again when all the player pawns leave.
+ * The entities are saved and restored by UStateControllerSnapshotSubsystem under the stable ids of the demoted
+ * components. When the level of the owner is streamed out, the entity states are stored in
+ * UStateControllerPersistenceSubsystem, so the streamed in component loads them, and the entity is destroyed.
+ * @warning Demoted controllers aren't in UStateControllerRegistry and don't broadcast any events.
+ * Other per-instance property changes and all delegate bindings of the demoted component are lost,
+ * so owners must rebind in OnControllerPromoted.
+ */
+UCLASS(Config=Game)
+class TRICKYGAMEPLAYOBJECTSMASS_API UStateControllerMassBridge : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UStateControllerMassBridge* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Triggered after an entity was turned into a component. Owners should rebind to the new component here.
+	 */
+	FOnStateControllerPromotedSignature OnControllerPromoted;
+
+	/**
+	 * Triggered after a component was turned into an entity. The component is already destroyed.
+	 */
+	FOnStateControllerDemotedSignature OnControllerDemoted;
+
+	/**
+	 * Copies the states of the controller into a new entity and destroys the controller.
+	 *
+	 * @return Handle of the created entity, invalid if the controller type isn't supported.
+	 */
+	FMassEntityHandle DemoteController(UActorComponent* Controller);
+
+	/**
+	 * Creates the controller component on the owner of the entity, restores its states and destroys the entity.
+	 *
+	 * @return Created component or nullptr if the entity or its owner aren't valid anymore.
+	 */
+	UActorComponent* PromoteEntity(const FMassEntityHandle Entity);
+
+	/**
+	 * Sets the pending request of the entity. It replaces the previous request if it wasn't processed yet.
+	 */
+	bool SetEntityRequest(const FMassEntityHandle Entity, const FStateControllerMassRequestFragment& Request);
+
+	/**
+	 * Returns the state fragment of the entity or nullptr if the entity isn't of the given fragment type.
+	 */
+	template <typename FragmentType>
+	const FragmentType* GetEntityStates(const FMassEntityHandle Entity) const;
+
+	/**
+	 * Appends all the entities created for the controllers of the actor.
+	 */
+	void GetEntitiesOfActor(const AActor* Owner, TArray<FMassEntityHandle>& OutEntities) const;
+
+	int32 GetNumDemotedControllers() const { return Entities.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/**
+	 * Promotes and demotes controllers automatically depending on the distance to player pawns.
+	 */
+	UPROPERTY(Config)
+	bool bManageByPlayerDistance = false;
+
+	/**
+	 * Demoted controllers closer than this distance to a player pawn are promoted.
+	 */
+	UPROPERTY(Config)
+	float PromoteDistance = 3000.f;
+
+	/**
+	 * Promoted controllers further than this distance from all the player pawns are demoted.
+	 * Should be greater than PromoteDistance to avoid promoting and demoting the same controller every frame.
+	 */
+	UPROPERTY(Config)
+	float DemoteDistance = 4000.f;
+
+	/**
+	 * Max number of entities and components checked per frame.
+	 */
+	UPROPERTY(Config)
+	int32 MaxDistanceChecksPerFrame = 2048;
+
+	struct FEntityRecord
+	{
+		TWeakObjectPtr<AActor> Owner = nullptr;
+
+		/** Kept to remove the entity from EntitiesByOwner after the owner is destroyed. */
+		TObjectKey<AActor> OwnerKey;
+
+		/** Archetype of the demoted component which the promoted one is created from. */
+		TWeakObjectPtr<UActorComponent> Template = nullptr;
+
+		TSubclassOf<UActorComponent> ComponentClass = nullptr;
+
+		FName ComponentName = NAME_None;
+
+		EStateControllerType Type = EStateControllerType::Door;
+
+		FVector Location = FVector::ZeroVector;
+
+		/** Stable id of the demoted component, used by the snapshots and the persistence. */
+		uint64 StableId = 0;
+
+		/** Index in DemotedEntities. */
+		int32 DemotedIndex = INDEX_NONE;
+
+		/** If true, the states changed since the last snapshot save and the entity is in DirtyEntities. */
+		bool bIsDirty = false;
+	};
+
+	TMap<FMassEntityHandle, FEntityRecord> Entities;
+
+	TMultiMap<TObjectKey<AActor>, FMassEntityHandle> EntitiesByOwner;
+
+	/**
+	 * Demoted entities in the order of distance checks.
+	 */
+	TArray<FMassEntityHandle> DemotedEntities;
+
+	/**
+	 * Components which were promoted by the bridge and are demoted automatically.
+	 */
+	TArray<TWeakObjectPtr<UActorComponent>> PromotedControllers;
+
+	/**
+	 * Entities which got a request since the last snapshot save. Demoting doesn't change the states, and the changes
+	 * of the demoted component which weren't saved yet are kept by the snapshot subsystem.
+	 */
+	TArray<FMassEntityHandle> DirtyEntities;
+
+	/**
+	 * Final states of the dirty entities which were promoted or streamed out before the next snapshot save.
+	 */
+	TArray<FStateControllerSnapshotRecord> RemovedDirtyRecords;
+
+	FDelegateHandle LevelRemovedHandle;
+
+	int32 DemotedCheckIndex = 0;
+
+	int32 PromotedCheckIndex = 0;
+
+	FMassArchetypeHandle Archetypes[static_cast<uint8>(EStateControllerType::Num)];
+
+	FMassEntityManager* GetEntityManager() const;
+
+	const FMassArchetypeHandle& GetArchetype(FMassEntityManager& EntityManager, const EStateControllerType Type);
+
+	template <typename ComponentType, typename FragmentType>
+	FMassEntityHandle DemoteTypedController(FMassEntityManager& EntityManager,
+	                                        ComponentType* Controller,
+	                                        const EStateControllerType Type);
+
+	template <typename ComponentType, typename FragmentType>
+	ComponentType* PromoteTypedEntity(FMassEntityManager& EntityManager,
+	                                  const FMassEntityHandle Entity,
+	                                  const FEntityRecord& Record);
+
+	void MarkEntityDirty(const FMassEntityHandle Entity);
+
+	void ClearDirtyEntities();
+
+	/**
+	 * Keeps the final states of a dirty entity for the next snapshot save.
+	 */
+	void RemoveRecord(const FMassEntityHandle Entity);
+
+	void SaveEntities(const bool bOnlyDirty, TArray<FStateControllerSnapshotRecord>& OutRecords);
+
+	void RestoreEntities(TConstArrayView<FStateControllerSnapshotRecord> Records);
+
+	void HandleLevelRemoved(ULevel* Level, UWorld* World);
+
+	void GetPlayerLocations(TArray<FVector>& OutLocations) const;
+
+	static bool IsNear(const FVector& Location, const TArray<FVector>& PlayerLocations, const float Distance);
+};
+
+template <typename FragmentType>
+const FragmentType* UStateControllerMassBridge::GetEntityStates(const FMassEntityHandle Entity) const
+{
+	const FMassEntityManager* EntityManager = GetEntityManager();
+
+	if (!EntityManager || !EntityManager->IsEntityValid(Entity))
+	{
+		return nullptr;
+	}
+
+	return EntityManager->GetFragmentDataPtr<FragmentType>(Entity);
+}
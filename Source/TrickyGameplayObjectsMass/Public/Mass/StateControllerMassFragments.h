@@ -0,0 +1,232 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Button/ButtonInterface.h"
+#include "Chest/ChestInterface.h"
+#include "Door/DoorInterface.h"
+#include "GameplayObject/GameplayObjectInterface.h"
+#include "StateController/StateController.h"
+#include "StateControllerMassFragments.generated.h"
+
+UENUM()
+enum class EStateControllerMassRequestType : uint8
+{
+	None,
+	/** Changes CurrentState to NewState if CurrentState matches RequiredStateMask. */
+	ChangeState,
+	/** Changes CurrentState to LastState if CurrentState matches RequiredStateMask. */
+	RestoreLastState,
+	/** Changes CurrentState to TargetState immediately if CurrentState is Transition. */
+	FinishTransition,
+	/** Swaps TargetState with LastState if CurrentState is Transition. */
+	ReverseTransition
+};
+
+/**
+ * Pending state change of a state controller entity. Applied and cleared by the state processors once per frame.
+ * Use the Make functions to build the requests matching the interface functions of the components.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTSMASS_API FStateControllerMassRequestFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	EStateControllerMassRequestType Type = EStateControllerMassRequestType::None;
+
+	UPROPERTY()
+	uint8 RequiredStateMask = 0;
+
+	UPROPERTY()
+	uint8 NewState = 0;
+
+	UPROPERTY()
+	bool bTransitImmediately = false;
+
+	bool IsSet() const { return Type != EStateControllerMassRequestType::None; }
+
+	/**
+	 * Same as Open, Close, Lock, Press, etc. Changes CurrentState from RequiredState to NewState.
+	 */
+	template <typename EnumType>
+	static FStateControllerMassRequestFragment MakeChange(const EnumType RequiredState,
+	                                                      const EnumType NewState,
+	                                                      const bool bTransitImmediately)
+	{
+		return Make(EStateControllerMassRequestType::ChangeState,
+		            TStateController<EnumType>::ToMask(RequiredState),
+		            static_cast<uint8>(NewState),
+		            bTransitImmediately);
+	}
+
+	template <typename EnumType>
+	static FStateControllerMassRequestFragment MakeForce(const EnumType NewState, const bool bTransitImmediately)
+	{
+		return Make(EStateControllerMassRequestType::ChangeState,
+		            TStateTransitionTable<EnumType>::AllStatesMask,
+		            static_cast<uint8>(NewState),
+		            bTransitImmediately);
+	}
+
+	template <typename EnumType>
+	static FStateControllerMassRequestFragment MakeDisable(const bool bTransitImmediately)
+	{
+		return Make(EStateControllerMassRequestType::ChangeState,
+		            TStateTransitionTable<EnumType>::AllStatesMask & ~TStateController<EnumType>::ToMask(
+			            EnumType::Disabled),
+		            static_cast<uint8>(EnumType::Disabled),
+		            bTransitImmediately);
+	}
+
+	template <typename EnumType>
+	static FStateControllerMassRequestFragment MakeEnable(const bool bTransitImmediately)
+	{
+		return Make(EStateControllerMassRequestType::RestoreLastState,
+		            TStateController<EnumType>::ToMask(EnumType::Disabled),
+		            0,
+		            bTransitImmediately);
+	}
+
+	static FStateControllerMassRequestFragment MakeFinishTransition()
+	{
+		return Make(EStateControllerMassRequestType::FinishTransition, 0, 0, true);
+	}
+
+	static FStateControllerMassRequestFragment MakeReverseTransition()
+	{
+		return Make(EStateControllerMassRequestType::ReverseTransition, 0, 0, false);
+	}
+
+private:
+	static FStateControllerMassRequestFragment Make(const EStateControllerMassRequestType Type,
+	                                                const uint8 RequiredStateMask,
+	                                                const uint8 NewState,
+	                                                const bool bTransitImmediately)
+	{
+		FStateControllerMassRequestFragment Request;
+		Request.Type = Type;
+		Request.RequiredStateMask = RequiredStateMask;
+		Request.NewState = NewState;
+		Request.bTransitImmediately = bTransitImmediately;
+		return Request;
+	}
+};
+
+/**
+ * Mirrors the state properties of UDoorStateControllerComponent.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTSMASS_API FDoorStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	using EnumType = EDoorState;
+
+	UPROPERTY()
+	EDoorState InitialState = EDoorState::Closed;
+
+	UPROPERTY()
+	EDoorState CurrentState = EDoorState::Closed;
+
+	UPROPERTY()
+	EDoorState TargetState = EDoorState::Closed;
+
+	UPROPERTY()
+	EDoorState LastState = EDoorState::Closed;
+
+	UPROPERTY()
+	float TransitionDuration = 0.f;
+
+	UPROPERTY()
+	float TransitionTimeLeft = 0.f;
+};
+
+/**
+ * Mirrors the state properties of UChestStateControllerComponent.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTSMASS_API FChestStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	using EnumType = EChestState;
+
+	UPROPERTY()
+	EChestState InitialState = EChestState::Closed;
+
+	UPROPERTY()
+	EChestState CurrentState = EChestState::Closed;
+
+	UPROPERTY()
+	EChestState TargetState = EChestState::Closed;
+
+	UPROPERTY()
+	EChestState LastState = EChestState::Closed;
+
+	UPROPERTY()
+	float TransitionDuration = 0.f;
+
+	UPROPERTY()
+	float TransitionTimeLeft = 0.f;
+};
+
+/**
+ * Mirrors the state properties of UButtonStateControllerComponent.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTSMASS_API FButtonStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	using EnumType = EButtonState;
+
+	UPROPERTY()
+	EButtonState InitialState = EButtonState::Released;
+
+	UPROPERTY()
+	EButtonState CurrentState = EButtonState::Released;
+
+	UPROPERTY()
+	EButtonState TargetState = EButtonState::Released;
+
+	UPROPERTY()
+	EButtonState LastState = EButtonState::Released;
+
+	UPROPERTY()
+	float TransitionDuration = 0.f;
+
+	UPROPERTY()
+	float TransitionTimeLeft = 0.f;
+};
+
+/**
+ * Mirrors the state properties of UGameplayObjectStateControllerComponent.
+ */
+USTRUCT()
+struct TRICKYGAMEPLAYOBJECTSMASS_API FGameplayObjectStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	using EnumType = EGameplayObjectState;
+
+	UPROPERTY()
+	EGameplayObjectState InitialState = EGameplayObjectState::Active;
+
+	UPROPERTY()
+	EGameplayObjectState CurrentState = EGameplayObjectState::Active;
+
+	UPROPERTY()
+	EGameplayObjectState TargetState = EGameplayObjectState::Active;
+
+	UPROPERTY()
+	EGameplayObjectState LastState = EGameplayObjectState::Active;
+
+	UPROPERTY()
+	float TransitionDuration = 0.f;
+
+	UPROPERTY()
+	float TransitionTimeLeft = 0.f;
+};
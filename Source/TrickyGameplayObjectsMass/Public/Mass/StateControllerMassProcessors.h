@@ -0,0 +1,68 @@
+﻿// MIT License Copyright (c) Artyom "Tricky Fat Cat" Volkov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "StateControllerMassProcessors.generated.h"
+
+/**
+ * Base class of the processors which apply pending requests and finish timed transitions of state controller entities.
+ * Uses the same TStateController core as the components, so the state rules are identical.
+ */
+UCLASS(Abstract)
+class TRICKYGAMEPLAYOBJECTSMASS_API UStateControllerMassProcessorBase : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UStateControllerMassProcessorBase();
+
+protected:
+	FMassEntityQuery EntityQuery;
+};
+
+UCLASS()
+class TRICKYGAMEPLAYOBJECTSMASS_API UDoorStateMassProcessor : public UStateControllerMassProcessorBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void ConfigureQueries() override;
+
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+UCLASS()
+class TRICKYGAMEPLAYOBJECTSMASS_API UChestStateMassProcessor : public UStateControllerMassProcessorBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void ConfigureQueries() override;
+
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+UCLASS()
+class TRICKYGAMEPLAYOBJECTSMASS_API UButtonStateMassProcessor : public UStateControllerMassProcessorBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void ConfigureQueries() override;
+
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};
+
+UCLASS()
+class TRICKYGAMEPLAYOBJECTSMASS_API UGameplayObjectStateMassProcessor : public UStateControllerMassProcessorBase
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void ConfigureQueries() override;
+
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+};